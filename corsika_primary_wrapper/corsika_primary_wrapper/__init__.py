@@ -76,6 +76,7 @@ IWVL = 7
 
 ENERGY_LIMIT_OVERHEAD = 0.01
 PRIMARY_BYTES_FILENAME_IN_CORSIKA_RUN_DIR = "primary_bytes.5xf8_12xi4"
+IACT_OPTIONS_FILENAME_IN_CORSIKA_RUN_DIR = "iact_options.txt"
 
 
 def _overwrite_steering_card(
@@ -92,6 +93,28 @@ def _overwrite_steering_card(
     return "\n".join(lines)
 
 
+def _iact_options_to_card(iact_options):
+    """
+    Options for the iact.c of the CORSIKA-primary-mod, e.g.
+    {"ARENA_RAM_CAP_MIB": 512}. A value can be a list of values.
+    """
+    lines = []
+    for key in iact_options:
+        values = iact_options[key]
+        if not isinstance(values, (list, tuple)):
+            values = [values]
+        lines.append(" ".join([key] + [str(v) for v in values]))
+    return "\n".join(lines) + "\n"
+
+
+def _write_iact_options(corsika_run_dir, iact_options):
+    path = os.path.join(
+        corsika_run_dir, IACT_OPTIONS_FILENAME_IN_CORSIKA_RUN_DIR
+    )
+    with open(path, "wt") as f:
+        f.write(_iact_options_to_card(iact_options))
+
+
 def _primaries_to_bytes(primaries):
     with io.BytesIO() as f:
         for prm in primaries:
@@ -171,6 +194,7 @@ def corsika_primary(
         stdout_postfix=stdout_postfix,
         stderr_postfix=stderr_postfix,
         tmp_dir_prefix=tmp_dir_prefix,
+        iact_options=steering_dict.get("iact_options", {}),
     )
 
 
@@ -182,6 +206,7 @@ def explicit_corsika_primary(
     stdout_postfix=".stdout",
     stderr_postfix=".stderr",
     tmp_dir_prefix="corsika_primary_",
+    iact_options={},
 ):
     """
     Call CORSIKA-primary mod
@@ -198,6 +223,8 @@ def explicit_corsika_primary(
                         overwrite NSHOW in steering_card.
 
         output_path     Path to output tape-archive with Cherenkov-photons.
+
+        iact_options    Dictionary of options for the iact.c of the mod.
     """
     op = os.path
     corsika_path = op.abspath(corsika_path)
@@ -222,6 +249,7 @@ def explicit_corsika_primary(
         )
         with open(primary_path, "wb") as f:
             f.write(primary_bytes)
+        _write_iact_options(tmp_corsika_run_dir, iact_options)
 
         steering_card = _overwrite_steering_card(
             steering_card=steering_card,
@@ -254,12 +282,236 @@ EVTH_MARKER_FLOAT32 = struct.unpack("f", "EVTH".encode())[0]
 TARIO_RUNH_FILENAME = "runh.float32"
 TARIO_EVTH_FILENAME = "{:09d}.evth.float32"
 TARIO_BUNCHES_FILENAME = "{:09d}.cherenkov_bunches.Nx8_float32"
+TARIO_BUNCHES_CHUNK_FILENAME = "{:09d}.cherenkov_bunches.{:06d}.Nx8_float32"
+TARIO_INDEX_FILENAME = "event_index.int64"
+TARIO_CUT_STATISTICS_FILENAME = "{:09d}.cut_statistics.5x4_float64"
+TARIO_TELESCOPES_FILENAME = "telescopes.Nx4_float64"
+TARIO_TELESCOPE_BUNCHES_FILENAME = (
+    "{:09d}.telescope_bunches.{:02d}.{:06d}.Nx8_float32"
+)
+TARIO_REUSE_BUNCHES_FILENAME = "{:09d}.reuse_bunches.{:02d}.Nx8_float32"
+TARIO_HISTOGRAM_FILENAME = "{:09d}.histogram_{:s}.{:s}_float64"
+TARIO_SUMMARY_FILENAME = "{:09d}.summary.float64"
+TARIO_MERGE_STATISTICS_FILENAME = "{:09d}.merge_statistics.2_float64"
+TARIO_IMPORTANCE_STATISTICS_FILENAME = "{:09d}.importance_statistics.4_float64"
+TARIO_PARTICLES_FILENAME = "{:09d}.particles.Nx{:d}_float32"
+TARIO_LONGITUDINAL_FILENAME = "{:09d}.longitudinal.float64"
+
+ROI_CUTS = [
+    "ROI_DISC_CM",
+    "ROI_RECTANGLE_CM",
+    "ROI_MAX_INCIDENT_DEG",
+    "ROI_WAVELENGTH_NM",
+    "ROI_TIME_WINDOW_NS",
+]
+ROI_STATISTICS = [
+    "num_bunches",
+    "num_bunches_rejected",
+    "num_photons",
+    "num_photons_rejected",
+]
+IMPORTANCE_STATISTICS = [
+    "num_bunches",
+    "num_bunches_kept",
+    "num_photons",
+    "num_photons_kept",
+]
+HISTOGRAMS = ["xy", "r", "time", "wavelength"]
+SUMMARY = [
+    "num_bunches",
+    "num_photons",
+    "x_min_cm",
+    "x_max_cm",
+    "y_min_cm",
+    "y_max_cm",
+    "x_mean_cm",
+    "x_std_cm",
+    "y_mean_cm",
+    "y_std_cm",
+    "xy_cov_cm2",
+    "cx_mean_rad",
+    "cx_std_rad",
+    "cy_mean_rad",
+    "cy_std_rad",
+    "time_min_ns",
+    "time_max_ns",
+    "time_mean_ns",
+    "time_std_ns",
+    "emission_height_p05_cm",
+    "emission_height_p16_cm",
+    "emission_height_p50_cm",
+    "emission_height_p84_cm",
+    "emission_height_p95_cm",
+]
+
+
+def _decompress(name, payload):
+    """
+    Decompress the payload of a tar-member based on the postfix of its name.
+    """
+    if name.endswith(".zst"):
+        import zstandard
+
+        return zstandard.ZstdDecompressor().decompressobj().decompress(payload)
+    elif name.endswith(".lz4"):
+        import lz4.frame
+
+        return lz4.frame.decompress(payload)
+    else:
+        return payload
+
+
+COMPRESSION_SUFFIXES = [".zst", ".lz4"]
+BUNCHCODEC_SUFFIX = ".bunchcodec"
+BUNCHCODEC_MAGIC = 0x31434342
+BUNCHCODEC_HEADER_SIZE = 16
+
+
+def bunchcodec_decode(payload):
+    """
+    Returns the Cherenkov-bunches (N x 8, float32) from the blocks written
+    by resources/bunchcodec.h. Each block has a header
+    [uint32 magic, uint32 delta_mask, uint64 num_bunches] followed by
+    8 columns x 4 byte-planes x num_bunches. Delta-encoded columns are
+    integrated modulo 2**32 on the float32's bit-pattern.
+    """
+    blocks = []
+    pos = 0
+    while pos < len(payload):
+        magic, delta_mask, num = struct.unpack_from("<IIQ", payload, pos)
+        assert magic == BUNCHCODEC_MAGIC
+        pos += BUNCHCODEC_HEADER_SIZE
+        planes = np.frombuffer(
+            payload, dtype=np.uint8, count=32 * num, offset=pos
+        ).reshape((8, 4, num))
+        pos += 32 * num
+        words = np.zeros(shape=(8, num), dtype=np.uint32)
+        for b in range(4):
+            words |= planes[:, b, :].astype(np.uint32) << np.uint32(8 * b)
+        for c in range(8):
+            if (delta_mask >> c) & 1:
+                words[c] = np.cumsum(words[c], dtype=np.uint32)
+        blocks.append(words.T.copy().view(np.float32))
+    if len(blocks) == 0:
+        return np.zeros(shape=(0, 8), dtype=np.float32)
+    return np.concatenate(blocks)
+
+
+COMPACT_SUFFIX = ".compact"
+COMPACT_MAGIC = 0x31544350
+COMPACT_CONSTANT = 0
+COMPACT_INT16 = 1
+COMPACT_INT32 = 2
+COMPACT_FLOAT16 = 3
+COMPACT_FLOAT32 = 4
+COMPACT_DTYPES = {
+    COMPACT_INT16: np.int16,
+    COMPACT_INT32: np.int32,
+    COMPACT_FLOAT16: np.float16,
+    COMPACT_FLOAT32: np.float32,
+}
+
+
+def compact_decode(payload):
+    """
+    Returns the Cherenkov-bunches (N x 8, float32), and the maximum
+    quantisation-error of each column (8, float64) from the compact format
+    written by iact.c with COMPACT_BUNCHES. See iact.c for the layout.
+    """
+    magic, num_columns, num = struct.unpack_from("<IIQ", payload, 0)
+    assert magic == COMPACT_MAGIC
+    assert num_columns == 8
+    pos = 16
+    columns = []
+    for c in range(num_columns):
+        mode, _, origin, resolution = struct.unpack_from(
+            "<IIdd", payload, pos
+        )
+        columns.append((mode, origin, resolution))
+        pos += 24
+    bunches = np.zeros(shape=(num, num_columns), dtype=np.float32)
+    for c, (mode, origin, resolution) in enumerate(columns):
+        if mode == COMPACT_CONSTANT:
+            bunches[:, c] = origin
+            continue
+        dtype = np.dtype(COMPACT_DTYPES[mode])
+        values = np.frombuffer(payload, dtype=dtype, count=num, offset=pos)
+        pos += num * dtype.itemsize
+        pos += (8 - (num * dtype.itemsize) % 8) % 8
+        if mode in [COMPACT_INT16, COMPACT_INT32]:
+            bunches[:, c] = origin + values.astype(np.float64) * resolution
+        elif mode == COMPACT_FLOAT16:
+            bunches[:, c] = origin + values.astype(np.float32)
+        else:
+            bunches[:, c] = values
+    max_error = np.frombuffer(
+        payload, dtype=np.float64, count=num_columns, offset=pos
+    )
+    return bunches, max_error
+
+
+def _decode_bunches(name, payload):
+    """
+    Returns the Cherenkov-bunches (N x 8, float32) of a tar-member based on
+    the postfixes of its name.
+    """
+    raw = _decompress(name=name, payload=payload)
+    for suffix in COMPRESSION_SUFFIXES:
+        if name.endswith(suffix):
+            name = name[: -len(suffix)]
+    if name.endswith(BUNCHCODEC_SUFFIX):
+        return bunchcodec_decode(raw)
+    if name.endswith(COMPACT_SUFFIX):
+        bunches, _ = compact_decode(raw)
+        return bunches
+    bunches = np.frombuffer(raw, dtype=np.float32)
+    num_bunches = bunches.shape[0] // (8)
+    return np.reshape(bunches, (num_bunches, 8))
+
+
+def _is_evth(name):
+    return name.endswith(".evth.float32")
+
+
+def _is_bunches_of(name, event_number):
+    """
+    True when name is a member with bunches of this event. The bunches of
+    an event are either in one member, or split into chunks, see the
+    iact-option BUNCH_CHUNK_MIB.
+    """
+    return (
+        name[0:10] == "{:09d}.".format(event_number)
+        and ".cherenkov_bunches." in name
+    )
+
+
+def _fixed_size_blocks(pieces, num_bunches_per_block):
+    """
+    Yields the bunches in pieces in blocks of num_bunches_per_block. Only
+    the last block can have fewer bunches.
+    """
+    carry = []
+    num_carry = 0
+    for piece in pieces:
+        while piece.shape[0] > 0:
+            n = min(num_bunches_per_block - num_carry, piece.shape[0])
+            carry.append(piece[0:n])
+            num_carry += n
+            piece = piece[n:]
+            if num_carry == num_bunches_per_block:
+                yield np.concatenate(carry)
+                carry = []
+                num_carry = 0
+    if num_carry > 0:
+        yield np.concatenate(carry)
 
 
 class Tario:
     def __init__(self, path):
         self.path = path
         self.tar = tarfile.open(path, "r|*")
+        self._lookahead = None
+        self._end = False
 
         runh_tar = self.tar.next()
         runh_bin = self.tar.extractfile(runh_tar).read()
@@ -267,8 +519,24 @@ class Tario:
         assert self.runh[0] == RUNH_MARKER_FLOAT32
         self.num_events_read = 0
 
-    def __next__(self):
-        evth_tar = self.tar.next()
+    def _next_member(self):
+        if self._lookahead is not None:
+            member = self._lookahead
+            self._lookahead = None
+            return member
+        if self._end:
+            return None
+        member = self.tar.next()
+        self._end = member is None
+        return member
+
+    def _next_evth(self):
+        evth_tar = self._next_member()
+        # Other members of the last event, e.g. its cut-statistics, are skipped
+        while evth_tar is not None and not _is_evth(evth_tar.name):
+            if evth_tar.name == TARIO_INDEX_FILENAME:
+                raise StopIteration
+            evth_tar = self._next_member()
         if evth_tar is None:
             raise StopIteration
         evth_number = int(evth_tar.name[0:9])
@@ -276,16 +544,45 @@ class Tario:
         evth = np.frombuffer(evth_bin, dtype=np.float32)
         assert evth[0] == EVTH_MARKER_FLOAT32
         assert int(np.round(evth[1])) == evth_number
+        return evth
+
+    def _bunch_pieces(self, event_number, num_bytes_per_read=-1):
+        """
+        Yields the bunches of the event member by member. Raw bunches are
+        read in pieces of num_bytes_per_read. Stops at the first member which
+        does not belong to the event, and keeps it for the next event.
+        """
+        num_members = 0
+        while True:
+            member = self._next_member()
+            if member is None or not _is_bunches_of(member.name, event_number):
+                self._lookahead = member
+                break
+            num_members += 1
+            f = self.tar.extractfile(member)
+            if member.name.endswith(".Nx8_float32"):
+                while True:
+                    raw = f.read(num_bytes_per_read)
+                    if len(raw) == 0:
+                        break
+                    yield np.frombuffer(raw, dtype=np.float32).reshape((-1, 8))
+            else:
+                yield _decode_bunches(name=member.name, payload=f.read())
+        assert num_members > 0, "Expected bunches of event."
 
-        bunches_tar = self.tar.next()
-        bunches_number = int(bunches_tar.name[0:9])
-        assert evth_number == bunches_number
-        bunches_bin = self.tar.extractfile(bunches_tar).read()
-        bunches = np.frombuffer(bunches_bin, dtype=np.float32)
-        num_bunches = bunches.shape[0] // (8)
+    def __next__(self):
+        evth = self._next_evth()
+        event_number = int(np.round(evth[1]))
+        pieces = list(self._bunch_pieces(event_number))
+        if len(pieces) == 1:
+            bunches = pieces[0]
+        elif len(pieces) == 0:
+            bunches = np.zeros(shape=(0, 8), dtype=np.float32)
+        else:
+            bunches = np.concatenate(pieces)
 
         self.num_events_read += 1
-        return (evth, np.reshape(bunches, newshape=(num_bunches, 8)))
+        return (evth, bunches)
 
     def __iter__(self):
         return self
@@ -300,6 +597,466 @@ class Tario:
         return out
 
 
+class BlockTario(Tario):
+    """
+    Like Tario, but iterating yields (evth, blocks), where blocks yields the
+    event's bunches in arrays of num_bunches_per_block x 8. Raw bunches are
+    read block by block, encoded members one at a time. With the iact-option
+    BUNCH_CHUNK_MIB, the memory needed does not depend on the size of the
+    shower. Blocks not read before the next event are skipped.
+    """
+
+    def __init__(self, path, num_bunches_per_block=2 ** 20):
+        super().__init__(path=path)
+        self.num_bunches_per_block = int(num_bunches_per_block)
+        assert self.num_bunches_per_block > 0
+        self._pieces = None
+
+    def __next__(self):
+        if self._pieces is not None:
+            for _ in self._pieces:
+                pass
+        evth = self._next_evth()
+        event_number = int(np.round(evth[1]))
+        self._pieces = self._bunch_pieces(
+            event_number=event_number,
+            num_bytes_per_read=32 * self.num_bunches_per_block,
+        )
+        blocks = _fixed_size_blocks(
+            pieces=self._pieces,
+            num_bunches_per_block=self.num_bunches_per_block,
+        )
+        self.num_events_read += 1
+        return (evth, blocks)
+
+
+class TelescopeTario(Tario):
+    """
+    Reads the tar of the CORSIKA-primary-mod with TELESCOPE cards. The
+    telescopes are in self.telescopes with the columns x, y, z, r in cm.
+    Iterating yields (evth, bunches), where bunches is a dict of
+    (reuse-number, telescope-number), both starting at 1, to the bunches
+    which hit the telescope in this reuse of the shower. The bunches' x, y,
+    and time are relative to the telescope's center. Telescopes without
+    bunches are not in the dict.
+    """
+
+    def __init__(self, path):
+        super().__init__(path=path)
+        member = self._next_member()
+        assert member.name == TARIO_TELESCOPES_FILENAME
+        raw = self.tar.extractfile(member).read()
+        self.telescopes = np.frombuffer(raw, dtype=np.float64).reshape((-1, 4))
+
+    def __next__(self):
+        evth = self._next_evth()
+        prefix = "{:09d}.telescope_bunches.".format(int(np.round(evth[1])))
+        bunches = {}
+        while True:
+            member = self._next_member()
+            if member is None or not member.name.startswith(prefix):
+                self._lookahead = member
+                break
+            fields = member.name.split(".")
+            raw = self.tar.extractfile(member).read()
+            bunches[(int(fields[2]), int(fields[3]))] = np.frombuffer(
+                raw, dtype=np.float32
+            ).reshape((-1, 8))
+        self.num_events_read += 1
+        return (evth, bunches)
+
+
+class ReuseTario(Tario):
+    """
+    Reads the tar of the CORSIKA-primary-mod with the CSCAT card and a disc
+    or rectangle of interest. Iterating yields (evth, bunches), where
+    bunches is a list with the bunches of each reuse of the shower. The
+    bunches' x, y are relative to the region-of-interest, and the cores of
+    the reuses are in the evth, see I_EVTH_X_CORE_CM(reuse).
+    """
+
+    def __next__(self):
+        evth = self._next_evth()
+        prefix = "{:09d}.reuse_bunches.".format(int(np.round(evth[1])))
+        bunches = []
+        while True:
+            member = self._next_member()
+            if member is None or not member.name.startswith(prefix):
+                self._lookahead = member
+                break
+            raw = self.tar.extractfile(member).read()
+            bunches.append(
+                np.frombuffer(raw, dtype=np.float32).reshape((-1, 8))
+            )
+        self.num_events_read += 1
+        return (evth, bunches)
+
+
+def read_cut_statistics(path):
+    """
+    Returns a dict of the cut-statistics of the region-of-interest for each
+    event-number. Each is an array of len(ROI_CUTS) x len(ROI_STATISTICS).
+    The statistics are written when one of the ROI_CUTS is set in the
+    iact-options.
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if ".cut_statistics." not in member.name:
+                continue
+            event_number = int(member.name[0:9])
+            raw = tar.extractfile(member).read()
+            out[event_number] = np.frombuffer(raw, dtype=np.float64).reshape(
+                (len(ROI_CUTS), len(ROI_STATISTICS))
+            )
+    return out
+
+
+def read_merge_statistics(path):
+    """
+    Returns a dict of the number of bunches before, and after merging for
+    each event-number. Written when MERGE_BUNCHES is set in the
+    iact-options.
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if ".merge_statistics." not in member.name:
+                continue
+            event_number = int(member.name[0:9])
+            raw = tar.extractfile(member).read()
+            out[event_number] = np.frombuffer(raw, dtype=np.float64)
+    return out
+
+
+def read_importance_statistics(path):
+    """
+    Returns a dict of the statistics of the importance-sampling for each
+    event-number. Each is an array of len(IMPORTANCE_STATISTICS). The
+    photons kept are the sum of the bunch-sizes after they were divided by
+    the probability to keep the bunch. Written when CORSIKA passes a file of
+    importance-sampling to telsmp_.
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if ".importance_statistics." not in member.name:
+                continue
+            event_number = int(member.name[0:9])
+            raw = tar.extractfile(member).read()
+            out[event_number] = np.frombuffer(raw, dtype=np.float64)
+            assert out[event_number].shape[0] == len(IMPORTANCE_STATISTICS)
+    return out
+
+
+def read_particles(path):
+    """
+    Returns a dict of the particles on the observation-level for each
+    event-number, written when PARTICLES is set in the iact-options. Each is
+    an array of N x 7, or N x 8 with thinning, with CORSIKA's words
+    description, px, py, pz, x, y, time [, weight].
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if ".particles." not in member.name:
+                continue
+            event_number = int(member.name[0:9])
+            num_words = int(member.name.split(".Nx")[1].split("_")[0])
+            raw = tar.extractfile(member).read()
+            out[event_number] = np.frombuffer(raw, dtype=np.float32).reshape(
+                (-1, num_words)
+            )
+    return out
+
+
+def longitudinal_decode(payload):
+    """
+    Returns the list of longitudinal distributions in the payload of a
+    'longitudinal.float64' member, one for each call of tellng_. Each is a
+    dict with CORSIKA's 'type', the 'thickstep_g_per_cm2', and the
+    'distributions' as an array of np x nthick.
+    """
+    values = np.frombuffer(payload, dtype=np.float64)
+    out = []
+    pos = 0
+    while pos < values.shape[0]:
+        kind, num, num_thick, thickstep = values[pos : pos + 4]
+        size = int(num) * int(num_thick)
+        distributions = values[pos + 4 : pos + 4 + size]
+        out.append(
+            {
+                "type": int(kind),
+                "thickstep_g_per_cm2": float(thickstep),
+                "distributions": distributions.reshape(
+                    (int(num), int(num_thick))
+                ),
+            }
+        )
+        pos += 4 + size
+    return out
+
+
+def read_longitudinal(path):
+    """
+    Returns a dict of the longitudinal distributions for each event-number,
+    written when CORSIKA passes them to tellng_, e.g. with LONGI. See
+    longitudinal_decode().
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if not member.name.endswith(".longitudinal.float64"):
+                continue
+            event_number = int(member.name[0:9])
+            raw = tar.extractfile(member).read()
+            out[event_number] = longitudinal_decode(raw)
+    return out
+
+
+def read_summaries(path):
+    """
+    Returns a dict of the summary of the bunches for each event-number. Each
+    is an array of len(SUMMARY), written when SUMMARY is set in the
+    iact-options. Means and standard-deviations are weighted with the
+    bunch-size. Statistics of an event without photons are nan.
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if not member.name.endswith(".summary.float64"):
+                continue
+            event_number = int(member.name[0:9])
+            raw = tar.extractfile(member).read()
+            out[event_number] = np.frombuffer(raw, dtype=np.float64)
+            assert out[event_number].shape[0] == len(SUMMARY)
+    return out
+
+
+def read_histograms(path):
+    """
+    Returns a dict of the histograms for each event-number. Each is a dict
+    of the name in HISTOGRAMS to the sums of the bunch-sizes in its bins.
+    The histograms are written instead of the bunches when one of the
+    HISTOGRAM_* is set in the iact-options. The bins are uniform from min to
+    max, and 'xy' has the shape num_x x num_y.
+    """
+    out = {}
+    with tarfile.open(path, "r|*") as tar:
+        for member in tar:
+            if ".histogram_" not in member.name:
+                continue
+            event_number = int(member.name[0:9])
+            _, name, shape_dtype = member.name.split(".")
+            name = name[len("histogram_") :]
+            shape = shape_dtype.rpartition("_")[0]
+            raw = tar.extractfile(member).read()
+            if event_number not in out:
+                out[event_number] = {}
+            out[event_number][name] = np.frombuffer(
+                raw, dtype=np.float64
+            ).reshape([int(n) for n in shape.split("x")])
+    return out
+
+
+TAR_BLOCK_SIZE = 512
+INDEX_MAGIC = b"MTARIDX1"
+INDEX_FOOTER_SIZE = 32
+INDEX_MAX_NUM_TRAILING_NULL_BLOCKS = 20
+INDEX_DTYPE = np.dtype(
+    [
+        ("event_number", "<i8"),
+        ("evth_header", "<i8"),
+        ("evth_size", "<i8"),
+        ("bunches_header", "<i8"),
+        ("bunches_size", "<i8"),
+        ("num_bunches", "<i8"),
+    ]
+)
+
+
+def read_event_index(path):
+    """
+    Returns the event-index written as the last member of the tar, see
+    mtar_write_index() in resources/microtar.h. The tar is read from its
+    tail. Returns None when the tar has no event-index.
+    """
+    with open(path, "rb") as f:
+        f.seek(0, os.SEEK_END)
+        pos = f.tell() - f.tell() % TAR_BLOCK_SIZE
+        for i in range(INDEX_MAX_NUM_TRAILING_NULL_BLOCKS + 1):
+            if pos < 2 * TAR_BLOCK_SIZE:
+                return None
+            pos -= TAR_BLOCK_SIZE
+            f.seek(pos)
+            block = f.read(TAR_BLOCK_SIZE)
+            if block.count(0) != TAR_BLOCK_SIZE:
+                break
+        footer = block[TAR_BLOCK_SIZE - INDEX_FOOTER_SIZE :]
+        if footer[0:8] != INDEX_MAGIC:
+            return None
+        record_size, num_records, header = struct.unpack("<QQQ", footer[8:])
+        assert record_size == INDEX_DTYPE.itemsize
+        f.seek(header)
+        info = tarfile.TarInfo.frombuf(
+            f.read(TAR_BLOCK_SIZE), tarfile.ENCODING, "surrogateescape"
+        )
+        assert info.name == TARIO_INDEX_FILENAME
+        records = f.read(record_size * num_records)
+    return np.frombuffer(records, dtype=INDEX_DTYPE)
+
+
+class IndexedTario:
+    """
+    Random access to the events in the tar of the CORSIKA-primary-mod using
+    its event-index. Only the members of the requested event are read.
+    """
+
+    def __init__(self, path):
+        self.path = path
+        self.index = read_event_index(path)
+        assert self.index is not None, "No event-index in tar."
+        self.file = open(path, "rb")
+        _, runh_bin = self._read_member(0)
+        self.runh = np.frombuffer(runh_bin, dtype=np.float32)
+        assert self.runh[0] == RUNH_MARKER_FLOAT32
+
+    def _read_header(self, header):
+        self.file.seek(header)
+        block = self.file.read(TAR_BLOCK_SIZE)
+        if len(block) < TAR_BLOCK_SIZE or block.count(0) == TAR_BLOCK_SIZE:
+            return None
+        return tarfile.TarInfo.frombuf(
+            block, tarfile.ENCODING, "surrogateescape"
+        )
+
+    def _read_member(self, header):
+        info = self._read_header(header)
+        return info.name, self.file.read(info.size)
+
+    @property
+    def event_numbers(self):
+        return self.index["event_number"]
+
+    def __len__(self):
+        return self.index.shape[0]
+
+    def __getitem__(self, event_number):
+        """
+        Returns (evth, bunches) of the event with this event-number.
+        """
+        match = np.flatnonzero(self.index["event_number"] == event_number)
+        if match.shape[0] == 0:
+            raise KeyError(event_number)
+        record = self.index[match[0]]
+
+        _, evth_bin = self._read_member(record["evth_header"])
+        evth = np.frombuffer(evth_bin, dtype=np.float32)
+        assert evth[0] == EVTH_MARKER_FLOAT32
+        assert int(np.round(evth[1])) == event_number
+
+        pieces = []
+        header = int(record["bunches_header"])
+        while True:
+            info = self._read_header(header)
+            if info is None or not _is_bunches_of(info.name, event_number):
+                break
+            pieces.append(
+                _decode_bunches(
+                    name=info.name, payload=self.file.read(info.size)
+                )
+            )
+            header += TAR_BLOCK_SIZE * (1 + -(-info.size // TAR_BLOCK_SIZE))
+        bunches = np.concatenate(pieces)
+        assert bunches.shape[0] == record["num_bunches"]
+        return (evth, bunches)
+
+    def close(self):
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    def __repr__(self):
+        out = "{:s}(path='{:s}', num_events={:d})".format(
+            self.__class__.__name__, self.path, len(self)
+        )
+        return out
+
+
+ARROW_COLUMN_NAMES = [
+    "x",
+    "y",
+    "cx",
+    "cy",
+    "time",
+    "zem",
+    "bsize",
+    "wavelength",
+]
+
+
+def _arrow_metadata_block(metadata, key):
+    """
+    Binary blocks in the arrow-stream's metadata are base64-encoded. The
+    dtype is the key's postfix, e.g. 'float32', or '5x4_float64'.
+    """
+    import base64
+
+    dtype = np.dtype(key.split(".")[-1].rpartition("_")[2])
+    return np.frombuffer(base64.b64decode(metadata[key.encode()]), dtype=dtype)
+
+
+class ArrowReader:
+    """
+    Reads the arrow-stream of the CORSIKA-primary-mod when the iact-option
+    OUTPUT_FORMAT is arrow. Iterating yields (evth, bunches), where bunches
+    is a pyarrow.RecordBatch with the columns in ARROW_COLUMN_NAMES. The
+    file is memory-mapped, and the columns are not copied.
+    """
+
+    def __init__(self, path):
+        import pyarrow
+        import pyarrow.ipc
+
+        self.path = path
+        self.source = pyarrow.memory_map(path, "r")
+        self.reader = pyarrow.ipc.open_stream(self.source)
+        self.runh = _arrow_metadata_block(
+            self.reader.schema.metadata, "runh.float32"
+        )
+        assert self.runh[0] == RUNH_MARKER_FLOAT32
+        self.num_events_read = 0
+
+    def __next__(self):
+        bunches, metadata = self.reader.read_next_batch_with_custom_metadata()
+        evth = _arrow_metadata_block(metadata, "evth.float32")
+        assert evth[0] == EVTH_MARKER_FLOAT32
+        self.num_events_read += 1
+        return (evth, bunches)
+
+    def __iter__(self):
+        return self
+
+    def close(self):
+        self.source.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, exc_value, traceback):
+        self.close()
+
+    def __repr__(self):
+        out = "{:s}(path='{:s}', read={:d})".format(
+            self.__class__.__name__, self.path, self.num_events_read
+        )
+        return out
+
+
 NUM_RANDOM_SEQUENCES = 4
 
 
@@ -418,6 +1175,10 @@ class CorsikaPrimary:
         )
         with open(self.primary_path, "wb") as f:
             f.write(self.primary_bytes)
+        _write_iact_options(
+            corsika_run_dir=self.tmp_corsika_run_dir,
+            iact_options=self.steering_dict.get("iact_options", {}),
+        )
 
         self.steering_card = _overwrite_steering_card(
             steering_card=self.steering_card,
@@ -0,0 +1,260 @@
+"""
+A catalogue of the events in many runs of the CORSIKA-primary-mod.
+
+For each event, the catalogue holds the fields of the EVTH which are needed
+to select events, the number of bunches, and the byte-offset of the event's
+evth-member in its tar. Queries are evaluated on the catalogue's columns
+only, and return (tar-path, offset). Use read_event(path, offset) to read a
+selected event without reading the rest of its tar.
+
+The catalogue is written to a single numpy .npz with one array per column.
+Building it again only scans the tars which are new, or which changed in
+size or modification-time since the last build.
+"""
+import numpy as np
+import os
+import tarfile
+import multiprocessing
+from . import TARIO_INDEX_FILENAME
+from . import TAR_BLOCK_SIZE
+from . import EVTH_MARKER_FLOAT32
+from . import read_event_index
+from . import _decode_bunches
+from . import _is_bunches_of
+from . import I_EVTH_EVENT_NUMBER
+from . import I_EVTH_PARTICLE_ID
+from . import I_EVTH_TOTAL_ENERGY_GEV
+from . import I_EVTH_STARTING_DEPTH_G_PER_CM2
+from . import I_EVTH_Z_FIRST_INTERACTION_CM
+from . import I_EVTH_ZENITH_RAD
+from . import I_EVTH_AZIMUTH_RAD
+from . import I_EVTH_RUN_NUMBER
+from . import I_EVTH_RANDOM_SEED
+from . import I_EVTH_RANDOM_SEED_CALLS
+from . import I_EVTH_RANDOM_SEED_BILLIONS
+from . import NUM_RANDOM_SEQUENCES
+
+
+EVTH_NUM_BYTES = 273 * 4
+
+EVTH_COLUMNS = {
+    "event_number": (I_EVTH_EVENT_NUMBER, np.int64),
+    "run_number": (I_EVTH_RUN_NUMBER, np.int64),
+    "particle_id": (I_EVTH_PARTICLE_ID, np.int32),
+    "energy_gev": (I_EVTH_TOTAL_ENERGY_GEV, np.float32),
+    "starting_depth_g_per_cm2": (I_EVTH_STARTING_DEPTH_G_PER_CM2, np.float32),
+    "z_first_interaction_cm": (I_EVTH_Z_FIRST_INTERACTION_CM, np.float32),
+    "zenith_rad": (I_EVTH_ZENITH_RAD, np.float32),
+    "azimuth_rad": (I_EVTH_AZIMUTH_RAD, np.float32),
+}
+for _s in range(1, NUM_RANDOM_SEQUENCES + 1):
+    EVTH_COLUMNS["seed_{:d}".format(_s)] = (I_EVTH_RANDOM_SEED(_s), np.int32)
+    EVTH_COLUMNS["seed_calls_{:d}".format(_s)] = (
+        I_EVTH_RANDOM_SEED_CALLS(_s),
+        np.int32,
+    )
+    EVTH_COLUMNS["seed_billions_{:d}".format(_s)] = (
+        I_EVTH_RANDOM_SEED_BILLIONS(_s),
+        np.int32,
+    )
+
+COLUMNS = dict(EVTH_COLUMNS)
+COLUMNS["num_bunches"] = (None, np.int64)
+COLUMNS["offset"] = (None, np.int64)
+COLUMNS["path_id"] = (None, np.int32)
+
+
+def _round_up(size):
+    return size + (TAR_BLOCK_SIZE - size % TAR_BLOCK_SIZE) % TAR_BLOCK_SIZE
+
+
+def _read_member(f, offset):
+    """
+    Returns (name, size, data_offset) of the tar-header at offset, or None
+    at the end of the tar.
+    """
+    f.seek(offset)
+    block = f.read(TAR_BLOCK_SIZE)
+    if len(block) < TAR_BLOCK_SIZE or block.count(0) == TAR_BLOCK_SIZE:
+        return None
+    info = tarfile.TarInfo.frombuf(block, tarfile.ENCODING, "surrogateescape")
+    return info.name, info.size, offset + TAR_BLOCK_SIZE
+
+
+def _empty_columns(num=0):
+    return {k: np.zeros(num, dtype=COLUMNS[k][1]) for k in COLUMNS}
+
+
+def _evth_rows(evths, offsets, num_bunches):
+    evths = np.frombuffer(b"".join(evths), dtype=np.float32)
+    evths = evths.reshape((-1, 273))
+    assert np.all(evths[:, 0] == EVTH_MARKER_FLOAT32)
+    cols = _empty_columns(num=evths.shape[0])
+    for key in EVTH_COLUMNS:
+        idx, dtype = EVTH_COLUMNS[key]
+        if np.issubdtype(dtype, np.integer):
+            cols[key] = np.round(evths[:, idx]).astype(dtype)
+        else:
+            cols[key] = evths[:, idx].astype(dtype)
+    cols["offset"] = np.array(offsets, dtype=np.int64)
+    cols["num_bunches"] = np.array(num_bunches, dtype=np.int64)
+    return cols
+
+
+def scan_tar(path):
+    """
+    Returns the columns of all events in the tar at path, without path_id.
+    When the tar has an event-index, only the evth-members are read.
+    Otherwise the tar-headers are walked, and the bunches are only read when
+    they are encoded and their number can not be derived from the size.
+    """
+    evths, offsets, num_bunches = [], [], []
+    index = read_event_index(path)
+    with open(path, "rb") as f:
+        if index is not None:
+            for record in index:
+                f.seek(record["evth_header"] + TAR_BLOCK_SIZE)
+                evths.append(f.read(EVTH_NUM_BYTES))
+                offsets.append(record["evth_header"])
+                num_bunches.append(record["num_bunches"])
+        else:
+            offset = 0
+            while True:
+                member = _read_member(f, offset)
+                if member is None:
+                    break
+                name, size, data_offset = member
+                if name == TARIO_INDEX_FILENAME:
+                    break
+                if name.endswith(".evth.float32"):
+                    evths.append(f.read(EVTH_NUM_BYTES))
+                    offsets.append(offset)
+                    num_bunches.append(0)
+                elif ".cherenkov_bunches." in name:
+                    if name.endswith(".Nx8_float32"):
+                        num_bunches[-1] += size // 32
+                    else:
+                        bunches = _decode_bunches(name, f.read(size))
+                        num_bunches[-1] += bunches.shape[0]
+                offset = data_offset + _round_up(size)
+    return _evth_rows(evths, offsets, num_bunches)
+
+
+def _file_stamp(path):
+    st = os.stat(path)
+    return st.st_size, st.st_mtime_ns
+
+
+def _concatenate(parts):
+    cols = _empty_columns()
+    for key in cols:
+        if len(parts) > 0:
+            cols[key] = np.concatenate([p[key] for p in parts])
+    return cols
+
+
+def read(path):
+    """
+    Returns the catalogue as a dict of columns. The dict also has 'paths',
+    'sizes', and 'mtimes_ns' of the scanned tars, indexed by 'path_id'.
+    """
+    with np.load(path, allow_pickle=False) as z:
+        return {k: z[k] for k in z.files}
+
+
+def write(path, catalogue):
+    tmp_path = path + ".tmp.npz"
+    np.savez_compressed(tmp_path, **catalogue)
+    os.rename(tmp_path, path)
+
+
+def build(catalogue_path, tar_paths, num_processes=1):
+    """
+    Scans the tar_paths, and writes the catalogue to catalogue_path. When the
+    catalogue already exists, tars with the same size and modification-time
+    as in the catalogue are not scanned again. Tars which are no longer in
+    tar_paths are dropped from the catalogue.
+    Returns the number of tars scanned.
+    """
+    tar_paths = [os.path.abspath(p) for p in tar_paths]
+    stamps = [_file_stamp(p) for p in tar_paths]
+
+    old_parts = {}
+    if os.path.exists(catalogue_path):
+        old = read(catalogue_path)
+        for old_id, old_path in enumerate(old["paths"]):
+            mask = old["path_id"] == old_id
+            old_parts[str(old_path)] = (
+                (int(old["sizes"][old_id]), int(old["mtimes_ns"][old_id])),
+                {k: old[k][mask] for k in COLUMNS},
+            )
+
+    to_scan = []
+    for path, stamp in zip(tar_paths, stamps):
+        if path not in old_parts or old_parts[path][0] != stamp:
+            to_scan.append(path)
+
+    if num_processes > 1 and len(to_scan) > 1:
+        with multiprocessing.Pool(num_processes) as pool:
+            scanned = pool.map(scan_tar, to_scan)
+    else:
+        scanned = [scan_tar(p) for p in to_scan]
+    scanned = dict(zip(to_scan, scanned))
+
+    parts = []
+    for path_id, path in enumerate(tar_paths):
+        if path in scanned:
+            part = scanned[path]
+        else:
+            part = old_parts[path][1]
+        part["path_id"] = np.full(
+            part["event_number"].shape[0], path_id, dtype=np.int32
+        )
+        parts.append(part)
+
+    catalogue = _concatenate(parts)
+    catalogue["paths"] = np.array(tar_paths, dtype=str)
+    catalogue["sizes"] = np.array([s[0] for s in stamps], dtype=np.int64)
+    catalogue["mtimes_ns"] = np.array([s[1] for s in stamps], dtype=np.int64)
+    write(catalogue_path, catalogue)
+    return len(to_scan)
+
+
+def query(catalogue, predicate):
+    """
+    Returns a list of (tar-path, offset) of the events for which
+    predicate(catalogue) is True. The predicate is evaluated on the columns,
+    e.g.
+
+        lambda c: (c["particle_id"] == 1) & (c["energy_gev"] > 1e3)
+    """
+    mask = np.asarray(predicate(catalogue), dtype=bool)
+    paths = catalogue["paths"]
+    return [
+        (str(paths[path_id]), int(offset))
+        for path_id, offset in zip(
+            catalogue["path_id"][mask], catalogue["offset"][mask]
+        )
+    ]
+
+
+def read_event(path, offset):
+    """
+    Returns (evth, bunches) of the event with its evth-member at offset in
+    the tar at path. Chunks of bunches are concatenated.
+    """
+    with open(path, "rb") as f:
+        name, size, data_offset = _read_member(f, offset)
+        assert name.endswith(".evth.float32")
+        evth = np.frombuffer(f.read(size), dtype=np.float32)
+        assert evth[0] == EVTH_MARKER_FLOAT32
+        event_number = int(np.round(evth[I_EVTH_EVENT_NUMBER]))
+        pieces = []
+        while True:
+            member = _read_member(f, data_offset + _round_up(size))
+            if member is None or not _is_bunches_of(member[0], event_number):
+                break
+            name, size, data_offset = member
+            pieces.append(_decode_bunches(name, f.read(size)))
+        bunches = np.concatenate(pieces)
+    return evth, bunches
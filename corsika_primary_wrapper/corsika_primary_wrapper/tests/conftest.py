@@ -1,4 +1,9 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
 import os
+import shutil
+import subprocess
 
 CORSIKA_PATH = os.path.join(
     ".",
@@ -10,6 +15,10 @@ CORSIKA_PATH = os.path.join(
     "corsika75600Linux_QGSII_urqmd",
 )
 
+RESOURCES_DIR = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), "..", "..", "..", "resources"
+)
+
 
 def pytest_addoption(parser):
     parser.addoption(
@@ -30,3 +39,101 @@ def pytest_addoption(parser):
         ),
     )
     parser.addoption("--non_temporary_path", action="store", default="")
+
+
+class IactHarness:
+    """
+    Runs resources/test_iact.c, which calls the iact.c of the
+    CORSIKA-primary-mod like CORSIKA does, with fixed photon-bunches.
+    """
+
+    NUM_BUNCHES = [1000, 0, 2500]
+    NUM_PARTICLES = [39, 37, 35]
+
+    def __init__(self, path):
+        self.path = path
+
+    @classmethod
+    def compile(cls, path, flags=[]):
+        """
+        Returns the harness, or None when it can not be compiled with flags.
+        """
+        rc = subprocess.call(
+            ["gcc", os.path.join(RESOURCES_DIR, "test_iact.c"), "-o", path]
+            + flags
+            + ["-lm", "-pthread", "-O2"],
+            stderr=subprocess.DEVNULL,
+        )
+        return cls(path) if rc == 0 else None
+
+    def popen(self, tmp, path, iact_options={}, args=[]):
+        """
+        Starts the harness in tmp to write the run to path.
+        """
+        cpw._write_iact_options(tmp, iact_options)
+        return subprocess.Popen(
+            [self.path, path] + args, cwd=tmp, stdout=subprocess.DEVNULL
+        )
+
+    def expected(self, tmp):
+        """
+        Returns the bunches which were passed to iact.c in each event.
+        """
+        bunches = np.fromfile(
+            os.path.join(tmp, "expected_bunches.Nx8_float32"),
+            dtype=np.float32,
+        )
+        return self._split(bunches.reshape((-1, 8)), self.NUM_BUNCHES)
+
+    def expected_particles(self, tmp):
+        """
+        Returns the particles which were passed to iact.c in each event.
+        """
+        particles = np.fromfile(
+            os.path.join(tmp, "expected_particles.Nx7_float32"),
+            dtype=np.float32,
+        )
+        return self._split(particles.reshape((-1, 7)), self.NUM_PARTICLES)
+
+    def run(self, tmp, iact_options={}, args=[]):
+        """
+        Runs the harness in tmp. Returns the path of the run, and the
+        bunches which were passed to iact.c in each event.
+        """
+        path = os.path.join(tmp, "run.tar")
+        assert self.popen(tmp, path, iact_options, args).wait() == 0
+        return path, self.expected(tmp)
+
+    def assert_tario_equal(self, path, expected):
+        num_events = 0
+        for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+            assert evth[1] == i + 1
+            np.testing.assert_array_equal(bunches, expected[i])
+            num_events += 1
+        assert num_events == len(self.NUM_BUNCHES)
+
+    @staticmethod
+    def kept(expected, got):
+        """
+        Returns the mask of the expected bunches which are in got, e.g.
+        after thinning, and asserts that their order was kept.
+        """
+        keys = np.ascontiguousarray(expected[:, 0:2]).view(np.uint64).ravel()
+        got_keys = np.ascontiguousarray(got[:, 0:2]).view(np.uint64).ravel()
+        mask = np.isin(keys, got_keys)
+        assert np.array_equal(keys[mask], got_keys)
+        return mask
+
+    @staticmethod
+    def _split(values, sizes):
+        return np.split(values, np.cumsum(sizes)[:-1])
+
+
+@pytest.fixture(scope="session")
+def iact_harness(tmp_path_factory):
+    if shutil.which("gcc") is None:
+        pytest.skip("Needs gcc to compile resources/test_iact.c.")
+    path = str(tmp_path_factory.mktemp("iact_harness") / "TestIact")
+    harness = IactHarness.compile(path)
+    assert harness is not None
+    return harness
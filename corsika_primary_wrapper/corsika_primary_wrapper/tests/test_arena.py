@@ -0,0 +1,16 @@
+import pytest
+import tempfile
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [{}, {"ARENA_RAM_CAP_MIB": 1024}, {"ARENA_RAM_CAP_MIB": 0.01}],
+)
+def test_bunches_are_written_in_order(iact_harness, iact_options):
+    """
+    With ARENA_RAM_CAP_MIB 0.01, the bunches of an event do not fit into
+    the arena and spill to the buffer-file.
+    """
+    with tempfile.TemporaryDirectory(prefix="test_arena_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        iact_harness.assert_tario_equal(path, expected)
@@ -0,0 +1,42 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tempfile
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {"OUTPUT_FORMAT": "arrow"},
+        {"OUTPUT_FORMAT": "arrow", "ARENA_RAM_CAP_MIB": 0.01},
+        {"OUTPUT_FORMAT": "arrow", "ASYNC_WRITER": "T"},
+    ],
+)
+def test_read_stream(iact_harness, iact_options):
+    pytest.importorskip("pyarrow")
+    with tempfile.TemporaryDirectory(prefix="test_arrow") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+
+        with cpw.ArrowReader(path) as run:
+            assert run.runh[0] == cpw.RUNH_MARKER_FLOAT32
+            num_events = 0
+            for i, (evth, batch) in enumerate(run):
+                assert evth[1] == i + 1
+                assert batch.num_rows == expected[i].shape[0]
+                for c, name in enumerate(cpw.ARROW_COLUMN_NAMES):
+                    np.testing.assert_array_equal(
+                        batch.column(name).to_numpy(), expected[i][:, c]
+                    )
+                num_events += 1
+        assert num_events == len(expected)
+
+
+def test_context_manager(iact_harness):
+    pytest.importorskip("pyarrow")
+    with tempfile.TemporaryDirectory(prefix="test_arrow") as tmp:
+        path, expected = iact_harness.run(tmp, {"OUTPUT_FORMAT": "arrow"})
+        with cpw.ArrowReader(path) as run:
+            num_rows = [batch.num_rows for evth, batch in run]
+            assert run.num_events_read == len(expected)
+        assert num_rows == [e.shape[0] for e in expected]
+        assert run.source.closed
@@ -0,0 +1,17 @@
+import pytest
+import tempfile
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {"ASYNC_WRITER": "T"},
+        {"ASYNC_WRITER": "T", "ASYNC_WRITER_NUM_BUFFERS": 1},
+        {"ASYNC_WRITER": "T", "SINGLE_PASS": "F"},
+        {"ASYNC_WRITER": "T", "SINGLE_PASS": "F", "ARENA_RAM_CAP_MIB": 0.01},
+    ],
+)
+def test_output_does_not_change(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_async_writer_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        iact_harness.assert_tario_equal(path, expected)
@@ -0,0 +1,82 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import os
+import tempfile
+
+OBSERVATION_LEVEL_CM = 2300e2
+
+
+def _thickness(height_cm):
+    """
+    The atmosphere of resources/test_iact.c, see its heigh_().
+    """
+    return 1033.0 * np.exp(-height_cm / 8e5)
+
+
+def _rayleigh_probability(bunches):
+    """
+    The probability of each bunch to be kept, averaged over the wavelengths
+    drawn from 1/wavelength^2 in 250nm to 700nm.
+    """
+    b = bunches.astype(np.float64)
+    wavelength = np.linspace(250, 700, 451)
+    spectrum = 1 / wavelength ** 2
+    spectrum /= np.sum(spectrum)
+    cz = np.sqrt(1 - b[:, cpw.ICX] ** 2 - b[:, cpw.ICY] ** 2)
+    depth = _thickness(OBSERVATION_LEVEL_CM) - _thickness(b[:, cpw.IZEM])
+    tau = np.outer(depth / 2974.0 / cz, (400.0 / wavelength) ** 4)
+    return np.exp(-tau) @ spectrum
+
+
+def _run(iact_harness, tmp, iact_options):
+    path, expected = iact_harness.run(tmp, iact_options)
+    got = list(cpw.Tario(path))
+    masks = [iact_harness.kept(expected[i], b) for i, (_, b) in enumerate(got)]
+    for i, (evth, bunches) in enumerate(got):
+        np.testing.assert_array_equal(
+            bunches[:, 0:7], expected[i][masks[i], 0:7]
+        )
+        assert np.all(bunches[:, cpw.IWVL] >= 250)
+        assert np.all(bunches[:, cpw.IWVL] <= 700)
+    return got, expected, masks
+
+
+def test_rayleigh(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_atmosphere_") as tmp:
+        got, expected, masks = _run(
+            iact_harness, tmp, {"ATMOSPHERIC_TRANSMISSION": [0, 1, 0]}
+        )
+        p = np.concatenate([_rayleigh_probability(e) for e in expected])
+        num_kept = np.sum([np.sum(m) for m in masks])
+        assert abs(num_kept - np.sum(p)) <= 5 * np.sqrt(np.sum(p * (1 - p)))
+
+        # the blue photons are scattered more
+        wavelength = np.concatenate([b[:, cpw.IWVL] for _, b in got])
+        assert np.mean(wavelength) > np.log(700 / 250) / (1 / 250 - 1 / 700)
+
+
+def test_aerosols_and_detector_efficiency(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_atmosphere_") as tmp:
+        num_kept = {}
+        for key, iact_options in [
+            ("rayleigh", {"ATMOSPHERIC_TRANSMISSION": [0, 1, 0]}),
+            ("aerosols", {"ATMOSPHERIC_TRANSMISSION": [0.05, 1.2, 1.3]}),
+        ]:
+            _, _, masks = _run(iact_harness, tmp, iact_options)
+            num_kept[key] = np.sum([np.sum(m) for m in masks])
+        assert 0 < num_kept["aerosols"] < num_kept["rayleigh"]
+
+        efficiency_path = os.path.join(tmp, "efficiency.txt")
+        with open(efficiency_path, "wt") as f:
+            f.write("# wavelength_nm efficiency\n200 0.5\n800 0.5\n")
+        _, expected, masks = _run(
+            iact_harness,
+            tmp,
+            {
+                "ATMOSPHERIC_TRANSMISSION": [0, 1, 0],
+                "DETECTOR_EFFICIENCY": efficiency_path,
+            },
+        )
+        p = 0.5 * np.concatenate([_rayleigh_probability(e) for e in expected])
+        num_kept = np.sum([np.sum(m) for m in masks])
+        assert abs(num_kept - np.sum(p)) <= 5 * np.sqrt(np.sum(p * (1 - p)))
@@ -0,0 +1,82 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import struct
+import tarfile
+import tempfile
+
+
+def _encode(bunches, delta_mask=0xF0):
+    """
+    Reference of resources/bunchcodec.h in numpy.
+    """
+    num = bunches.shape[0]
+    words = bunches.view(np.uint32).T.copy()
+    for c in range(8):
+        if (delta_mask >> c) & 1:
+            words[c, 1:] = words[c, 1:] - words[c, :-1]
+    planes = np.zeros(shape=(8, 4, num), dtype=np.uint8)
+    for b in range(4):
+        planes[:, b, :] = (words >> np.uint32(8 * b)) & np.uint32(0xFF)
+    header = struct.pack("<IIQ", cpw.BUNCHCODEC_MAGIC, delta_mask, num)
+    return header + planes.tobytes()
+
+
+def _example_bunches(num, seed):
+    prng = np.random.Generator(np.random.PCG64(seed))
+    bunches = prng.uniform(size=(num, 8)).astype(np.float32)
+    bunches[:, cpw.IZEM] = 2e6 - np.cumsum(prng.uniform(size=num) * 1e2)
+    bunches[:, cpw.IBSIZE] = 1.0
+    bunches[0, cpw.ITIME] = np.nan
+    bunches[0, cpw.IX] = -0.0
+    return bunches
+
+
+def test_empty():
+    bunches = cpw.bunchcodec_decode(b"")
+    assert bunches.shape == (0, 8)
+    bunches = cpw.bunchcodec_decode(_encode(np.zeros((0, 8), np.float32)))
+    assert bunches.shape == (0, 8)
+
+
+def test_bit_exact_over_blocks():
+    a = _example_bunches(num=1000, seed=1)
+    b = _example_bunches(num=17, seed=2)
+    payload = _encode(a) + _encode(b, delta_mask=0xFF)
+    back = cpw.bunchcodec_decode(payload)
+    assert back.dtype == np.float32
+    assert back.shape == (1017, 8)
+    np.testing.assert_array_equal(
+        back.view(np.uint32), np.concatenate([a, b]).view(np.uint32)
+    )
+
+
+def test_decode_bunches_by_name():
+    a = _example_bunches(num=10, seed=3)
+    name = "000000001.cherenkov_bunches.Nx8_float32"
+    back = cpw._decode_bunches(name, a.tobytes())
+    np.testing.assert_array_equal(back, a)
+    back = cpw._decode_bunches(name + ".bunchcodec", _encode(a))
+    np.testing.assert_array_equal(back.view(np.uint32), a.view(np.uint32))
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {"BUNCHCODEC": "T"},
+        {"BUNCHCODEC": "T", "SINGLE_PASS": "F"},
+        {"BUNCHCODEC": "T", "SINGLE_PASS": "F", "ARENA_RAM_CAP_MIB": 0.01},
+        {"BUNCHCODEC": "T", "ASYNC_WRITER": "T"},
+    ],
+)
+def test_run_is_bit_exact(iact_harness, iact_options):
+    """
+    With ARENA_RAM_CAP_MIB 0.01, the encoded bunches of an event are larger
+    than the arena.
+    """
+    with tempfile.TemporaryDirectory(prefix="test_bunchcodec_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        iact_harness.assert_tario_equal(path, expected)
+        with tarfile.open(path) as tar:
+            names = tar.getnames()
+        assert "000000003.cherenkov_bunches.Nx8_float32.bunchcodec" in names
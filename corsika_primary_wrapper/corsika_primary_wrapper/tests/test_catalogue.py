@@ -0,0 +1,99 @@
+import corsika_primary_wrapper as cpw
+from corsika_primary_wrapper import catalogue
+import numpy as np
+import tarfile
+import os
+import time
+import tempfile
+
+
+def _run_in(iact_harness, tmp, name, iact_options={}):
+    run_dir = os.path.join(tmp, name)
+    os.makedirs(run_dir, exist_ok=True)
+    return iact_harness.run(run_dir, iact_options)
+
+
+def test_build_query_and_read(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_catalogue_") as tmp:
+        paths = []
+        for name in ["1", "2", "3"]:
+            path, expected = _run_in(iact_harness, tmp, name)
+            paths.append(path)
+        cat_path = os.path.join(tmp, "catalogue.npz")
+
+        num_scanned = catalogue.build(cat_path, paths, num_processes=2)
+        assert num_scanned == 3
+        cat = catalogue.read(cat_path)
+        assert cat["event_number"].shape[0] == 9
+        np.testing.assert_array_equal(
+            cat["num_bunches"], iact_harness.NUM_BUNCHES * 3
+        )
+        np.testing.assert_array_equal(cat["particle_id"][0:3], [1, 3, 1])
+        np.testing.assert_array_equal(cat["seed_1"][3:6], [1, 2, 3])
+        np.testing.assert_array_equal(cat["path_id"], np.repeat([0, 1, 2], 3))
+
+        selection = catalogue.query(
+            cat,
+            lambda c: (c["particle_id"] == 1) & (c["energy_gev"] > 50.0),
+        )
+        assert len(selection) == 3
+        for path, offset in selection:
+            evth, bunches = catalogue.read_event(path, offset)
+            assert evth[cpw.I_EVTH_PARTICLE_ID] == 1
+            assert int(evth[cpw.I_EVTH_EVENT_NUMBER]) == 3
+            np.testing.assert_array_equal(bunches, expected[2])
+
+        # only the changed tar is scanned again
+        num_scanned = catalogue.build(cat_path, paths)
+        assert num_scanned == 0
+        time.sleep(0.01)
+        _run_in(iact_harness, tmp, "2", {"BUNCHCODEC": "T"})
+        num_scanned = catalogue.build(cat_path, paths)
+        assert num_scanned == 1
+        cat = catalogue.read(cat_path)
+        assert cat["event_number"].shape[0] == 9
+        path, offset = catalogue.query(
+            cat, lambda c: (c["path_id"] == 1) & (c["event_number"] == 3)
+        )[0]
+        evth, bunches = catalogue.read_event(path, offset)
+        np.testing.assert_array_equal(bunches, expected[2])
+
+        # tars no longer listed are dropped
+        num_scanned = catalogue.build(cat_path, paths[0:1])
+        assert num_scanned == 0
+        cat = catalogue.read(cat_path)
+        assert cat["event_number"].shape[0] == 3
+        assert len(cat["paths"]) == 1
+
+
+def test_member_larger_8gib():
+    """
+    The size of a bunch-member larger 8GiB does not fit into the octal
+    size-field. It is written in GNU's base-256 encoding instead. The tar is
+    sparse, so its payload takes no space on disk.
+    """
+    num_bunches = 2 ** 28 + 3
+    size = num_bunches * 32
+    assert size > 8 * 1024 ** 3
+    evth = np.zeros(273, dtype=np.float32)
+    evth[cpw.I_EVTH_MARKER] = cpw.EVTH_MARKER_FLOAT32
+    evth[cpw.I_EVTH_EVENT_NUMBER] = 1
+    with tempfile.TemporaryDirectory(prefix="test_catalogue_") as tmp:
+        path = os.path.join(tmp, "big.tar")
+        with open(path, "wb") as f:
+            for name, payload_size in [
+                (cpw.TARIO_EVTH_FILENAME.format(1), evth.nbytes),
+                (cpw.TARIO_BUNCHES_FILENAME.format(1), size),
+            ]:
+                info = tarfile.TarInfo(name=name)
+                info.size = payload_size
+                f.write(info.tobuf(format=tarfile.GNU_FORMAT))
+                if payload_size == evth.nbytes:
+                    f.write(evth.tobytes())
+                    f.write(b"\0" * (-evth.nbytes % cpw.TAR_BLOCK_SIZE))
+                else:
+                    f.seek(payload_size, os.SEEK_CUR)
+            f.write(b"\0" * 2 * cpw.TAR_BLOCK_SIZE)
+
+        cat = catalogue.scan_tar(path)
+        assert cat["num_bunches"][0] == num_bunches
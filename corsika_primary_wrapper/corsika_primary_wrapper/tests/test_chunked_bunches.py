@@ -0,0 +1,91 @@
+import corsika_primary_wrapper as cpw
+from corsika_primary_wrapper import catalogue
+import numpy as np
+import pytest
+import tarfile
+import tempfile
+
+BUNCH_CHUNK_MIB = 0.01
+NUM_BUNCHES_PER_CHUNK = int(BUNCH_CHUNK_MIB * 2 ** 20) // 32
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {},
+        {"SINGLE_PASS": "F"},
+        {"ASYNC_WRITER": "T"},
+        {"BUNCHCODEC": "T"},
+        {"COMPACT_BUNCHES": "T"},
+    ],
+)
+def test_tario_concatenates_chunks(iact_harness, iact_options):
+    """
+    An event without bunches still has one empty chunk.
+    """
+    iact_options = dict(iact_options, BUNCH_CHUNK_MIB=BUNCH_CHUNK_MIB)
+    with tempfile.TemporaryDirectory(prefix="test_chunked_bunches_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        with tarfile.open(path) as tar:
+            names = tar.getnames()
+        for i, num_bunches in enumerate(iact_harness.NUM_BUNCHES):
+            num_chunks = max(1, -(-num_bunches // NUM_BUNCHES_PER_CHUNK))
+            prefix = "{:09d}.cherenkov_bunches.".format(i + 1)
+            assert len([n for n in names if n.startswith(prefix)]) == (
+                num_chunks
+            )
+        if "COMPACT_BUNCHES" in iact_options:
+            for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+                assert bunches.shape == expected[i].shape
+        else:
+            iact_harness.assert_tario_equal(path, expected)
+
+
+@pytest.mark.parametrize("bunch_chunk_mib", [0, BUNCH_CHUNK_MIB])
+def test_block_tario_yields_fixed_size_blocks(iact_harness, bunch_chunk_mib):
+    with tempfile.TemporaryDirectory(prefix="test_chunked_bunches_") as tmp:
+        path, expected = iact_harness.run(
+            tmp, {"BUNCH_CHUNK_MIB": bunch_chunk_mib}
+        )
+        for num_bunches_per_block in [1, 100, NUM_BUNCHES_PER_CHUNK, 5000]:
+            run = cpw.BlockTario(path, num_bunches_per_block)
+            for i, (evth, blocks) in enumerate(run):
+                assert evth[1] == i + 1
+                if i == 0 and num_bunches_per_block == 100:
+                    continue  # blocks not read are skipped
+                blocks = list(blocks)
+                for block in blocks[:-1]:
+                    assert block.shape == (num_bunches_per_block, 8)
+                if len(blocks) == 0:
+                    assert expected[i].shape[0] == 0
+                else:
+                    np.testing.assert_array_equal(
+                        np.concatenate(blocks), expected[i]
+                    )
+            assert run.num_events_read == len(expected)
+
+
+def test_catalogue_and_index_read_chunks(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_chunked_bunches_") as tmp:
+        path, expected = iact_harness.run(
+            tmp, {"BUNCH_CHUNK_MIB": BUNCH_CHUNK_MIB}
+        )
+        index = cpw.read_event_index(path)
+        np.testing.assert_array_equal(
+            index["num_bunches"], iact_harness.NUM_BUNCHES
+        )
+        np.testing.assert_array_equal(
+            index["bunches_size"], 32 * np.array(iact_harness.NUM_BUNCHES)
+        )
+        cat = catalogue.scan_tar(path)
+        np.testing.assert_array_equal(
+            cat["num_bunches"], iact_harness.NUM_BUNCHES
+        )
+        np.testing.assert_array_equal(cat["offset"], index["evth_header"])
+        for i in range(len(expected)):
+            evth, bunches = catalogue.read_event(path, cat["offset"][i])
+            np.testing.assert_array_equal(bunches, expected[i])
+        with cpw.IndexedTario(path) as run:
+            for i in [2, 0, 1]:
+                evth, bunches = run[i + 1]
+                np.testing.assert_array_equal(bunches, expected[i])
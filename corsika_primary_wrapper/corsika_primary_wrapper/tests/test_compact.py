@@ -0,0 +1,119 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import struct
+import tempfile
+
+
+def _encode(bunches, modes, origins, resolutions):
+    """
+    Reference of the compact format in iact.c.
+    """
+    num = bunches.shape[0]
+    out = struct.pack("<IIQ", cpw.COMPACT_MAGIC, 8, num)
+    for c in range(8):
+        out += struct.pack("<IIdd", modes[c], 0, origins[c], resolutions[c])
+    max_error = np.zeros(8)
+    for c in range(8):
+        v = bunches[:, c].astype(np.float64)
+        if modes[c] == cpw.COMPACT_CONSTANT:
+            continue
+        elif modes[c] in [cpw.COMPACT_INT16, cpw.COMPACT_INT32]:
+            q = np.round((v - origins[c]) / resolutions[c])
+            data = q.astype(cpw.COMPACT_DTYPES[modes[c]])
+        elif modes[c] == cpw.COMPACT_FLOAT16:
+            data = (v - origins[c]).astype(np.float32).astype(np.float16)
+        else:
+            data = bunches[:, c]
+        column = data.tobytes()
+        out += column + b"\0" * ((8 - len(column) % 8) % 8)
+    return out + max_error.tobytes()
+
+
+def _example_bunches(num, seed):
+    prng = np.random.Generator(np.random.PCG64(seed))
+    bunches = np.zeros(shape=(num, 8), dtype=np.float32)
+    bunches[:, cpw.IX] = prng.uniform(-1e4, 1e4, size=num)
+    bunches[:, cpw.IY] = prng.uniform(-1e4, 1e4, size=num)
+    bunches[:, cpw.ICX] = prng.uniform(-0.1, 0.1, size=num)
+    bunches[:, cpw.ICY] = prng.uniform(-0.1, 0.1, size=num)
+    bunches[:, cpw.ITIME] = prng.uniform(1e3, 1.1e3, size=num)
+    bunches[:, cpw.IZEM] = prng.uniform(1e6, 2e6, size=num)
+    bunches[:, cpw.IBSIZE] = 1.0
+    bunches[:, cpw.IWVL] = prng.uniform(250, 700, size=num)
+    return bunches
+
+
+def test_all_modes():
+    bunches = _example_bunches(num=1001, seed=1)
+    modes = [
+        cpw.COMPACT_INT16,
+        cpw.COMPACT_INT32,
+        cpw.COMPACT_INT16,
+        cpw.COMPACT_INT16,
+        cpw.COMPACT_FLOAT16,
+        cpw.COMPACT_INT16,
+        cpw.COMPACT_CONSTANT,
+        cpw.COMPACT_FLOAT32,
+    ]
+    origins = [0.0, 0.0, 0.0, 0.0, 1e3, 1.5e6, 1.0, 0.0]
+    resolutions = [1.0, 1e-3, 1e-5, 1e-5, 0.0, 100.0, 0.0, 0.0]
+    payload = _encode(bunches, modes, origins, resolutions)
+
+    back, max_error = cpw.compact_decode(payload)
+    assert back.shape == bunches.shape
+    assert back.dtype == np.float32
+    assert max_error.shape == (8,)
+    delta = np.abs(back - bunches)
+    assert np.all(delta[:, cpw.IX] <= 0.5 + 1e-3)
+    assert np.all(delta[:, cpw.IY] <= 0.5e-3 + 1e-3)
+    assert np.all(delta[:, cpw.ICX] <= 0.5e-5 + 1e-7)
+    assert np.all(delta[:, cpw.ITIME] <= 0.1)
+    assert np.all(delta[:, cpw.IZEM] <= 50.0 + 0.2)
+    np.testing.assert_array_equal(back[:, cpw.IBSIZE], 1.0)
+    np.testing.assert_array_equal(back[:, cpw.IWVL], bunches[:, cpw.IWVL])
+
+
+def test_empty():
+    bunches = np.zeros(shape=(0, 8), dtype=np.float32)
+    payload = _encode(
+        bunches, [cpw.COMPACT_CONSTANT] * 8, [0.0] * 8, [0.0] * 8
+    )
+    back, max_error = cpw.compact_decode(payload)
+    assert back.shape == (0, 8)
+
+
+def test_decode_bunches_by_name():
+    bunches = _example_bunches(num=10, seed=2)
+    payload = _encode(
+        bunches, [cpw.COMPACT_FLOAT32] * 8, [0.0] * 8, [0.0] * 8
+    )
+    name = "000000001.cherenkov_bunches.compact"
+    back = cpw._decode_bunches(name, payload)
+    np.testing.assert_array_equal(back, bunches)
+
+
+@pytest.mark.parametrize(
+    "iact_options, resolution",
+    [
+        ({}, [1, 1, 1e-5, 1e-5, 0.1, 100, 0, 0]),
+        ({"COMPACT_RESOLUTION": ["x", 0]}, [0, 1, 1e-5, 1e-5, 0.1, 100, 0, 0]),
+    ],
+)
+def test_run_within_resolution(iact_harness, iact_options, resolution):
+    with tempfile.TemporaryDirectory(prefix="test_compact_") as tmp:
+        path, expected = iact_harness.run(
+            tmp, dict(iact_options, COMPACT_BUNCHES="T")
+        )
+        num_events = 0
+        for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+            assert bunches.shape == expected[i].shape
+            for c in range(8):
+                np.testing.assert_allclose(
+                    bunches[:, c],
+                    expected[i][:, c],
+                    rtol=0,
+                    atol=resolution[c],
+                )
+            num_events += 1
+        assert num_events == len(expected)
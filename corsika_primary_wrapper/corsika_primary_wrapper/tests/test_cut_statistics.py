@@ -0,0 +1,85 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tempfile
+
+
+def _roi_masks(bunches, iact_options):
+    """
+    Reference of iact_roi_accept() in resources/iact.c. Returns the mask of
+    the bunches tested, and rejected by each cut.
+    """
+    b = bunches.astype(np.float64)
+    num = bunches.shape[0]
+    tested = np.zeros(shape=(len(cpw.ROI_CUTS), num), dtype=bool)
+    rejected = np.zeros(shape=(len(cpw.ROI_CUTS), num), dtype=bool)
+    alive = np.ones(num, dtype=bool)
+    for cut, key in enumerate(cpw.ROI_CUTS):
+        if key not in iact_options:
+            continue
+        v = np.array(iact_options[key], ndmin=1)
+        if key == "ROI_DISC_CM":
+            passed = (b[:, 0] - v[0]) ** 2 + (b[:, 1] - v[1]) ** 2 <= v[2] ** 2
+        elif key == "ROI_RECTANGLE_CM":
+            passed = (b[:, 0] >= v[0]) & (b[:, 0] <= v[1])
+            passed &= (b[:, 1] >= v[2]) & (b[:, 1] <= v[3])
+        elif key == "ROI_MAX_INCIDENT_DEG":
+            sin_max = np.sin(np.deg2rad(v[0]))
+            passed = b[:, 2] ** 2 + b[:, 3] ** 2 <= sin_max ** 2
+        elif key == "ROI_WAVELENGTH_NM":
+            w = np.abs(b[:, 7])
+            passed = (b[:, 7] == 0) | ((w >= v[0]) & (w <= v[1]))
+        elif key == "ROI_TIME_WINDOW_NS":
+            t = bunches[:, 4]
+            t0 = t[alive][0] if np.any(alive) else 0.0
+            passed = (t - t0 >= v[0]) & (t - t0 <= v[1])
+        tested[cut] = alive
+        rejected[cut] = alive & ~passed
+        alive = alive & passed
+    return tested, rejected, alive
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {"ROI_DISC_CM": [0, 0, 1e4]},
+        {
+            "ROI_DISC_CM": [5e3, 0, 1.2e4],
+            "ROI_RECTANGLE_CM": [-5e3, 1.5e4, -1e4, 1e4],
+            "ROI_MAX_INCIDENT_DEG": 1.0,
+            "ROI_WAVELENGTH_NM": [300, 500],
+            "ROI_TIME_WINDOW_NS": [0, 25],
+        },
+        {"ROI_TIME_WINDOW_NS": [0, 25], "SINGLE_PASS": "F"},
+        {"ROI_DISC_CM": [0, 0, 1e4], "BUNCH_CHUNK_MIB": 0.01},
+    ],
+)
+def test_bunches_outside_are_dropped(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_cut_statistics_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        kept = [_roi_masks(e, iact_options)[2] for e in expected]
+        iact_harness.assert_tario_equal(
+            path, [e[k] for e, k in zip(expected, kept)]
+        )
+        assert 0 < sum(np.sum(k) for k in kept) < sum(map(len, kept))
+
+
+def test_read_cut_statistics(iact_harness):
+    iact_options = {
+        "ROI_DISC_CM": [0, 0, 1.5e4],
+        "ROI_MAX_INCIDENT_DEG": 1.0,
+        "ROI_TIME_WINDOW_NS": [0, 25],
+    }
+    with tempfile.TemporaryDirectory(prefix="test_cut_statistics_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        stats = cpw.read_cut_statistics(path)
+        assert sorted(stats.keys()) == [1, 2, 3]
+        for i, e in enumerate(expected):
+            tested, rejected, _ = _roi_masks(e, iact_options)
+            s = stats[i + 1]
+            assert s.shape == (len(cpw.ROI_CUTS), len(cpw.ROI_STATISTICS))
+            photons = e[:, 6].astype(np.float64)
+            np.testing.assert_array_equal(s[:, 0], np.sum(tested, axis=1))
+            np.testing.assert_array_equal(s[:, 1], np.sum(rejected, axis=1))
+            np.testing.assert_array_equal(s[:, 2], tested @ photons)
+            np.testing.assert_array_equal(s[:, 3], rejected @ photons)
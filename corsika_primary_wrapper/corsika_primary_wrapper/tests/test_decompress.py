@@ -0,0 +1,63 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import os
+import tempfile
+
+
+def _example_bunches():
+    prng = np.random.Generator(np.random.PCG64(1))
+    return prng.uniform(size=(1000, 8)).astype(np.float32).tobytes()
+
+
+def test_decompress_raw():
+    payload = _example_bunches()
+    assert cpw._decompress("1.cherenkov_bunches.Nx8_float32", payload) == (
+        payload
+    )
+
+
+def test_decompress_zstd():
+    zstandard = pytest.importorskip("zstandard")
+    payload = _example_bunches()
+    compressed = zstandard.ZstdCompressor().compress(payload)
+    name = "1.cherenkov_bunches.Nx8_float32.zst"
+    assert cpw._decompress(name, compressed) == payload
+
+
+def test_decompress_lz4():
+    lz4_frame = pytest.importorskip("lz4.frame")
+    payload = _example_bunches()
+    compressed = lz4_frame.compress(payload)
+    name = "1.cherenkov_bunches.Nx8_float32.lz4"
+    assert cpw._decompress(name, compressed) == payload
+
+
+@pytest.mark.parametrize(
+    "codec, module, flags",
+    [
+        ("zstd", "zstandard", ["-DIACT_ZSTD", "-lzstd"]),
+        ("lz4", "lz4.frame", ["-DIACT_LZ4", "-llz4"]),
+    ],
+)
+def test_compressed_run(iact_harness, codec, module, flags):
+    pytest.importorskip(module)
+    with tempfile.TemporaryDirectory(prefix="test_decompress_") as tmp:
+        harness = iact_harness.compile(os.path.join(tmp, "TestIact"), flags)
+        if harness is None:
+            pytest.skip("Needs the {:s}-library.".format(codec))
+        for iact_options in [
+            {"COMPRESSION": codec},
+            {"COMPRESSION": codec, "SINGLE_PASS": "F"},
+            {"COMPRESSION": codec, "ASYNC_WRITER": "T"},
+        ]:
+            path, expected = harness.run(tmp, iact_options)
+            harness.assert_tario_equal(path, expected)
+
+
+def test_codec_not_compiled_in(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_decompress_") as tmp:
+        path, expected = iact_harness.run(tmp, {"COMPRESSION": "none"})
+        iact_harness.assert_tario_equal(path, expected)
+        run = iact_harness.popen(tmp, path, {"COMPRESSION": "zstd"})
+        assert run.wait() != 0
@@ -0,0 +1,93 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import os
+import tempfile
+
+
+def _write_curve(path, lines):
+    with open(path, "wt") as f:
+        f.write("# wavelength_nm efficiency\n")
+        for wavelength, efficiency in lines:
+            f.write("{:f} {:f}\n".format(wavelength, efficiency))
+    return path
+
+
+def _run(iact_harness, tmp, curves, iact_options={}):
+    paths = [
+        _write_curve(os.path.join(tmp, "{:d}.txt".format(i)), curve)
+        for i, curve in enumerate(curves)
+    ]
+    iact_options = dict(iact_options, DETECTOR_EFFICIENCY=paths)
+    path, expected = iact_harness.run(tmp, iact_options)
+    return list(cpw.Tario(path)), expected
+
+
+def _assert_thinned(iact_harness, got, expected, efficiency):
+    num_kept = 0
+    for i, (evth, bunches) in enumerate(got):
+        mask = iact_harness.kept(expected[i], bunches)
+        np.testing.assert_array_equal(
+            bunches[:, 0:7], expected[i][mask, 0:7]
+        )
+        num_kept += np.sum(mask)
+    num = np.sum(iact_harness.NUM_BUNCHES)
+    std = np.sqrt(num * efficiency * (1 - efficiency))
+    assert abs(num_kept - efficiency * num) <= 5 * std
+
+
+def test_constant_efficiency(iact_harness):
+    """
+    The wavelength is undetermined. It is drawn from 1/wavelength^2 in the
+    band of the evth, 250nm to 700nm.
+    """
+    with tempfile.TemporaryDirectory(prefix="test_detector_eff_") as tmp:
+        got, expected = _run(iact_harness, tmp, [[(200, 0.5), (800, 0.5)]])
+        _assert_thinned(iact_harness, got, expected, 0.5)
+        wavelength = np.concatenate([b[:, cpw.IWVL] for _, b in got])
+        assert np.all(wavelength >= 250)
+        assert np.all(wavelength <= 700)
+        mean = np.log(700 / 250) / (1 / 250 - 1 / 700)
+        assert abs(np.mean(wavelength) - mean) <= 15
+
+
+def test_curves_are_multiplied(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_detector_eff_") as tmp:
+        got, expected = _run(
+            iact_harness,
+            tmp,
+            [[(200, 0.5), (800, 0.5)], [(200, 0.6), (800, 0.6)]],
+        )
+        _assert_thinned(iact_harness, got, expected, 0.3)
+
+
+def test_efficiency_vs_wavelength(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_detector_eff_") as tmp:
+        got, expected = _run(
+            iact_harness, tmp, [[(200, 1.0), (400, 1.0), (400.1, 0.0)]]
+        )
+        wavelength = np.concatenate([b[:, cpw.IWVL] for _, b in got])
+        assert wavelength.shape[0] > 0
+        assert np.all(wavelength <= 400.1)
+
+
+def test_same_primary_same_thinning(iact_harness):
+    runs = []
+    for _ in range(2):
+        with tempfile.TemporaryDirectory(prefix="test_detector_eff_") as tmp:
+            got, _ = _run(iact_harness, tmp, [[(200, 0.5), (800, 0.5)]])
+            runs.append(np.concatenate([b for _, b in got]))
+    np.testing.assert_array_equal(runs[0], runs[1])
+
+
+def test_photo_electrons(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_detector_eff_") as tmp:
+        got, expected = _run(
+            iact_harness,
+            tmp,
+            [[(200, 0.5), (800, 0.5)]],
+            {"DETECTOR_EFFICIENCY_PHOTO_ELECTRONS": "T"},
+        )
+        _assert_thinned(iact_harness, got, expected, 0.5)
+        wavelength = np.concatenate([b[:, cpw.IWVL] for _, b in got])
+        assert np.all(wavelength <= -250)
+        assert np.all(wavelength >= -700)
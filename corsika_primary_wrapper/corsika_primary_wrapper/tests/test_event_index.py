@@ -0,0 +1,75 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tarfile
+import os
+import tempfile
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {},
+        {"SINGLE_PASS": "F"},
+        {"ASYNC_WRITER": "T"},
+        {"BUNCHCODEC": "T"},
+    ],
+)
+def test_index_from_tail_and_random_access(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_event_index_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+
+        index = cpw.read_event_index(path)
+        np.testing.assert_array_equal(index["event_number"], [1, 2, 3])
+        np.testing.assert_array_equal(
+            index["num_bunches"], iact_harness.NUM_BUNCHES
+        )
+        with tarfile.open(path) as tar:
+            members = tar.getmembers()
+        assert members[-1].name == cpw.TARIO_INDEX_FILENAME
+        offsets = {m.name: (m.offset, m.size) for m in members}
+        for r in index:
+            n = r["event_number"]
+            evth = offsets[cpw.TARIO_EVTH_FILENAME.format(n)]
+            assert (r["evth_header"], r["evth_size"]) == evth
+            bunches_name = [
+                name
+                for name in offsets
+                if name.startswith(cpw.TARIO_BUNCHES_FILENAME.format(n))
+            ]
+            assert len(bunches_name) == 1
+            bunches = offsets[bunches_name[0]]
+            assert (r["bunches_header"], r["bunches_size"]) == bunches
+
+        with cpw.IndexedTario(path) as run:
+            assert len(run) == 3
+            assert run.runh[0] == cpw.RUNH_MARKER_FLOAT32
+            for event_number in [3, 1, 2]:
+                evth, bunches = run[event_number]
+                assert evth[1] == event_number
+                np.testing.assert_array_equal(
+                    bunches, expected[event_number - 1]
+                )
+            with pytest.raises(KeyError):
+                run[4]
+
+        # sequential reading stops at the index
+        iact_harness.assert_tario_equal(path, expected)
+
+
+def test_no_index(iact_harness):
+    """
+    A tar written before the event-index, i.e. cut before its member.
+    """
+    with tempfile.TemporaryDirectory(prefix="test_event_index_") as tmp:
+        path, expected = iact_harness.run(tmp)
+        with tarfile.open(path) as tar:
+            header = tar.getmember(cpw.TARIO_INDEX_FILENAME).offset
+        with open(path, "rb") as f:
+            payload = f.read(header)
+        old_path = os.path.join(tmp, "old.tar")
+        with open(old_path, "wb") as f:
+            f.write(payload + b"\0" * 2 * cpw.TAR_BLOCK_SIZE)
+
+        assert cpw.read_event_index(old_path) is None
+        iact_harness.assert_tario_equal(old_path, expected)
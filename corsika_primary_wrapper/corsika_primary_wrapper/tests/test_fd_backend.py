@@ -0,0 +1,22 @@
+import pytest
+import tempfile
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {"TAR_BUFFER_MIB": 0.004},
+        {"TAR_BUFFER_MIB": 0.004, "SINGLE_PASS": "F"},
+        {"TAR_BUFFER_MIB": 0.004, "ASYNC_WRITER": "T"},
+        {"TAR_BUFFER_MIB": 0.1, "BUNCHCODEC": "T"},
+        {"TAR_O_DIRECT": "T"},
+        {"TAR_O_DIRECT": "T", "TAR_BUFFER_MIB": 0.004},
+    ],
+)
+def test_output_does_not_change(iact_harness, iact_options):
+    """
+    With TAR_BUFFER_MIB 0.004, the buffer is smaller than the members.
+    """
+    with tempfile.TemporaryDirectory(prefix="test_fd_backend_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        iact_harness.assert_tario_equal(path, expected)
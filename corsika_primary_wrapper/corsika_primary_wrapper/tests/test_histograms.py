@@ -0,0 +1,75 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tarfile
+import tempfile
+
+HISTOGRAM_OPTIONS = {
+    "HISTOGRAM_XY_CM": [-2e4, 2e4, 8, -1e4, 1e4, 4],
+    "HISTOGRAM_R_CM": [0, 3e4, 30],
+    "HISTOGRAM_TIME_NS": [100, 150, 25],
+    "HISTOGRAM_WAVELENGTH_NM": [0, 1000, 10],
+}
+
+
+def _bins(values, lo, hi, num):
+    """
+    Reference of iact_histograms_find_bins() in resources/iact.c.
+    """
+    f = (values.astype(np.float64) - lo) * (num / (hi - lo))
+    return np.where((f >= 0) & (f < num), f.astype(np.int64), -1)
+
+
+def _histograms(bunches):
+    x, y = bunches[:, cpw.IX], bunches[:, cpw.IY]
+    xy = HISTOGRAM_OPTIONS["HISTOGRAM_XY_CM"]
+    bx = _bins(x, *xy[0:3])
+    by = _bins(y, *xy[3:6])
+    bins = {
+        "xy": np.where((bx < 0) | (by < 0), -1, bx * xy[5] + by),
+        "r": _bins(
+            np.sqrt(x * x + y * y), *HISTOGRAM_OPTIONS["HISTOGRAM_R_CM"]
+        ),
+        "time": _bins(
+            bunches[:, cpw.ITIME], *HISTOGRAM_OPTIONS["HISTOGRAM_TIME_NS"]
+        ),
+        "wavelength": _bins(
+            np.abs(bunches[:, cpw.IWVL]),
+            *HISTOGRAM_OPTIONS["HISTOGRAM_WAVELENGTH_NM"]
+        ),
+    }
+    shapes = {"xy": (xy[2], xy[5]), "r": 30, "time": 25, "wavelength": 10}
+    out = {}
+    for name in cpw.HISTOGRAMS:
+        counts = np.zeros(np.prod(shapes[name]))
+        valid = bins[name] >= 0
+        np.add.at(counts, bins[name][valid], bunches[valid, cpw.IBSIZE])
+        out[name] = counts.reshape(shapes[name])
+    return out
+
+
+@pytest.mark.parametrize(
+    "roi_options", [{}, {"ROI_DISC_CM": [0, 0, 1e4]}, {"SINGLE_PASS": "F"}]
+)
+def test_read_histograms(iact_harness, roi_options):
+    """
+    The cuts of the region-of-interest apply before the histograms.
+    """
+    iact_options = dict(HISTOGRAM_OPTIONS, **roi_options)
+    with tempfile.TemporaryDirectory(prefix="test_histograms_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        hists = cpw.read_histograms(path)
+        assert sorted(hists.keys()) == [1, 2, 3]
+        for i, bunches in enumerate(expected):
+            if roi_options.get("ROI_DISC_CM"):
+                b = bunches.astype(np.float64)
+                bunches = bunches[b[:, 0] ** 2 + b[:, 1] ** 2 <= 1e4 ** 2]
+            hists_ref = _histograms(bunches)
+            assert sorted(hists[i + 1].keys()) == sorted(cpw.HISTOGRAMS)
+            for name in cpw.HISTOGRAMS:
+                np.testing.assert_array_equal(
+                    hists[i + 1][name], hists_ref[name]
+                )
+        with tarfile.open(path) as tar:
+            names = tar.getnames()
+        assert not any("cherenkov_bunches" in name for name in names)
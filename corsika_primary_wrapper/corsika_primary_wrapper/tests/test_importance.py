@@ -0,0 +1,75 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import os
+import tempfile
+
+CURVE = [(0.0, 0.2), (3e4, 1.0)]
+
+
+def _probability(bunches):
+    b = bunches.astype(np.float64)
+    r = np.hypot(b[:, cpw.IX], b[:, cpw.IY])
+    return np.interp(r, [x for x, _ in CURVE], [y for _, y in CURVE])
+
+
+def _run(iact_harness, tmp, iact_options={}):
+    curve_path = os.path.join(tmp, "importance.txt")
+    with open(curve_path, "wt") as f:
+        f.write("# r_cm probability\n")
+        for r, p in CURVE:
+            f.write("{:f} {:f}\n".format(r, p))
+    return iact_harness.run(tmp, iact_options, ["IMPSAMP", curve_path])
+
+
+@pytest.mark.parametrize(
+    "iact_options", [{}, {"SINGLE_PASS": "F"}, {"BUNCHCODEC": "T"}]
+)
+def test_tario_skips_importance_statistics(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_importance_") as tmp:
+        path, expected = _run(iact_harness, tmp, iact_options)
+        p = np.concatenate([_probability(e) for e in expected])
+        num_kept = 0
+        num_events = 0
+        for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+            assert evth[1] == i + 1
+            mask = iact_harness.kept(expected[i], bunches)
+            others = [c for c in range(8) if c != cpw.IBSIZE]
+            np.testing.assert_array_equal(
+                bunches[:, others], expected[i][mask][:, others]
+            )
+            np.testing.assert_allclose(
+                bunches[:, cpw.IBSIZE] * _probability(expected[i][mask]),
+                1.0,
+                rtol=1e-5,
+            )
+            num_kept += np.sum(mask)
+            num_events += 1
+        assert num_events == len(expected)
+        assert abs(num_kept - np.sum(p)) <= 5 * np.sqrt(np.sum(p * (1 - p)))
+
+
+def test_read_importance_statistics(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_importance_") as tmp:
+        path, expected = _run(iact_harness, tmp)
+        stats = cpw.read_importance_statistics(path)
+        assert sorted(stats.keys()) == [1, 2, 3]
+        for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+            s = dict(zip(cpw.IMPORTANCE_STATISTICS, stats[i + 1]))
+            assert s["num_bunches"] == expected[i].shape[0]
+            assert s["num_bunches_kept"] == bunches.shape[0]
+            assert s["num_photons"] == np.sum(expected[i][:, cpw.IBSIZE])
+            np.testing.assert_allclose(
+                s["num_photons_kept"],
+                np.sum(bunches[:, cpw.IBSIZE].astype(np.float64)),
+                rtol=1e-6,
+            )
+
+
+def test_same_primary_same_sampling(iact_harness):
+    runs = []
+    for _ in range(2):
+        with tempfile.TemporaryDirectory(prefix="test_importance_") as tmp:
+            path, _ = _run(iact_harness, tmp)
+            runs.append(np.concatenate([b for _, b in cpw.Tario(path)]))
+    np.testing.assert_array_equal(runs[0], runs[1])
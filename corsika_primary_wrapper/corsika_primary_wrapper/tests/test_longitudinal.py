@@ -0,0 +1,58 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tempfile
+
+
+def _read_arrow_longitudinal(path):
+    import pyarrow
+    import pyarrow.ipc
+
+    out = {}
+    with pyarrow.memory_map(path, "r") as source:
+        reader = pyarrow.ipc.open_stream(source)
+        while True:
+            try:
+                _, metadata = reader.read_next_batch_with_custom_metadata()
+            except StopIteration:
+                break
+            evth = cpw._arrow_metadata_block(metadata, "evth.float32")
+            raw = cpw._arrow_metadata_block(metadata, "longitudinal.float64")
+            out[int(evth[1])] = cpw.longitudinal_decode(raw.tobytes())
+    return out
+
+
+@pytest.mark.parametrize("iact_options", [{}, {"SINGLE_PASS": "F"}])
+def test_tario_skips_longitudinal(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_longitudinal_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options, ["LONGI"])
+        iact_harness.assert_tario_equal(path, expected)
+
+
+@pytest.mark.parametrize("output_format", ["tar", "arrow"])
+def test_read_longitudinal(iact_harness, output_format):
+    with tempfile.TemporaryDirectory(prefix="test_longitudinal_") as tmp:
+        if output_format == "tar":
+            path, _ = iact_harness.run(tmp, {}, ["LONGI"])
+            longitudinal = cpw.read_longitudinal(path)
+        else:
+            pytest.importorskip("pyarrow")
+            path, _ = iact_harness.run(
+                tmp, {"OUTPUT_FORMAT": "arrow"}, ["LONGI"]
+            )
+            longitudinal = _read_arrow_longitudinal(path)
+        assert sorted(longitudinal.keys()) == [1, 2, 3]
+        for i in range(len(iact_harness.NUM_BUNCHES)):
+            (record,) = longitudinal[i + 1]
+            assert record["type"] == 1
+            assert record["thickstep_g_per_cm2"] == 10.0
+            np.testing.assert_array_equal(
+                record["distributions"],
+                1000.0 * i + np.arange(45).reshape((9, 5)),
+            )
+
+
+def test_no_longitudinal_without_longi(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_longitudinal_") as tmp:
+        path, _ = iact_harness.run(tmp)
+        assert cpw.read_longitudinal(path) == {}
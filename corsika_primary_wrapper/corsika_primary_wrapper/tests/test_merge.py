@@ -0,0 +1,59 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tempfile
+
+CELL_SIZE = [1e4, 1e4, 0.025, 0.025, 25.0]
+
+
+def _merge(bunches):
+    """
+    Reference of iact_merge_add() in resources/iact.c. The merged bunches
+    are in the order in which their cells were first hit.
+    """
+    b = bunches.astype(np.float64)
+    keys = np.floor(b[:, 0:5] / np.array(CELL_SIZE)).astype(np.int64)
+    _, first, cell = np.unique(
+        keys, axis=0, return_index=True, return_inverse=True
+    )
+    cell = cell.ravel()
+    order = np.argsort(np.argsort(first))
+    weight = np.zeros(first.shape[0])
+    np.add.at(weight, order[cell], b[:, cpw.IBSIZE])
+    merged = np.zeros(shape=(first.shape[0], 8))
+    np.add.at(merged, order[cell], b * b[:, cpw.IBSIZE, np.newaxis])
+    merged /= weight[:, np.newaxis]
+    merged[:, cpw.IBSIZE] = weight
+    return merged.astype(np.float32)
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {},
+        {"ASYNC_WRITER": "T"},
+        {"BUNCH_CHUNK_MIB": 0.01},
+    ],
+)
+def test_read_merge_statistics(iact_harness, iact_options):
+    iact_options = dict(iact_options, MERGE_BUNCHES=CELL_SIZE)
+    with tempfile.TemporaryDirectory(prefix="test_merge_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        stats = cpw.read_merge_statistics(path)
+        assert sorted(stats.keys()) == [1, 2, 3]
+        num_events = 0
+        for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+            before, after = stats[i + 1]
+            assert before == expected[i].shape[0]
+            assert after == bunches.shape[0]
+            assert after < before or before == 0
+            np.testing.assert_allclose(
+                np.sum(bunches[:, cpw.IBSIZE]),
+                np.sum(expected[i][:, cpw.IBSIZE]),
+            )
+            if "BUNCH_CHUNK_MIB" not in iact_options:
+                np.testing.assert_allclose(
+                    bunches, _merge(expected[i]), rtol=1e-6, atol=1e-6
+                )
+            num_events += 1
+        assert num_events == len(expected)
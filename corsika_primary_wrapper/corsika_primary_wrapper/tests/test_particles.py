@@ -0,0 +1,64 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import os
+import pytest
+import tarfile
+import tempfile
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [
+        {"PARTICLES": "T"},
+        {"PARTICLES": "T", "SINGLE_PASS": "F"},
+        {"PARTICLES": "T", "ASYNC_WRITER": "T"},
+        {"PARTICLES": "T", "ARENA_RAM_CAP_MIB": 0.001},
+    ],
+)
+def test_read_particles(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_particles_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        iact_harness.assert_tario_equal(path, expected)
+        expected_particles = iact_harness.expected_particles(tmp)
+        particles = cpw.read_particles(path)
+        assert sorted(particles.keys()) == [1, 2, 3]
+        for i, particles_ref in enumerate(expected_particles):
+            np.testing.assert_array_equal(particles[i + 1], particles_ref)
+
+
+def test_cuts(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_particles_") as tmp:
+        path, _ = iact_harness.run(
+            tmp,
+            {
+                "PARTICLES": "T",
+                "PARTICLE_IDS": [5, 6, 13],
+                "PARTICLE_MIN_MOMENTUM_GEV": 3.0,
+            },
+        )
+        particles = cpw.read_particles(path)
+        for i, p in enumerate(iact_harness.expected_particles(tmp)):
+            ids = (p[:, 0] / 1000).astype(np.int64)
+            momentum = np.linalg.norm(p[:, 1:4].astype(np.float64), axis=1)
+            mask = np.isin(ids, [5, 6, 13]) & (momentum >= 3.0)
+            assert 0 < np.sum(mask) < p.shape[0]
+            np.testing.assert_array_equal(particles[i + 1], p[mask])
+
+
+def test_no_particles_by_default(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_particles_") as tmp:
+        path, _ = iact_harness.run(tmp)
+        with tarfile.open(path) as tar:
+            names = tar.getnames()
+        assert not any(".particles." in name for name in names)
+        assert cpw.read_particles(path) == {}
+
+
+def test_arrow_is_rejected(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_particles_") as tmp:
+        proc = iact_harness.popen(
+            tmp,
+            os.path.join(tmp, "run.arrow"),
+            {"PARTICLES": "T", "OUTPUT_FORMAT": "arrow"},
+        )
+        assert proc.wait() != 0
@@ -0,0 +1,61 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import tempfile
+
+NUM_REUSES = 3
+
+
+def _cores(evth):
+    return [
+        (evth[cpw.I_EVTH_X_CORE_CM(r)], evth[cpw.I_EVTH_Y_CORE_CM(r)])
+        for r in range(1, NUM_REUSES + 1)
+    ]
+
+
+def test_reuse_tario(iact_harness):
+    """
+    Each reuse has a member with the bunches inside the disc of interest,
+    even when it has no bunches.
+    """
+    iact_options = {"ROI_DISC_CM": [0, 0, 1e4]}
+    with tempfile.TemporaryDirectory(prefix="test_reuse_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options, ["CSCAT"])
+        num_events = 0
+        for i, (evth, bunches) in enumerate(cpw.ReuseTario(path)):
+            assert evth[cpw.I_EVTH_NUM_REUSES_OF_CHERENKOV_EVENT] == NUM_REUSES
+            assert len(bunches) == NUM_REUSES
+            for r, (xc, yc) in enumerate(_cores(evth)):
+                assert abs(xc) <= 5e3 and abs(yc) <= 5e3
+                e = expected[i].astype(np.float64)
+                xs = (e[:, 0] + xc).astype(np.float32)
+                ys = (e[:, 1] + yc).astype(np.float32)
+                inside = xs.astype(np.float64) ** 2 + ys ** 2 <= 1e4 ** 2
+                assert bunches[r].shape == (np.sum(inside), 8)
+                np.testing.assert_array_equal(bunches[r][:, 0], xs[inside])
+                np.testing.assert_array_equal(bunches[r][:, 1], ys[inside])
+                np.testing.assert_array_equal(
+                    bunches[r][:, 2:], expected[i][inside, 2:]
+                )
+            num_events += 1
+        assert num_events == len(expected)
+
+        stats = cpw.read_cut_statistics(path)
+        disc = cpw.ROI_CUTS.index("ROI_DISC_CM")
+        for i in range(len(expected)):
+            assert stats[i + 1][disc][0] == NUM_REUSES * expected[i].shape[0]
+
+
+def test_same_primary_same_cores(iact_harness):
+    cores = []
+    for _ in range(2):
+        with tempfile.TemporaryDirectory(prefix="test_reuse_") as tmp:
+            path, _ = iact_harness.run(tmp, {}, ["CSCAT"])
+            cores.append([_cores(evth) for evth, _ in cpw.Tario(path)])
+    assert cores[0] == cores[1]
+    assert cores[0][0] != cores[0][1]
+
+
+def test_without_roi_bunches_are_written_once(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_reuse_") as tmp:
+        path, expected = iact_harness.run(tmp, {}, ["CSCAT"])
+        iact_harness.assert_tario_equal(path, expected)
@@ -0,0 +1,42 @@
+import os
+import pytest
+import tempfile
+import threading
+
+
+@pytest.mark.parametrize("single_pass", ["T", "F"])
+def test_regular_file(iact_harness, single_pass):
+    with tempfile.TemporaryDirectory(prefix="test_single_pass_") as tmp:
+        path, expected = iact_harness.run(tmp, {"SINGLE_PASS": single_pass})
+        iact_harness.assert_tario_equal(path, expected)
+
+
+def test_fifo_falls_back_to_buffer(iact_harness):
+    """
+    A FIFO can not seek back to patch the member's header. Even with
+    SINGLE_PASS T, iact.c buffers each event's bunches.
+    """
+    with tempfile.TemporaryDirectory(prefix="test_single_pass_") as tmp:
+        fifo_path = os.path.join(tmp, "run.fifo")
+        os.mkfifo(fifo_path)
+        received = []
+
+        def read_fifo():
+            with open(fifo_path, "rb") as f:
+                received.append(f.read())
+
+        reader = threading.Thread(target=read_fifo)
+        reader.start()
+        rc = iact_harness.popen(tmp, fifo_path, {"SINGLE_PASS": "T"}).wait()
+        if rc != 0 and reader.is_alive():
+            try:  # release the reader when the fifo was never opened
+                os.close(os.open(fifo_path, os.O_WRONLY | os.O_NONBLOCK))
+            except OSError:
+                pass
+        reader.join()
+        assert rc == 0
+
+        path = os.path.join(tmp, "run.tar")
+        with open(path, "wb") as f:
+            f.write(received[0])
+        iact_harness.assert_tario_equal(path, iact_harness.expected(tmp))
@@ -0,0 +1,72 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import pytest
+import tempfile
+
+EMISSION_HEIGHT_BIN_CM = 120e5 / 1024
+
+
+@pytest.mark.parametrize(
+    "iact_options",
+    [{"SUMMARY": "T"}, {"SUMMARY": "T", "BUNCHCODEC": "T"}],
+)
+def test_tario_skips_summary(iact_harness, iact_options):
+    with tempfile.TemporaryDirectory(prefix="test_summary_") as tmp:
+        path, expected = iact_harness.run(tmp, iact_options)
+        iact_harness.assert_tario_equal(path, expected)
+
+
+def test_read_summaries(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_summary_") as tmp:
+        path, expected = iact_harness.run(tmp, {"SUMMARY": "T"})
+        summaries = cpw.read_summaries(path)
+        assert sorted(summaries.keys()) == [1, 2, 3]
+        for i, bunches in enumerate(expected):
+            s = dict(zip(cpw.SUMMARY, summaries[i + 1]))
+            b = bunches.astype(np.float64)
+            assert s["num_bunches"] == bunches.shape[0]
+            assert s["num_photons"] == np.sum(b[:, cpw.IBSIZE])
+            if bunches.shape[0] == 0:
+                assert np.isnan(s["x_mean_cm"])
+                continue
+            assert s["x_min_cm"] == np.min(b[:, cpw.IX])
+            assert s["x_max_cm"] == np.max(b[:, cpw.IX])
+            assert s["y_min_cm"] == np.min(b[:, cpw.IY])
+            assert s["y_max_cm"] == np.max(b[:, cpw.IY])
+            assert s["time_min_ns"] == np.min(b[:, cpw.ITIME])
+            assert s["time_max_ns"] == np.max(b[:, cpw.ITIME])
+            for name, c in [
+                ("x_{:s}_cm", cpw.IX),
+                ("y_{:s}_cm", cpw.IY),
+                ("cx_{:s}_rad", cpw.ICX),
+                ("cy_{:s}_rad", cpw.ICY),
+                ("time_{:s}_ns", cpw.ITIME),
+            ]:
+                np.testing.assert_allclose(
+                    s[name.format("mean")], np.mean(b[:, c])
+                )
+                np.testing.assert_allclose(
+                    s[name.format("std")], np.std(b[:, c])
+                )
+            np.testing.assert_allclose(
+                s["xy_cov_cm2"],
+                np.cov(b[:, cpw.IX], b[:, cpw.IY], bias=True)[0, 1],
+                rtol=1e-6,
+                atol=1e-6 * np.std(b[:, cpw.IX]) * np.std(b[:, cpw.IY]),
+            )
+            for p in [5, 16, 50, 84, 95]:
+                key = "emission_height_p{:02d}_cm".format(p)
+                ref = np.percentile(b[:, cpw.IZEM], p)
+                assert abs(s[key] - ref) <= 2 * EMISSION_HEIGHT_BIN_CM
+
+
+def test_roi_applies_before(iact_harness):
+    with tempfile.TemporaryDirectory(prefix="test_summary_") as tmp:
+        path, expected = iact_harness.run(
+            tmp, {"SUMMARY": "T", "ROI_DISC_CM": [0, 0, 1e4]}
+        )
+        summaries = cpw.read_summaries(path)
+        for i, (evth, bunches) in enumerate(cpw.Tario(path)):
+            s = dict(zip(cpw.SUMMARY, summaries[i + 1]))
+            assert s["num_bunches"] == bunches.shape[0]
+            assert s["num_bunches"] < expected[i].shape[0] or i == 1
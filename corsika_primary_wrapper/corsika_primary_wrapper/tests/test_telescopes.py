@@ -0,0 +1,66 @@
+import corsika_primary_wrapper as cpw
+import numpy as np
+import tempfile
+
+
+def _hits(bunches, telescope):
+    """
+    Returns the mask of the bunches which hit the detector-sphere, and
+    their x, y on the plane of its center relative to it.
+    """
+    x, y, z, r = telescope
+    b = bunches.astype(np.float64)
+    cx, cy = b[:, 2], b[:, 3]
+    cz = np.sqrt(1 - cx ** 2 - cy ** 2)
+    dx, dy = x - b[:, 0], y - b[:, 1]
+    s = -dx * cx - dy * cy + z * cz
+    hit = dx ** 2 + dy ** 2 + z ** 2 - s ** 2 <= r ** 2
+    x_at_z = b[hit, 0] - cx[hit] / cz[hit] * z - x
+    y_at_z = b[hit, 1] - cy[hit] / cz[hit] * z - y
+    return hit, x_at_z, y_at_z
+
+
+def _assert_telescope_tario(iact_harness, args, num_reuses):
+    with tempfile.TemporaryDirectory(prefix="test_telescopes_") as tmp:
+        path, expected = iact_harness.run(tmp, {}, ["TELESCOPE"] + args)
+        run = cpw.TelescopeTario(path)
+        telescopes = np.array(
+            [
+                [(i % 3 - 1) * 1e4, (i // 3 - 1) * 1e4, (i % 2) * 500, 2e3]
+                for i in range(9)
+            ]
+        )
+        np.testing.assert_array_equal(run.telescopes, telescopes)
+        num_events = 0
+        num_hits = 0
+        for i, (evth, bunches) in enumerate(run):
+            assert evth[1] == i + 1
+            for r in range(1, num_reuses + 1):
+                core = np.zeros(4)
+                if num_reuses > 1:
+                    core[0] = evth[cpw.I_EVTH_X_CORE_CM(r)]
+                    core[1] = evth[cpw.I_EVTH_Y_CORE_CM(r)]
+                for t, telescope in enumerate(run.telescopes):
+                    hit, x_at_z, y_at_z = _hits(expected[i], telescope - core)
+                    if np.sum(hit) == 0:
+                        assert (r, t + 1) not in bunches
+                        continue
+                    got = bunches[(r, t + 1)]
+                    assert got.shape == (np.sum(hit), 8)
+                    np.testing.assert_allclose(got[:, 0], x_at_z, atol=1e-2)
+                    np.testing.assert_allclose(got[:, 1], y_at_z, atol=1e-2)
+                    np.testing.assert_array_equal(
+                        got[:, 2:4], expected[i][hit, 2:4]
+                    )
+                    num_hits += np.sum(hit)
+            num_events += 1
+        assert num_events == len(expected)
+        assert num_hits > 0
+
+
+def test_telescope_tario(iact_harness):
+    _assert_telescope_tario(iact_harness, [], num_reuses=1)
+
+
+def test_telescope_tario_with_reuse(iact_harness):
+    _assert_telescope_tario(iact_harness, ["CSCAT"], num_reuses=3)
@@ -15,6 +15,10 @@ setuptools.setup(
     author_email="sebastian-achim.mueller@mpi-hd.mpg.de",
     packages=["corsika_primary_wrapper",],
     package_data={"corsika_primary_wrapper": ["tests/resources/*",]},
+    extras_require={
+        "compression": ["zstandard", "lz4"],
+        "arrow": ["pyarrow"],
+    },
     classifiers=[
         "Programming Language :: Python :: 3",
         "License :: OSI Approved :: GNU General Public License v3 (GPLv3)",
@@ -6,7 +6,9 @@ Download and install CORSIKA for the Cherenkov-plenoscope.
 Usage: install.py --install_path=PATH \
                   --username=USERNAME \
                   --password=PASSWORD \
-                  [--resource_path=PATH]
+                  [--resource_path=PATH] \
+                  [--with_zstd] \
+                  [--with_lz4]
 
 Options:
     --install_path=PATH     Install-path for CORSIKA.
@@ -14,6 +16,10 @@ Options:
     --password=PASSWORD     Password fot the KIT CORSIKA ftp-server.
     --resource_path=PATH    [default: ./resources] The resources for this
                             particular flavor of CORSIKA.
+    --with_zstd             Compile the modified iact.c with zstd-compression.
+                            Needs libzstd and its header.
+    --with_lz4              Compile the modified iact.c with lz4-compression.
+                            Needs liblz4 and its header.
 
 Std-out and std-error of 'coconut_configure' and 'coconut_make' are written to
 text-files in the install-path.
@@ -56,9 +62,34 @@ def patch(original_path, diff_path, out_path):
     subprocess.call(["patch", original_path, diff_path, "-o", out_path])
 
 
-def call_and_save_std(target, stdout_path, stderr_path, stdin=None):
+def call_and_save_std(
+    target, stdout_path, stderr_path, stdin=None, env=None
+):
     with open(stdout_path, "w") as stdout, open(stderr_path, "w") as stderr:
-        subprocess.call(target, stdout=stdout, stderr=stderr, stdin=stdin)
+        subprocess.call(
+            target, stdout=stdout, stderr=stderr, stdin=stdin, env=env
+        )
+
+
+def compile_environment(with_zstd, with_lz4):
+    """
+    Environment for coconut's configure, which passes CPPFLAGS and LIBS on to
+    the compilation of iact.c. The asynchronous writer of iact.c needs
+    pthreads, which glibc < 2.34 has in a separate library.
+    """
+    env = dict(os.environ)
+    cppflags = []
+    libs = ["-pthread"]
+    if with_zstd:
+        cppflags.append("-DIACT_ZSTD")
+        libs.append("-lzstd")
+    if with_lz4:
+        cppflags.append("-DIACT_LZ4")
+        libs.append("-llz4")
+    if cppflags:
+        env["CPPFLAGS"] = " ".join([env.get("CPPFLAGS", "")] + cppflags)
+    env["LIBS"] = " ".join([env.get("LIBS", "")] + libs)
+    return env
 
 
 def download_corsika_tar(
@@ -83,7 +114,12 @@ def download_corsika_tar(
 
 
 def install(
-    corsika_tar_path, install_path, resource_path, modify,
+    corsika_tar_path,
+    install_path,
+    resource_path,
+    modify,
+    with_zstd=False,
+    with_lz4=False,
 ):
     install_path = os.path.abspath(install_path)
     resource_path = os.path.abspath(resource_path)
@@ -111,6 +147,9 @@ def install(
         stdout_path=join(install_path, "coconut_configure.stdout"),
         stderr_path=join(install_path, "coconut_configure.stderr"),
         stdin=open("/dev/null", "r"),
+        env=compile_environment(
+            with_zstd=modify and with_zstd, with_lz4=modify and with_lz4
+        ),
     )
 
     if modify:
@@ -121,6 +160,17 @@ def install(
         shutil.copy(
             join(resource_path, "microtar.h"), join("bernlohr", "microtar.h")
         )
+        shutil.copy(
+            join(resource_path, "microtar_fd.h"),
+            join("bernlohr", "microtar_fd.h"),
+        )
+        shutil.copy(
+            join(resource_path, "bunchcodec.h"),
+            join("bernlohr", "bunchcodec.h"),
+        )
+        shutil.copy(
+            join(resource_path, "arrowipc.h"), join("bernlohr", "arrowipc.h")
+        )
         shutil.copy(join(resource_path, "iact.c"), join("bernlohr", "iact.c"))
 
     # coconut build
@@ -194,6 +244,8 @@ def main():
                 install_path=join(install_path, "modified"),
                 resource_path=resource_path,
                 modify=True,
+                with_zstd=args["--with_zstd"],
+                with_lz4=args["--with_lz4"],
             )
 
     except docopt.DocoptExit as e:
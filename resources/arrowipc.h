@@ -0,0 +1,502 @@
+/**
+ * arrowipc
+ * ========
+ *
+ * Write the Apache Arrow IPC streaming format with columns of float32.
+ * No dependencies. The flatbuffers of the messages are built by hand.
+ *
+ * A stream is:
+ *
+ *   schema-message                      names of the columns, metadata
+ *   record-batch-message, body          one per batch, optional metadata
+ *   ...
+ *   end-of-stream                       0xFFFFFFFF 0x00000000
+ *
+ * Each message is 0xFFFFFFFF, int32 size of the flatbuffer, the flatbuffer
+ * padded to 8 bytes, and the body. The body of a batch has one buffer per
+ * column, each padded to 8 bytes. The columns have no nulls.
+ *
+ * Usage:
+ *
+ *   arrowipc_open(&s, "run.arrow");
+ *   arrowipc_write_schema(&s, 2, names, 1, keys, values);
+ *   arrowipc_write_batch(&s, num_rows, 2, 1, keys, values);
+ *   arrowipc_write_column(&s, x, num_rows*4);
+ *   arrowipc_end_column(&s);
+ *   arrowipc_write_column(&s, y, num_rows*4);
+ *   arrowipc_end_column(&s);
+ *   arrowipc_close(&s);
+ *
+ * Metadata-values are strings, i.e. binary values must be encoded e.g. with
+ * base64 by the caller.
+ */
+
+#ifndef ARROWIPC_H
+#define ARROWIPC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define ARROWIPC_CONTINUATION 0xFFFFFFFFu
+#define ARROWIPC_METADATA_VERSION_V5 4
+#define ARROWIPC_HEADER_SCHEMA 1
+#define ARROWIPC_HEADER_RECORD_BATCH 3
+#define ARROWIPC_TYPE_FLOATING_POINT 3
+#define ARROWIPC_PRECISION_SINGLE 1
+
+enum {
+  ARROWIPC_ESUCCESS     =  0,
+  ARROWIPC_EFAILURE     = -1,
+  ARROWIPC_EOPENFAIL    = -2,
+  ARROWIPC_EWRITEFAIL   = -3,
+  ARROWIPC_ENOMEM       = -4,
+  ARROWIPC_EBADSIZE     = -5
+};
+
+typedef struct {
+  char *data;
+  uint64_t size;
+  uint64_t capacity;
+} arrowipc_fb_t;
+
+typedef struct {
+  FILE *stream;
+  uint64_t pos;
+  uint64_t column_size;
+  uint64_t column_written;
+  arrowipc_fb_t fb;
+} arrowipc_t;
+
+const char* arrowipc_strerror(int64_t err);
+
+int64_t arrowipc_open(arrowipc_t *s, const char *filename);
+int64_t arrowipc_write_schema(
+  arrowipc_t *s,
+  uint64_t num_columns,
+  const char **names,
+  uint64_t num_metadata,
+  const char **keys,
+  const char **values);
+int64_t arrowipc_write_batch(
+  arrowipc_t *s,
+  uint64_t num_rows,
+  uint64_t num_columns,
+  uint64_t num_metadata,
+  const char **keys,
+  const char **values);
+int64_t arrowipc_write_column(arrowipc_t *s, const void *data, uint64_t size);
+int64_t arrowipc_end_column(arrowipc_t *s);
+int64_t arrowipc_close(arrowipc_t *s);
+
+
+/* flatbuffer builder, front to back, offsets are patched afterwards */
+
+typedef struct {
+  uint16_t size;        /* 0: the field is absent */
+  const void *value;    /* NULL: an offset which is patched later */
+} _arrowipc_slot_t;
+
+static uint64_t _arrowipc_round_up(uint64_t n, uint64_t incr) {
+  return n + (incr - n % incr) % incr;
+}
+
+static int64_t _arrowipc_fb_put(
+  arrowipc_fb_t *fb,
+  const void *data,
+  uint64_t size) {
+  if (fb->size + size > fb->capacity) {
+    uint64_t capacity = fb->capacity ? 2*fb->capacity : 1024;
+    char *tmp;
+    while (capacity < fb->size + size) {
+      capacity *= 2;
+    }
+    tmp = (char *)realloc(fb->data, capacity);
+    if (tmp == NULL) {
+      return ARROWIPC_ENOMEM;
+    }
+    fb->data = tmp;
+    fb->capacity = capacity;
+  }
+  if (data == NULL) {
+    memset(fb->data + fb->size, 0, size);
+  } else {
+    memcpy(fb->data + fb->size, data, size);
+  }
+  fb->size += size;
+  return ARROWIPC_ESUCCESS;
+}
+
+static int64_t _arrowipc_fb_pad(arrowipc_fb_t *fb, uint64_t align) {
+  return _arrowipc_fb_put(
+    fb, NULL, _arrowipc_round_up(fb->size, align) - fb->size);
+}
+
+/* Let the uoffset at 'at' point to 'target'. */
+static void _arrowipc_fb_patch(arrowipc_fb_t *fb, uint64_t at, uint64_t target) {
+  const uint32_t offset = (uint32_t)(target - at);
+  memcpy(fb->data + at, &offset, 4);
+}
+
+/*
+ * Write a vtable followed by its table. Returns the table's position, and
+ * the positions of the fields in field_pos.
+ */
+static int64_t _arrowipc_fb_table(
+  arrowipc_fb_t *fb,
+  const _arrowipc_slot_t *slots,
+  uint16_t num_slots,
+  uint64_t *table_pos,
+  uint64_t *field_pos) {
+  uint16_t i, voffset;
+  uint64_t vtable, table, cursor;
+  int32_t soffset;
+  const uint16_t vtable_size = 4 + 2*num_slots;
+  int64_t err;
+
+  if ( (err = _arrowipc_fb_pad(fb, 2)) ) { return err; }
+  vtable = fb->size;
+  table = _arrowipc_round_up(vtable + vtable_size, 4);
+  cursor = table + 4;
+  for (i = 0; i < num_slots; i++) {
+    if (slots[i].size) {
+      field_pos[i] = _arrowipc_round_up(cursor, slots[i].size);
+      cursor = field_pos[i] + slots[i].size;
+    } else {
+      field_pos[i] = 0;
+    }
+  }
+
+  if ( (err = _arrowipc_fb_put(fb, &vtable_size, 2)) ) { return err; }
+  voffset = (uint16_t)(cursor - table);
+  if ( (err = _arrowipc_fb_put(fb, &voffset, 2)) ) { return err; }
+  for (i = 0; i < num_slots; i++) {
+    voffset = slots[i].size ? (uint16_t)(field_pos[i] - table) : 0;
+    if ( (err = _arrowipc_fb_put(fb, &voffset, 2)) ) { return err; }
+  }
+  if ( (err = _arrowipc_fb_put(fb, NULL, table - fb->size)) ) { return err; }
+  soffset = (int32_t)(table - vtable);
+  if ( (err = _arrowipc_fb_put(fb, &soffset, 4)) ) { return err; }
+  for (i = 0; i < num_slots; i++) {
+    if (slots[i].size) {
+      if ( (err = _arrowipc_fb_put(fb, NULL, field_pos[i] - fb->size)) ) {
+        return err;
+      }
+      if ( (err = _arrowipc_fb_put(fb, slots[i].value, slots[i].size)) ) {
+        return err;
+      }
+    }
+  }
+  *table_pos = table;
+  return ARROWIPC_ESUCCESS;
+}
+
+/*
+ * Write a vector. Its elements are zero when elems is NULL, e.g. offsets
+ * which are patched later. Returns the position of the vector's length.
+ */
+static int64_t _arrowipc_fb_vector(
+  arrowipc_fb_t *fb,
+  uint32_t num,
+  uint64_t elem_size,
+  uint64_t elem_align,
+  const void *elems,
+  uint64_t *vector_pos) {
+  int64_t err;
+  if ( (err = _arrowipc_fb_pad(fb, 4)) ) { return err; }
+  while ((fb->size + 4) % elem_align != 0) {
+    if ( (err = _arrowipc_fb_put(fb, NULL, 4)) ) { return err; }
+  }
+  *vector_pos = fb->size;
+  if ( (err = _arrowipc_fb_put(fb, &num, 4)) ) { return err; }
+  return _arrowipc_fb_put(fb, elems, num*elem_size);
+}
+
+static int64_t _arrowipc_fb_string(
+  arrowipc_fb_t *fb,
+  const char *str,
+  uint64_t *string_pos) {
+  const uint32_t len = (uint32_t)strlen(str);
+  int64_t err;
+  if ( (err = _arrowipc_fb_pad(fb, 4)) ) { return err; }
+  *string_pos = fb->size;
+  if ( (err = _arrowipc_fb_put(fb, &len, 4)) ) { return err; }
+  return _arrowipc_fb_put(fb, str, len + 1);
+}
+
+/* Vector of KeyValue-tables. */
+static int64_t _arrowipc_fb_metadata(
+  arrowipc_fb_t *fb,
+  uint64_t at,
+  uint64_t num_metadata,
+  const char **keys,
+  const char **values) {
+  _arrowipc_slot_t slots[2] = {{4, NULL}, {4, NULL}};
+  uint64_t vector, table, field_pos[2], string;
+  uint64_t i;
+  int64_t err;
+  err = _arrowipc_fb_vector(fb, (uint32_t)num_metadata, 4, 4, NULL, &vector);
+  if (err) { return err; }
+  _arrowipc_fb_patch(fb, at, vector);
+  for (i = 0; i < num_metadata; i++) {
+    if ( (err = _arrowipc_fb_table(fb, slots, 2, &table, field_pos)) ) {
+      return err;
+    }
+    _arrowipc_fb_patch(fb, vector + 4 + 4*i, table);
+    if ( (err = _arrowipc_fb_string(fb, keys[i], &string)) ) { return err; }
+    _arrowipc_fb_patch(fb, field_pos[0], string);
+    if ( (err = _arrowipc_fb_string(fb, values[i], &string)) ) { return err; }
+    _arrowipc_fb_patch(fb, field_pos[1], string);
+  }
+  return ARROWIPC_ESUCCESS;
+}
+
+/*
+ * Start the flatbuffer of a Message. Returns the position of the
+ * Message's header-offset, and of its custom_metadata-offset.
+ */
+static int64_t _arrowipc_fb_message(
+  arrowipc_fb_t *fb,
+  uint8_t header_type,
+  int64_t body_length,
+  int has_metadata,
+  uint64_t *header_at,
+  uint64_t *metadata_at) {
+  const int16_t version = ARROWIPC_METADATA_VERSION_V5;
+  _arrowipc_slot_t slots[5];
+  uint64_t table, field_pos[5];
+  int64_t err;
+  slots[0].size = 2; slots[0].value = &version;
+  slots[1].size = 1; slots[1].value = &header_type;
+  slots[2].size = 4; slots[2].value = NULL;
+  slots[3].size = 8; slots[3].value = &body_length;
+  slots[4].size = has_metadata ? 4 : 0; slots[4].value = NULL;
+  fb->size = 0;
+  if ( (err = _arrowipc_fb_put(fb, NULL, 4)) ) { return err; }
+  if ( (err = _arrowipc_fb_table(fb, slots, 5, &table, field_pos)) ) {
+    return err;
+  }
+  _arrowipc_fb_patch(fb, 0, table);
+  *header_at = field_pos[2];
+  *metadata_at = field_pos[4];
+  return ARROWIPC_ESUCCESS;
+}
+
+static int64_t _arrowipc_write(arrowipc_t *s, const void *data, uint64_t size) {
+  uint64_t res = fwrite(data, 1, size, s->stream);
+  s->pos += res;
+  return (res == size) ? ARROWIPC_ESUCCESS : ARROWIPC_EWRITEFAIL;
+}
+
+static int64_t _arrowipc_write_null_bytes(arrowipc_t *s, uint64_t n) {
+  const char nul[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int64_t err;
+  while (n > 0) {
+    const uint64_t m = n < sizeof(nul) ? n : sizeof(nul);
+    if ( (err = _arrowipc_write(s, nul, m)) ) { return err; }
+    n -= m;
+  }
+  return ARROWIPC_ESUCCESS;
+}
+
+/* Write the prefix and the flatbuffer of the message. */
+static int64_t _arrowipc_write_message(arrowipc_t *s) {
+  const uint32_t continuation = ARROWIPC_CONTINUATION;
+  int32_t size;
+  int64_t err;
+  if ( (err = _arrowipc_fb_pad(&s->fb, 8)) ) { return err; }
+  size = (int32_t)s->fb.size;
+  if ( (err = _arrowipc_write(s, &continuation, 4)) ) { return err; }
+  if ( (err = _arrowipc_write(s, &size, 4)) ) { return err; }
+  return _arrowipc_write(s, s->fb.data, s->fb.size);
+}
+
+
+const char* arrowipc_strerror(int64_t err) {
+  switch (err) {
+    case ARROWIPC_ESUCCESS     : return "success";
+    case ARROWIPC_EFAILURE     : return "failure";
+    case ARROWIPC_EOPENFAIL    : return "could not open";
+    case ARROWIPC_EWRITEFAIL   : return "could not write";
+    case ARROWIPC_ENOMEM       : return "out of memory";
+    case ARROWIPC_EBADSIZE     : return "column has wrong size";
+  }
+  return "unknown error";
+}
+
+
+int64_t arrowipc_open(arrowipc_t *s, const char *filename) {
+  memset(s, 0, sizeof(*s));
+  s->stream = fopen(filename, "wb");
+  if (!s->stream) {
+    return ARROWIPC_EOPENFAIL;
+  }
+  return ARROWIPC_ESUCCESS;
+}
+
+
+int64_t arrowipc_write_schema(
+  arrowipc_t *s,
+  uint64_t num_columns,
+  const char **names,
+  uint64_t num_metadata,
+  const char **keys,
+  const char **values) {
+  const int16_t little_endian = 0;
+  const int16_t precision = ARROWIPC_PRECISION_SINGLE;
+  const uint8_t nullable = 0;
+  const uint8_t type_type = ARROWIPC_TYPE_FLOATING_POINT;
+  _arrowipc_slot_t schema_slots[3];
+  _arrowipc_slot_t field_slots[6];
+  _arrowipc_slot_t float_slots[1];
+  uint64_t header_at, metadata_at, table, pos, fields;
+  uint64_t schema_pos[3], field_pos[6], float_pos[1];
+  uint64_t i;
+  int64_t err;
+  arrowipc_fb_t *fb = &s->fb;
+
+  schema_slots[0].size = 2; schema_slots[0].value = &little_endian;
+  schema_slots[1].size = 4; schema_slots[1].value = NULL;
+  schema_slots[2].size = num_metadata ? 4 : 0; schema_slots[2].value = NULL;
+
+  field_slots[0].size = 4; field_slots[0].value = NULL;
+  field_slots[1].size = 1; field_slots[1].value = &nullable;
+  field_slots[2].size = 1; field_slots[2].value = &type_type;
+  field_slots[3].size = 4; field_slots[3].value = NULL;
+  field_slots[4].size = 0; field_slots[4].value = NULL;
+  field_slots[5].size = 4; field_slots[5].value = NULL;
+
+  float_slots[0].size = 2; float_slots[0].value = &precision;
+
+  err = _arrowipc_fb_message(
+    fb, ARROWIPC_HEADER_SCHEMA, 0, 0, &header_at, &metadata_at);
+  if (err) { return err; }
+  if ( (err = _arrowipc_fb_table(fb, schema_slots, 3, &table, schema_pos)) ) {
+    return err;
+  }
+  _arrowipc_fb_patch(fb, header_at, table);
+
+  err = _arrowipc_fb_vector(fb, (uint32_t)num_columns, 4, 4, NULL, &fields);
+  if (err) { return err; }
+  _arrowipc_fb_patch(fb, schema_pos[1], fields);
+  for (i = 0; i < num_columns; i++) {
+    if ( (err = _arrowipc_fb_table(fb, field_slots, 6, &table, field_pos)) ) {
+      return err;
+    }
+    _arrowipc_fb_patch(fb, fields + 4 + 4*i, table);
+    if ( (err = _arrowipc_fb_string(fb, names[i], &pos)) ) { return err; }
+    _arrowipc_fb_patch(fb, field_pos[0], pos);
+    if ( (err = _arrowipc_fb_table(fb, float_slots, 1, &pos, float_pos)) ) {
+      return err;
+    }
+    _arrowipc_fb_patch(fb, field_pos[3], pos);
+    if ( (err = _arrowipc_fb_vector(fb, 0, 4, 4, NULL, &pos)) ) { return err; }
+    _arrowipc_fb_patch(fb, field_pos[5], pos);
+  }
+
+  if (num_metadata) {
+    err = _arrowipc_fb_metadata(fb, schema_pos[2], num_metadata, keys, values);
+    if (err) { return err; }
+  }
+  return _arrowipc_write_message(s);
+}
+
+
+/*
+ * Write the message of a batch. Then write the body with
+ * arrowipc_write_column() and arrowipc_end_column() for each column.
+ */
+int64_t arrowipc_write_batch(
+  arrowipc_t *s,
+  uint64_t num_rows,
+  uint64_t num_columns,
+  uint64_t num_metadata,
+  const char **keys,
+  const char **values) {
+  const int64_t length = (int64_t)num_rows;
+  const uint64_t column_size = _arrowipc_round_up(4*num_rows, 8);
+  const int64_t body_length = (int64_t)(num_columns*column_size);
+  _arrowipc_slot_t batch_slots[3];
+  uint64_t header_at, metadata_at, table, pos, batch_pos[3];
+  int64_t *nodes, *buffers;
+  uint64_t i;
+  int64_t err;
+  arrowipc_fb_t *fb = &s->fb;
+
+  batch_slots[0].size = 8; batch_slots[0].value = &length;
+  batch_slots[1].size = 4; batch_slots[1].value = NULL;
+  batch_slots[2].size = 4; batch_slots[2].value = NULL;
+
+  err = _arrowipc_fb_message(
+    fb, ARROWIPC_HEADER_RECORD_BATCH, body_length, num_metadata > 0,
+    &header_at, &metadata_at);
+  if (err) { return err; }
+  if ( (err = _arrowipc_fb_table(fb, batch_slots, 3, &table, batch_pos)) ) {
+    return err;
+  }
+  _arrowipc_fb_patch(fb, header_at, table);
+
+  /* FieldNode {length, null_count} */
+  err = _arrowipc_fb_vector(fb, (uint32_t)num_columns, 16, 8, NULL, &pos);
+  if (err) { return err; }
+  _arrowipc_fb_patch(fb, batch_pos[1], pos);
+  nodes = (int64_t *)(fb->data + pos + 4);
+  for (i = 0; i < num_columns; i++) {
+    nodes[2*i + 0] = length;
+    nodes[2*i + 1] = 0;
+  }
+
+  /* Buffer {offset, length}, validity and data for each column */
+  err = _arrowipc_fb_vector(fb, (uint32_t)(2*num_columns), 16, 8, NULL, &pos);
+  if (err) { return err; }
+  _arrowipc_fb_patch(fb, batch_pos[2], pos);
+  buffers = (int64_t *)(fb->data + pos + 4);
+  for (i = 0; i < num_columns; i++) {
+    buffers[4*i + 0] = (int64_t)(i*column_size);
+    buffers[4*i + 1] = 0;
+    buffers[4*i + 2] = (int64_t)(i*column_size);
+    buffers[4*i + 3] = (int64_t)(4*num_rows);
+  }
+
+  if (num_metadata) {
+    err = _arrowipc_fb_metadata(fb, metadata_at, num_metadata, keys, values);
+    if (err) { return err; }
+  }
+  s->column_size = 4*num_rows;
+  s->column_written = 0;
+  return _arrowipc_write_message(s);
+}
+
+
+int64_t arrowipc_write_column(arrowipc_t *s, const void *data, uint64_t size) {
+  if (s->column_written + size > s->column_size) {
+    return ARROWIPC_EBADSIZE;
+  }
+  s->column_written += size;
+  return _arrowipc_write(s, data, size);
+}
+
+
+int64_t arrowipc_end_column(arrowipc_t *s) {
+  if (s->column_written != s->column_size) {
+    return ARROWIPC_EBADSIZE;
+  }
+  s->column_written = 0;
+  return _arrowipc_write_null_bytes(
+    s, _arrowipc_round_up(s->column_size, 8) - s->column_size);
+}
+
+
+int64_t arrowipc_close(arrowipc_t *s) {
+  const uint32_t eos[2] = {ARROWIPC_CONTINUATION, 0};
+  int64_t err = _arrowipc_write(s, eos, sizeof(eos));
+  free(s->fb.data);
+  s->fb.data = NULL;
+  if (fclose(s->stream) != 0 && err == ARROWIPC_ESUCCESS) {
+    err = ARROWIPC_EWRITEFAIL;
+  }
+  return err;
+}
+
+#endif
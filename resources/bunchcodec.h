@@ -0,0 +1,268 @@
+/**
+ * bunchcodec
+ * ==========
+ *
+ * A lossless transform of Cherenkov-bunches for generic compressors.
+ * A bunch is 8 float32: x, y, cx, cy, time, zem, bsize, wavelength.
+ *
+ * The bunches are encoded in blocks. Each block is:
+ *
+ *   uint32  magic       BUNCHCODEC_MAGIC
+ *   uint32  delta_mask  bit c is set when column c is delta-encoded
+ *   uint64  num_bunches
+ *   uint8   planes[8][4][num_bunches]
+ *
+ * For each column, the float32's bit-pattern is read as uint32. Slowly
+ * varying and constant columns are replaced by the difference to their
+ * predecessor in the block (modulo 2^32). The 4 bytes of each column are then
+ * split into 4 planes, least significant byte first. Constant columns become
+ * planes of zeros, and the high bytes of the other columns become runs of
+ * similar values. The transform is bit exact, and keeps the order of the
+ * bunches.
+ */
+
+#ifndef BUNCHCODEC_H
+#define BUNCHCODEC_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define BUNCHCODEC_MAGIC 0x31434342u /* "BCC1" */
+#define BUNCHCODEC_NUM_COLUMNS 8
+#define BUNCHCODEC_NUM_BYTES_IN_BUNCH (BUNCHCODEC_NUM_COLUMNS*4)
+#define BUNCHCODEC_HEADER_SIZE 16
+
+/* time, zem, bsize, wavelength */
+#define BUNCHCODEC_DEFAULT_DELTA_MASK 0xF0u
+
+enum {
+  BUNCHCODEC_ESUCCESS   =  0,
+  BUNCHCODEC_EBADMAGIC  = -1,
+  BUNCHCODEC_ETRUNCATED = -2
+};
+
+uint64_t bunchcodec_encoded_size(uint64_t num_bunches);
+uint64_t bunchcodec_encode(
+  const float *bunches,
+  uint64_t num_bunches,
+  uint32_t delta_mask,
+  void *out);
+int64_t bunchcodec_decode(
+  const void *block,
+  uint64_t block_size,
+  float *out,
+  uint64_t *num_bunches);
+
+
+uint64_t bunchcodec_encoded_size(uint64_t num_bunches) {
+  return BUNCHCODEC_HEADER_SIZE + num_bunches*BUNCHCODEC_NUM_BYTES_IN_BUNCH;
+}
+
+
+static void _bunchcodec_write_header(
+  uint8_t *out,
+  uint32_t delta_mask,
+  uint64_t num_bunches) {
+  const uint32_t magic = BUNCHCODEC_MAGIC;
+  memcpy(out, &magic, 4);
+  memcpy(out + 4, &delta_mask, 4);
+  memcpy(out + 8, &num_bunches, 8);
+}
+
+
+/* Encode the bunches [first, num_bunches) one by one. */
+static void _bunchcodec_encode_scalar(
+  const uint32_t *in,
+  uint64_t first,
+  uint64_t num_bunches,
+  uint32_t delta_mask,
+  uint8_t *planes) {
+  uint64_t i;
+  uint32_t c, v, prev;
+  for (c = 0; c < BUNCHCODEC_NUM_COLUMNS; c++) {
+    uint8_t *p0 = planes + (c*4 + 0)*num_bunches;
+    uint8_t *p1 = planes + (c*4 + 1)*num_bunches;
+    uint8_t *p2 = planes + (c*4 + 2)*num_bunches;
+    uint8_t *p3 = planes + (c*4 + 3)*num_bunches;
+    const uint32_t delta = (delta_mask >> c) & 1u;
+    prev = first > 0 ? in[(first - 1)*BUNCHCODEC_NUM_COLUMNS + c] : 0u;
+    for (i = first; i < num_bunches; i++) {
+      v = in[i*BUNCHCODEC_NUM_COLUMNS + c];
+      p0[i] = (uint8_t)((v - delta*prev));
+      p1[i] = (uint8_t)((v - delta*prev) >> 8);
+      p2[i] = (uint8_t)((v - delta*prev) >> 16);
+      p3[i] = (uint8_t)((v - delta*prev) >> 24);
+      prev = v;
+    }
+  }
+}
+
+
+#ifdef __SSE2__
+/* Split 16 uint32 in a, b, c, d into their 4 byte-planes. */
+static void _bunchcodec_transpose_bytes_sse2(
+  __m128i a,
+  __m128i b,
+  __m128i c,
+  __m128i d,
+  uint8_t *plane0,
+  uint64_t plane_stride) {
+  __m128i p0, p1, p2, p3;
+  p0 = _mm_unpacklo_epi8(a, b);
+  p1 = _mm_unpackhi_epi8(a, b);
+  p2 = _mm_unpacklo_epi8(c, d);
+  p3 = _mm_unpackhi_epi8(c, d);
+  a = _mm_unpacklo_epi8(p0, p1);
+  b = _mm_unpackhi_epi8(p0, p1);
+  c = _mm_unpacklo_epi8(p2, p3);
+  d = _mm_unpackhi_epi8(p2, p3);
+  p0 = _mm_unpacklo_epi8(a, b);
+  p1 = _mm_unpackhi_epi8(a, b);
+  p2 = _mm_unpacklo_epi8(c, d);
+  p3 = _mm_unpackhi_epi8(c, d);
+  _mm_storeu_si128(
+    (__m128i *)(plane0 + 0*plane_stride), _mm_unpacklo_epi64(p0, p2));
+  _mm_storeu_si128(
+    (__m128i *)(plane0 + 1*plane_stride), _mm_unpackhi_epi64(p0, p2));
+  _mm_storeu_si128(
+    (__m128i *)(plane0 + 2*plane_stride), _mm_unpacklo_epi64(p1, p3));
+  _mm_storeu_si128(
+    (__m128i *)(plane0 + 3*plane_stride), _mm_unpackhi_epi64(p1, p3));
+}
+
+
+/* Transpose 4 rows of 4 uint32 in place, i.e. rows become columns. */
+static void _bunchcodec_transpose_4x4_sse2(__m128i *r) {
+  const __m128i t0 = _mm_unpacklo_epi32(r[0], r[1]);
+  const __m128i t1 = _mm_unpacklo_epi32(r[2], r[3]);
+  const __m128i t2 = _mm_unpackhi_epi32(r[0], r[1]);
+  const __m128i t3 = _mm_unpackhi_epi32(r[2], r[3]);
+  r[0] = _mm_unpacklo_epi64(t0, t1);
+  r[1] = _mm_unpackhi_epi64(t0, t1);
+  r[2] = _mm_unpacklo_epi64(t2, t3);
+  r[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+
+/* Encode blocks of 16 bunches, returns the number of bunches encoded. */
+static uint64_t _bunchcodec_encode_sse2(
+  const uint32_t *in,
+  uint64_t num_bunches,
+  uint32_t delta_mask,
+  uint8_t *planes) {
+  uint64_t i;
+  uint32_t c, g, k;
+  __m128i col[BUNCHCODEC_NUM_COLUMNS][4];
+  __m128i last[BUNCHCODEC_NUM_COLUMNS];
+  __m128i rows[4];
+  for (c = 0; c < BUNCHCODEC_NUM_COLUMNS; c++) {
+    last[c] = _mm_setzero_si128();
+  }
+  for (i = 0; i + 16 <= num_bunches; i += 16) {
+    /* Gather 4 groups of 4 bunches into column-vectors. */
+    for (g = 0; g < 4; g++) {
+      const uint32_t *row = in + (i + 4*g)*BUNCHCODEC_NUM_COLUMNS;
+      for (k = 0; k < 2; k++) {
+        rows[0] = _mm_loadu_si128((const __m128i *)(row + 0*8 + 4*k));
+        rows[1] = _mm_loadu_si128((const __m128i *)(row + 1*8 + 4*k));
+        rows[2] = _mm_loadu_si128((const __m128i *)(row + 2*8 + 4*k));
+        rows[3] = _mm_loadu_si128((const __m128i *)(row + 3*8 + 4*k));
+        _bunchcodec_transpose_4x4_sse2(rows);
+        col[4*k + 0][g] = rows[0];
+        col[4*k + 1][g] = rows[1];
+        col[4*k + 2][g] = rows[2];
+        col[4*k + 3][g] = rows[3];
+      }
+    }
+    for (c = 0; c < BUNCHCODEC_NUM_COLUMNS; c++) {
+      if ((delta_mask >> c) & 1u) {
+        for (g = 0; g < 4; g++) {
+          const __m128i x = col[c][g];
+          const __m128i prev = _mm_or_si128(
+            _mm_slli_si128(x, 4), _mm_srli_si128(last[c], 12));
+          last[c] = x;
+          col[c][g] = _mm_sub_epi32(x, prev);
+        }
+      }
+      _bunchcodec_transpose_bytes_sse2(
+        col[c][0], col[c][1], col[c][2], col[c][3],
+        planes + (c*4)*num_bunches + i,
+        num_bunches);
+    }
+  }
+  return i;
+}
+#endif
+
+
+/**
+ * Encode num_bunches bunches into out, which must hold
+ * bunchcodec_encoded_size(num_bunches) bytes.
+ */
+uint64_t bunchcodec_encode(
+  const float *bunches,
+  uint64_t num_bunches,
+  uint32_t delta_mask,
+  void *out) {
+  uint64_t first = 0;
+  const uint32_t *in = (const uint32_t *)bunches;
+  uint8_t *planes = (uint8_t *)out + BUNCHCODEC_HEADER_SIZE;
+  _bunchcodec_write_header((uint8_t *)out, delta_mask, num_bunches);
+#ifdef __SSE2__
+  first = _bunchcodec_encode_sse2(in, num_bunches, delta_mask, planes);
+#endif
+  _bunchcodec_encode_scalar(in, first, num_bunches, delta_mask, planes);
+  return bunchcodec_encoded_size(num_bunches);
+}
+
+
+/**
+ * Decode one block. On success, num_bunches is set, and the bunches are
+ * written to out which must hold num_bunches*8 float32. Use out = NULL to
+ * only read num_bunches.
+ */
+int64_t bunchcodec_decode(
+  const void *block,
+  uint64_t block_size,
+  float *out,
+  uint64_t *num_bunches) {
+  uint32_t magic, delta_mask, c, b, v;
+  uint64_t i, n;
+  const uint8_t *planes = (const uint8_t *)block + BUNCHCODEC_HEADER_SIZE;
+  uint32_t *u = (uint32_t *)out;
+  if (block_size < BUNCHCODEC_HEADER_SIZE) {
+    return BUNCHCODEC_ETRUNCATED;
+  }
+  memcpy(&magic, block, 4);
+  memcpy(&delta_mask, (const uint8_t *)block + 4, 4);
+  memcpy(&n, (const uint8_t *)block + 8, 8);
+  if (magic != BUNCHCODEC_MAGIC) {
+    return BUNCHCODEC_EBADMAGIC;
+  }
+  if (block_size < bunchcodec_encoded_size(n)) {
+    return BUNCHCODEC_ETRUNCATED;
+  }
+  *num_bunches = n;
+  if (out == NULL) {
+    return BUNCHCODEC_ESUCCESS;
+  }
+  for (c = 0; c < BUNCHCODEC_NUM_COLUMNS; c++) {
+    for (i = 0; i < n; i++) {
+      v = 0;
+      for (b = 0; b < 4; b++) {
+        v |= ((uint32_t)planes[(c*4 + b)*n + i]) << (8*b);
+      }
+      if ((delta_mask >> c) & 1u) {
+        v += i > 0 ? u[(i - 1)*BUNCHCODEC_NUM_COLUMNS + c] : 0u;
+      }
+      u[i*BUNCHCODEC_NUM_COLUMNS + c] = v;
+    }
+  }
+  return BUNCHCODEC_ESUCCESS;
+}
+
+#endif
@@ -20,6 +20,7 @@
     along with this package. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#define _GNU_SOURCE
 #define PRMPAR_SIZE 17
 
 #include <stdio.h>
@@ -29,12 +30,25 @@
 #include <time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <pthread.h>
+
+#ifdef IACT_ZSTD
+#include <zstd.h>
+#endif
+#ifdef IACT_LZ4
+#include <lz4frame.h>
+#endif
 
 #include "microtar.h"
+#include "microtar_fd.h"
+#include "bunchcodec.h"
+#include "arrowipc.h"
 
 #define iact_clean_errno() (errno == 0 ? "None" : strerror(errno))
 
@@ -46,76 +60,4154 @@
         __LINE__, \
         iact_clean_errno())
 
-#define iact_check(A, M) \
-    if (!(A)) {\
-        iact_log_err(M); \
-        errno = 0; \
-        goto error; \
+#define iact_check(A, M) \
+    if (!(A)) {\
+        iact_log_err(M); \
+        errno = 0; \
+        goto error; \
+    }
+
+#define iact_fwrite(PTR, SIZE_OF_TYPE, NUM, F) { \
+    const size_t num_written = fwrite(PTR, SIZE_OF_TYPE, NUM, F); \
+    iact_check(num_written == NUM, "Can not write to file."); \
+}
+
+#define iact_fread(PTR, SIZE_OF_TYPE, NUM, F) { \
+    const size_t num_read = fread(PTR, SIZE_OF_TYPE, NUM, F); \
+    iact_check(num_read == NUM, "Can not read from file."); \
+}
+
+
+typedef float cors_real_t;
+typedef double cors_real_now_t;
+typedef double cors_real_dbl_t;
+typedef double cors_dbl_t;
+
+/* =============================================================== */
+/* functions called from CORSIKA in fortran77                      */
+void telfil_(char *name);
+void telrnh_(cors_real_t runh[273]);
+void telrne_(cors_real_t rune[273]);
+void televt_(
+    cors_real_t evth[273],
+    cors_real_dbl_t prmpar[PRMPAR_SIZE]);
+int telout_(
+    cors_real_now_t *bsize,
+    cors_real_now_t *wt,
+    cors_real_now_t *px,
+    cors_real_now_t *py,
+    cors_real_now_t *pu,
+    cors_real_now_t *pv,
+    cors_real_now_t *ctime,
+    cors_real_now_t *zem,
+    cors_real_now_t *lambda);
+void telend_(cors_real_t evte[273]);
+void telset_(
+    cors_real_now_t *x,
+    cors_real_now_t *y,
+    cors_real_now_t *z,
+    cors_real_now_t *r);
+void telshw_(void);
+void telinf_(
+    int *itel,
+    double *x,
+    double *y,
+    double *z,
+    double *r,
+    int *exists);
+void telasu_(
+    int *n,
+    cors_real_dbl_t *dx,
+    cors_real_dbl_t *dy);
+void telsmp_(char *name);
+void telprt_(cors_real_t *datab, int *maxbuf);
+void tellng_(
+    int *type,
+    double *data,
+    int *ndim,
+    int *np,
+    int *nthick,
+    double *thickstep);
+void extprm_(
+    cors_real_dbl_t *type,
+    cors_real_dbl_t *eprim,
+    double *thetap,
+    double *phip,
+    double *thick0,
+    int* seed_seq1, int* calls_seq1, int* billions_seq1,
+    int* seed_seq2, int* calls_seq2, int* billions_seq2,
+    int* seed_seq3, int* calls_seq3, int* billions_seq3,
+    int* seed_seq4, int* calls_seq4, int* billions_seq4);
+
+
+/* =============================================================== */
+/* CORSIKA function called from this module: */
+extern double heigh_(double *thickness);
+extern double refidx_(double *height);
+
+//-------------------- options -------------------------------------------------
+
+/*
+ *  Optional options in the CORSIKA run directory. Each line is
+ *  'KEY value' just like the steering-card. Lines starting with '#' are
+ *  ignored. When the file does not exist, all options keep their defaults.
+ */
+
+/* The cuts of the region-of-interest in the order they are applied. */
+enum {
+    IACT_ROI_DISC = 0,
+    IACT_ROI_RECTANGLE = 1,
+    IACT_ROI_INCIDENT = 2,
+    IACT_ROI_WAVELENGTH = 3,
+    IACT_ROI_TIME = 4,
+    IACT_ROI_NUM_CUTS = 5
+};
+
+const char *IACT_ROI_KEYS[IACT_ROI_NUM_CUTS] = {
+    "ROI_DISC_CM",
+    "ROI_RECTANGLE_CM",
+    "ROI_MAX_INCIDENT_DEG",
+    "ROI_WAVELENGTH_NM",
+    "ROI_TIME_WINDOW_NS"};
+
+const int IACT_ROI_NUM_VALUES[IACT_ROI_NUM_CUTS] = {3, 4, 1, 2, 2};
+
+/* The histograms which replace the bunches. */
+enum {
+    IACT_HIST_XY = 0,
+    IACT_HIST_R = 1,
+    IACT_HIST_TIME = 2,
+    IACT_HIST_WAVELENGTH = 3,
+    IACT_HIST_NUM = 4
+};
+
+const char *IACT_HIST_KEYS[IACT_HIST_NUM] = {
+    "HISTOGRAM_XY_CM",
+    "HISTOGRAM_R_CM",
+    "HISTOGRAM_TIME_NS",
+    "HISTOGRAM_WAVELENGTH_NM"};
+
+const char *IACT_HIST_NAMES[IACT_HIST_NUM] = {"xy", "r", "time", "wavelength"};
+
+/* The number of axes, each with the values min, max, and num_bins. */
+const int IACT_HIST_NUM_AXES[IACT_HIST_NUM] = {2, 1, 1, 1};
+
+/* The CORSIKA particle-ids which are kept with PARTICLE_IDS. */
+#define IACT_PARTICLES_MAX_NUM_IDS 64
+
+/* The curves of the detector's efficiency which are multiplied. */
+#define IACT_EFFICIENCY_MAX_NUM_CURVES 4
+#define IACT_EFFICIENCY_MAX_PATH_LENGTH 256
+
+struct iact_options {
+    uint64_t arena_ram_cap;
+    int single_pass;
+    int async_writer;
+    int async_writer_num_buffers;
+    int bunchcodec;
+    int codec;
+    int codec_level;
+    int codec_num_threads;
+    uint64_t codec_num_threads_min_size;
+    int output_format;
+    int compact;
+    double compact_resolution[8];
+    uint64_t tar_buffer_size;
+    int tar_direct;
+    uint64_t bunch_chunk_size;
+    int roi_use[IACT_ROI_NUM_CUTS];
+    double roi[IACT_ROI_NUM_CUTS][4];
+    int hist_use[IACT_HIST_NUM];
+    double hist[IACT_HIST_NUM][6];
+    int summary;
+    int merge;
+    double merge_cell_size[5];
+    int num_efficiency_curves;
+    char efficiency_paths[IACT_EFFICIENCY_MAX_NUM_CURVES][
+        IACT_EFFICIENCY_MAX_PATH_LENGTH];
+    int efficiency_photo_electrons;
+    int transmission;
+    double transmission_aerosol[3];
+    int particles;
+    int num_particle_ids;
+    int particle_ids[IACT_PARTICLES_MAX_NUM_IDS];
+    double particle_min_momentum;
+};
+
+/* The 8 floats of a photon-bunch. */
+const char *IACT_BUNCH_COLUMN_NAMES[8] = {
+    "x", "y", "cx", "cy", "time", "zem", "bsize", "wavelength"};
+
+/* Store a column of compact bunches in float16 instead of fixed-point. */
+#define IACT_COMPACT_HALF (-1.0)
+
+enum {
+    IACT_CODEC_NONE = 0,
+    IACT_CODEC_ZSTD = 1,
+    IACT_CODEC_LZ4 = 2
+};
+
+enum {
+    IACT_FORMAT_TAR = 0,
+    IACT_FORMAT_ARROW = 1
+};
+
+void iact_options_init(struct iact_options *opt) {
+    opt->arena_ram_cap = 1024u*1024u*1024u;
+    opt->single_pass = 1;
+    opt->async_writer = 0;
+    opt->async_writer_num_buffers = 2;
+    opt->bunchcodec = 0;
+    opt->codec = IACT_CODEC_NONE;
+    opt->codec_level = 3;
+    opt->codec_num_threads = 0;
+    opt->codec_num_threads_min_size = 64u*1024u*1024u;
+    opt->output_format = IACT_FORMAT_TAR;
+    opt->compact = 0;
+    opt->compact_resolution[0] = 1.0; /* x/cm */
+    opt->compact_resolution[1] = 1.0; /* y/cm */
+    opt->compact_resolution[2] = 1e-5; /* cx/rad */
+    opt->compact_resolution[3] = 1e-5; /* cy/rad */
+    opt->compact_resolution[4] = 0.1; /* time/ns */
+    opt->compact_resolution[5] = 100.0; /* zem/cm */
+    opt->compact_resolution[6] = 0.0; /* bsize, float32 */
+    opt->compact_resolution[7] = 0.0; /* wavelength/nm, float32 */
+    opt->tar_buffer_size = MTAR_FD_DEFAULT_BUFFER_SIZE;
+    opt->tar_direct = 0;
+    opt->bunch_chunk_size = 0u;
+    memset(opt->roi_use, 0, sizeof(opt->roi_use));
+    memset(opt->roi, 0, sizeof(opt->roi));
+    memset(opt->hist_use, 0, sizeof(opt->hist_use));
+    memset(opt->hist, 0, sizeof(opt->hist));
+    opt->summary = 0;
+    opt->merge = 0;
+    memset(opt->merge_cell_size, 0, sizeof(opt->merge_cell_size));
+    opt->num_efficiency_curves = 0;
+    memset(opt->efficiency_paths, 0, sizeof(opt->efficiency_paths));
+    opt->efficiency_photo_electrons = 0;
+    opt->transmission = 0;
+    memset(opt->transmission_aerosol, 0, sizeof(opt->transmission_aerosol));
+    opt->particles = 0;
+    opt->num_particle_ids = 0;
+    memset(opt->particle_ids, 0, sizeof(opt->particle_ids));
+    opt->particle_min_momentum = 0.0;
+}
+
+int iact_options_parse_compression(struct iact_options *opt, const char *line) {
+    char name[16] = "";
+    const int num = sscanf(line, "%*s %15s %d", name, &opt->codec_level);
+    iact_check(num >= 1, "Expected COMPRESSION name [level].");
+    if (strcmp(name, "none") == 0) {
+        opt->codec = IACT_CODEC_NONE;
+    } else if (strcmp(name, "zstd") == 0) {
+#ifdef IACT_ZSTD
+        opt->codec = IACT_CODEC_ZSTD;
+#else
+        iact_check(0, "iact.c was compiled without IACT_ZSTD.");
+#endif
+    } else if (strcmp(name, "lz4") == 0) {
+#ifdef IACT_LZ4
+        opt->codec = IACT_CODEC_LZ4;
+#else
+        iact_check(0, "iact.c was compiled without IACT_LZ4.");
+#endif
+    } else {
+        iact_check(0, "Expected COMPRESSION to be none, zstd, or lz4.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+int iact_options_parse_output_format(
+    struct iact_options *opt,
+    const char *line) {
+    char name[16] = "";
+    iact_check(
+        sscanf(line, "%*s %15s", name) == 1,
+        "Expected OUTPUT_FORMAT name.");
+    if (strcmp(name, "tar") == 0) {
+        opt->output_format = IACT_FORMAT_TAR;
+    } else if (strcmp(name, "arrow") == 0) {
+        opt->output_format = IACT_FORMAT_ARROW;
+    } else {
+        iact_check(0, "Expected OUTPUT_FORMAT to be tar, or arrow.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  'COMPACT_RESOLUTION column value', where value is the resolution of the
+ *  fixed-point, 'half' for float16, or 0 for float32.
+ */
+int iact_options_parse_compact_resolution(
+    struct iact_options *opt,
+    const char *line) {
+    char column[16] = "";
+    char value[32] = "";
+    int c;
+    iact_check(
+        sscanf(line, "%*s %15s %31s", column, value) == 2,
+        "Expected COMPACT_RESOLUTION column value.");
+    for (c = 0; c < 8; c++) {
+        if (strcmp(column, IACT_BUNCH_COLUMN_NAMES[c]) == 0) {
+            break;
+        }
+    }
+    iact_check(c < 8, "Expected COMPACT_RESOLUTION of a bunch's column.");
+    if (strcmp(value, "half") == 0) {
+        opt->compact_resolution[c] = IACT_COMPACT_HALF;
+    } else {
+        iact_check(
+            sscanf(value, "%lf", &opt->compact_resolution[c]) == 1 &&
+            opt->compact_resolution[c] >= 0.0,
+            "Expected COMPACT_RESOLUTION >= 0, or half.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  'KEY v0 v1 ...' with the number of values in IACT_ROI_NUM_VALUES.
+ */
+int iact_options_parse_roi(
+    struct iact_options *opt,
+    const char *line,
+    const int cut) {
+    double *v = opt->roi[cut];
+    const int num = sscanf(
+        line, "%*s %lf %lf %lf %lf", &v[0], &v[1], &v[2], &v[3]);
+    iact_check(num == IACT_ROI_NUM_VALUES[cut], "Wrong number of values.");
+    switch (cut) {
+        case IACT_ROI_DISC:
+            iact_check(v[2] >= 0.0, "Expected radius >= 0.");
+            break;
+        case IACT_ROI_RECTANGLE:
+            iact_check(v[0] <= v[1] && v[2] <= v[3], "Expected min <= max.");
+            break;
+        case IACT_ROI_INCIDENT:
+            iact_check(v[0] >= 0.0, "Expected angle >= 0.");
+            break;
+        default:
+            iact_check(v[0] <= v[1], "Expected start <= stop.");
+            break;
+    }
+    opt->roi_use[cut] = 1;
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  'KEY min max num_bins' for each of the IACT_HIST_NUM_AXES, e.g.
+ *  'HISTOGRAM_XY_CM x_min x_max num_x y_min y_max num_y'.
+ */
+int iact_options_parse_histogram(
+    struct iact_options *opt,
+    const char *line,
+    const int hist) {
+    double *v = opt->hist[hist];
+    int axis;
+    const int num = sscanf(
+        line,
+        "%*s %lf %lf %lf %lf %lf %lf",
+        &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]);
+    iact_check(num == 3*IACT_HIST_NUM_AXES[hist], "Wrong number of values.");
+    for (axis = 0; axis < IACT_HIST_NUM_AXES[hist]; axis++) {
+        const double *a = &v[3*axis];
+        iact_check(a[0] < a[1], "Expected min < max.");
+        iact_check(
+            a[2] >= 1.0 && a[2] <= 1e6 && a[2] == floor(a[2]),
+            "Expected 1 <= num_bins <= 1e6.");
+    }
+    opt->hist_use[hist] = 1;
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  'DETECTOR_EFFICIENCY path [path ...]' with up to
+ *  IACT_EFFICIENCY_MAX_NUM_CURVES paths.
+ */
+int iact_options_parse_efficiency(struct iact_options *opt, const char *line) {
+    int pos = 0, num_chars = 0;
+    char path[IACT_EFFICIENCY_MAX_PATH_LENGTH] = "";
+    iact_check(sscanf(line, "%*s%n", &pos) == 0, "Expected a key.");
+    opt->num_efficiency_curves = 0;
+    while (sscanf(line + pos, "%255s%n", path, &num_chars) == 1) {
+        iact_check(
+            strlen(path) < IACT_EFFICIENCY_MAX_PATH_LENGTH - 1,
+            "Expected path of DETECTOR_EFFICIENCY to be shorter.");
+        iact_check(
+            opt->num_efficiency_curves < IACT_EFFICIENCY_MAX_NUM_CURVES,
+            "Expected at most 4 paths in DETECTOR_EFFICIENCY.");
+        memcpy(
+            opt->efficiency_paths[opt->num_efficiency_curves],
+            path,
+            sizeof(path));
+        opt->num_efficiency_curves += 1;
+        pos += num_chars;
+    }
+    iact_check(
+        opt->num_efficiency_curves > 0,
+        "Expected DETECTOR_EFFICIENCY path [path ...].");
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  'PARTICLE_IDS id [id ...]' with up to IACT_PARTICLES_MAX_NUM_IDS ids.
+ */
+int iact_options_parse_particle_ids(
+    struct iact_options *opt,
+    const char *line) {
+    int pos = 0, num_chars = 0, id;
+    iact_check(sscanf(line, "%*s%n", &pos) == 0, "Expected a key.");
+    opt->num_particle_ids = 0;
+    while (sscanf(line + pos, "%d%n", &id, &num_chars) == 1) {
+        iact_check(
+            opt->num_particle_ids < IACT_PARTICLES_MAX_NUM_IDS,
+            "Expected at most 64 ids in PARTICLE_IDS.");
+        iact_check(id > 0, "Expected ids > 0 in PARTICLE_IDS.");
+        opt->particle_ids[opt->num_particle_ids] = id;
+        opt->num_particle_ids += 1;
+        pos += num_chars;
+    }
+    iact_check(opt->num_particle_ids > 0, "Expected PARTICLE_IDS id [id ...].");
+    return 1;
+error:
+    return 0;
+}
+
+int iact_options_parse_bool(const char *line, int *flag) {
+    char value[8] = "";
+    iact_check(sscanf(line, "%*s %7s", value) == 1, "Expected T or F.");
+    if (value[0] == 'T' || value[0] == 't') {
+        (*flag) = 1;
+    } else if (value[0] == 'F' || value[0] == 'f') {
+        (*flag) = 0;
+    } else {
+        iact_check(0, "Expected T or F.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+int iact_options_parse_line(struct iact_options *opt, const char *line) {
+    char key[64] = "";
+    double value;
+    int cut, hist;
+    if (sscanf(line, "%63s", key) != 1 || key[0] == '#') {
+        return 1;
+    }
+    for (cut = 0; cut < IACT_ROI_NUM_CUTS; cut++) {
+        if (strcmp(key, IACT_ROI_KEYS[cut]) == 0) {
+            iact_check(
+                iact_options_parse_roi(opt, line, cut),
+                "Can not parse ROI-cut.");
+            return 1;
+        }
+    }
+    for (hist = 0; hist < IACT_HIST_NUM; hist++) {
+        if (strcmp(key, IACT_HIST_KEYS[hist]) == 0) {
+            iact_check(
+                iact_options_parse_histogram(opt, line, hist),
+                "Can not parse histogram.");
+            return 1;
+        }
+    }
+    if (strcmp(key, "ARENA_RAM_CAP_MIB") == 0) {
+        iact_check(
+            sscanf(line, "%*s %lf", &value) == 1 && value > 0.0,
+            "Expected ARENA_RAM_CAP_MIB > 0.");
+        opt->arena_ram_cap = (uint64_t)(value*1024.0*1024.0);
+    } else if (strcmp(key, "SINGLE_PASS") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->single_pass),
+            "Expected SINGLE_PASS T or F.");
+    } else if (strcmp(key, "ASYNC_WRITER") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->async_writer),
+            "Expected ASYNC_WRITER T or F.");
+    } else if (strcmp(key, "ASYNC_WRITER_NUM_BUFFERS") == 0) {
+        iact_check(
+            sscanf(line, "%*s %d", &opt->async_writer_num_buffers) == 1,
+            "Expected ASYNC_WRITER_NUM_BUFFERS to be an integer.");
+    } else if (strcmp(key, "BUNCHCODEC") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->bunchcodec),
+            "Expected BUNCHCODEC T or F.");
+    } else if (strcmp(key, "COMPRESSION") == 0) {
+        iact_check(
+            iact_options_parse_compression(opt, line),
+            "Can not parse COMPRESSION.");
+    } else if (strcmp(key, "COMPRESSION_NUM_THREADS") == 0) {
+        iact_check(
+            sscanf(line, "%*s %d", &opt->codec_num_threads) == 1 &&
+            opt->codec_num_threads >= 0,
+            "Expected COMPRESSION_NUM_THREADS >= 0.");
+    } else if (strcmp(key, "COMPRESSION_NUM_THREADS_MIN_MIB") == 0) {
+        iact_check(
+            sscanf(line, "%*s %lf", &value) == 1 && value >= 0.0,
+            "Expected COMPRESSION_NUM_THREADS_MIN_MIB >= 0.");
+        opt->codec_num_threads_min_size = (uint64_t)(value*1024.0*1024.0);
+    } else if (strcmp(key, "COMPACT_BUNCHES") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->compact),
+            "Expected COMPACT_BUNCHES T or F.");
+    } else if (strcmp(key, "COMPACT_RESOLUTION") == 0) {
+        iact_check(
+            iact_options_parse_compact_resolution(opt, line),
+            "Can not parse COMPACT_RESOLUTION.");
+    } else if (strcmp(key, "TAR_BUFFER_MIB") == 0) {
+        iact_check(
+            sscanf(line, "%*s %lf", &value) == 1 && value > 0.0,
+            "Expected TAR_BUFFER_MIB > 0.");
+        opt->tar_buffer_size = (uint64_t)(value*1024.0*1024.0);
+    } else if (strcmp(key, "TAR_O_DIRECT") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->tar_direct),
+            "Expected TAR_O_DIRECT T or F.");
+    } else if (strcmp(key, "BUNCH_CHUNK_MIB") == 0) {
+        iact_check(
+            sscanf(line, "%*s %lf", &value) == 1 && value >= 0.0,
+            "Expected BUNCH_CHUNK_MIB >= 0.");
+        opt->bunch_chunk_size = (uint64_t)(value*1024.0*1024.0);
+    } else if (strcmp(key, "MERGE_BUNCHES") == 0) {
+        double *v = opt->merge_cell_size;
+        iact_check(
+            sscanf(
+                line, "%*s %lf %lf %lf %lf %lf",
+                &v[0], &v[1], &v[2], &v[3], &v[4]) == 5 &&
+            v[0] > 0.0 && v[1] > 0.0 && v[2] > 0.0 && v[3] > 0.0 &&
+            v[4] > 0.0,
+            "Expected MERGE_BUNCHES x_cm y_cm cx_rad cy_rad time_ns > 0.");
+        opt->merge = 1;
+    } else if (strcmp(key, "DETECTOR_EFFICIENCY") == 0) {
+        iact_check(
+            iact_options_parse_efficiency(opt, line),
+            "Can not parse DETECTOR_EFFICIENCY.");
+    } else if (strcmp(key, "DETECTOR_EFFICIENCY_PHOTO_ELECTRONS") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->efficiency_photo_electrons),
+            "Expected DETECTOR_EFFICIENCY_PHOTO_ELECTRONS T or F.");
+    } else if (strcmp(key, "ATMOSPHERIC_TRANSMISSION") == 0) {
+        double *v = opt->transmission_aerosol;
+        iact_check(
+            sscanf(line, "%*s %lf %lf %lf", &v[0], &v[1], &v[2]) == 3 &&
+            v[0] >= 0.0 && v[1] > 0.0,
+            "Expected ATMOSPHERIC_TRANSMISSION aerosol_depth >= 0 "
+            "scale_height_km > 0 angstrom_exponent.");
+        opt->transmission = 1;
+    } else if (strcmp(key, "PARTICLES") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->particles),
+            "Expected PARTICLES T or F.");
+    } else if (strcmp(key, "PARTICLE_IDS") == 0) {
+        iact_check(
+            iact_options_parse_particle_ids(opt, line),
+            "Can not parse PARTICLE_IDS.");
+    } else if (strcmp(key, "PARTICLE_MIN_MOMENTUM_GEV") == 0) {
+        iact_check(
+            sscanf(line, "%*s %lf", &opt->particle_min_momentum) == 1 &&
+            opt->particle_min_momentum >= 0.0,
+            "Expected PARTICLE_MIN_MOMENTUM_GEV >= 0.");
+    } else if (strcmp(key, "SUMMARY") == 0) {
+        iact_check(
+            iact_options_parse_bool(line, &opt->summary),
+            "Expected SUMMARY T or F.");
+    } else if (strcmp(key, "OUTPUT_FORMAT") == 0) {
+        iact_check(
+            iact_options_parse_output_format(opt, line),
+            "Can not parse OUTPUT_FORMAT.");
+    } else {
+        fprintf(stderr, "Unknown key '%s' in iact-options.\n", key);
+        iact_check(0, "Unknown key in iact-options.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+int iact_options_read(struct iact_options *opt, const char *path) {
+    char line[1024];
+    FILE *f = NULL;
+    iact_options_init(opt);
+    f = fopen(path, "rt");
+    if (f == NULL) {
+        errno = 0;
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        iact_check(
+            iact_options_parse_line(opt, line),
+            "Can not parse line in iact-options.");
+    }
+    fclose(f);
+    return 1;
+error:
+    fclose(f);
+    return 0;
+}
+
+//-------------------- region of interest --------------------------------------
+
+/*
+ *  Bunches outside of the region-of-interest are dropped in telout_ before
+ *  they are buffered. The cuts are applied in the order of IACT_ROI_*, and
+ *  each cut only sees the bunches which passed the cuts before. The time
+ *  window is relative to the time of the event's first bunch which reaches
+ *  it. Bunches with an undetermined wavelength of 0 pass the wavelength
+ *  cut. For each cut, the statistics count the bunches and photons tested
+ *  and rejected.
+ */
+
+enum {
+    IACT_ROI_STAT_NUM_BUNCHES = 0,
+    IACT_ROI_STAT_NUM_BUNCHES_REJECTED = 1,
+    IACT_ROI_STAT_NUM_PHOTONS = 2,
+    IACT_ROI_STAT_NUM_PHOTONS_REJECTED = 3,
+    IACT_ROI_NUM_STATS = 4
+};
+
+struct iact_roi {
+    int num_cuts;
+    int use[IACT_ROI_NUM_CUTS];
+    double values[IACT_ROI_NUM_CUTS][4];
+    double max_sin_incident_squared;
+    double first_time;
+    double stats[IACT_ROI_NUM_CUTS][IACT_ROI_NUM_STATS];
+};
+
+void iact_roi_init(struct iact_roi *roi, const struct iact_options *opt) {
+    int cut;
+    const double max_incident = opt->roi[IACT_ROI_INCIDENT][0]*M_PI/180.0;
+    memcpy(roi->use, opt->roi_use, sizeof(roi->use));
+    memcpy(roi->values, opt->roi, sizeof(roi->values));
+    roi->num_cuts = 0;
+    for (cut = 0; cut < IACT_ROI_NUM_CUTS; cut++) {
+        roi->num_cuts += roi->use[cut];
+    }
+    if (max_incident >= M_PI/2.0) {
+        roi->max_sin_incident_squared = 1.0;
+    } else {
+        roi->max_sin_incident_squared = sin(max_incident)*sin(max_incident);
+    }
+}
+
+void iact_roi_reset(struct iact_roi *roi) {
+    roi->first_time = NAN;
+    memset(roi->stats, 0, sizeof(roi->stats));
+}
+
+int iact_roi_pass(struct iact_roi *roi, const int cut, const float b[8]) {
+    const double *v = roi->values[cut];
+    double dx, dy;
+    switch (cut) {
+        case IACT_ROI_DISC:
+            dx = b[0] - v[0];
+            dy = b[1] - v[1];
+            return dx*dx + dy*dy <= v[2]*v[2];
+        case IACT_ROI_RECTANGLE:
+            return b[0] >= v[0] && b[0] <= v[1] && b[1] >= v[2] && b[1] <= v[3];
+        case IACT_ROI_INCIDENT:
+            return (double)b[2]*b[2] + (double)b[3]*b[3] <=
+                roi->max_sin_incident_squared;
+        case IACT_ROI_WAVELENGTH:
+            return b[7] == 0.0f || (fabs(b[7]) >= v[0] && fabs(b[7]) <= v[1]);
+        case IACT_ROI_TIME:
+            if (isnan(roi->first_time)) {
+                roi->first_time = b[4];
+            }
+            return b[4] - roi->first_time >= v[0] &&
+                b[4] - roi->first_time <= v[1];
+    }
+    return 1;
+}
+
+/* Returns 1 when the bunch is in the region-of-interest. */
+int iact_roi_accept(struct iact_roi *roi, const float bunch[8]) {
+    int cut;
+    for (cut = 0; cut < IACT_ROI_NUM_CUTS; cut++) {
+        double *st = roi->stats[cut];
+        if (!roi->use[cut]) {
+            continue;
+        }
+        st[IACT_ROI_STAT_NUM_BUNCHES] += 1.0;
+        st[IACT_ROI_STAT_NUM_PHOTONS] += bunch[6];
+        if (!iact_roi_pass(roi, cut, bunch)) {
+            st[IACT_ROI_STAT_NUM_BUNCHES_REJECTED] += 1.0;
+            st[IACT_ROI_STAT_NUM_PHOTONS_REJECTED] += bunch[6];
+            return 0;
+        }
+    }
+    return 1;
+}
+
+//-------------------- histograms ----------------------------------------------
+
+/*
+ *  Instead of storing the bunches, their sizes are summed up in the
+ *  histograms of the event: x-y on the observation-level, the distance r to
+ *  x = 0, y = 0, the arrival-time, and the absolute of the wavelength. The
+ *  bins are uniform from min to max. Bunches out of range are not counted.
+ *
+ *  The bunches are collected in a block of columns. The bins of a block are
+ *  found in plain loops over these contiguous columns, which the compiler
+ *  vectorizes. Only the final adding to the counts is scattered.
+ */
+
+#define IACT_HIST_BLOCK_SIZE 1024
+
+struct iact_histograms {
+    int num_histograms;
+    int use[IACT_HIST_NUM];
+    double min[IACT_HIST_NUM][2];
+    double bins_per_unit[IACT_HIST_NUM][2];
+    int num_bins[IACT_HIST_NUM][2];
+    double *counts[IACT_HIST_NUM];
+    int num_block;
+    float x[IACT_HIST_BLOCK_SIZE];
+    float y[IACT_HIST_BLOCK_SIZE];
+    float r[IACT_HIST_BLOCK_SIZE];
+    float time[IACT_HIST_BLOCK_SIZE];
+    float wavelength[IACT_HIST_BLOCK_SIZE];
+    float size[IACT_HIST_BLOCK_SIZE];
+    int32_t bin[IACT_HIST_BLOCK_SIZE];
+    int32_t bin_y[IACT_HIST_BLOCK_SIZE];
+};
+
+uint64_t iact_histograms_num_counts(
+    const struct iact_histograms *h,
+    const int hist) {
+    uint64_t num = h->num_bins[hist][0];
+    if (IACT_HIST_NUM_AXES[hist] == 2) {
+        num *= h->num_bins[hist][1];
+    }
+    return num;
+}
+
+int iact_histograms_init(
+    struct iact_histograms *h,
+    const struct iact_options *opt) {
+    int hist, axis;
+    memset(h, 0, sizeof(struct iact_histograms));
+    for (hist = 0; hist < IACT_HIST_NUM; hist++) {
+        h->use[hist] = opt->hist_use[hist];
+        if (!h->use[hist]) {
+            continue;
+        }
+        h->num_histograms += 1;
+        for (axis = 0; axis < IACT_HIST_NUM_AXES[hist]; axis++) {
+            const double *a = &opt->hist[hist][3*axis];
+            h->min[hist][axis] = a[0];
+            h->num_bins[hist][axis] = (int)a[2];
+            h->bins_per_unit[hist][axis] = a[2]/(a[1] - a[0]);
+        }
+        h->counts[hist] = (double *)calloc(
+            iact_histograms_num_counts(h, hist), sizeof(double));
+        iact_check(h->counts[hist] != NULL, "Can not allocate histogram.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+void iact_histograms_reset(struct iact_histograms *h) {
+    int hist;
+    for (hist = 0; hist < IACT_HIST_NUM; hist++) {
+        if (h->use[hist]) {
+            memset(
+                h->counts[hist],
+                0,
+                iact_histograms_num_counts(h, hist)*sizeof(double));
+        }
+    }
+    h->num_block = 0;
+}
+
+/* The bin of each value in the block, or -1 when it is out of range. */
+void iact_histograms_find_bins(
+    const float *values,
+    const int num,
+    const double min,
+    const double bins_per_unit,
+    const int num_bins,
+    int32_t *bin) {
+    int i;
+    for (i = 0; i < num; i++) {
+        double f = (values[i] - min)*bins_per_unit;
+        f = ((f >= 0.0) & (f < num_bins)) ? f : -1.0;
+        bin[i] = (int32_t)f;
+    }
+}
+
+void iact_histograms_flush(struct iact_histograms *h) {
+    const int n = h->num_block;
+    const float *values[IACT_HIST_NUM];
+    int hist, i;
+    values[IACT_HIST_XY] = h->x;
+    values[IACT_HIST_R] = h->r;
+    values[IACT_HIST_TIME] = h->time;
+    values[IACT_HIST_WAVELENGTH] = h->wavelength;
+    if (h->use[IACT_HIST_R]) {
+        for (i = 0; i < n; i++) {
+            h->r[i] = sqrtf(h->x[i]*h->x[i] + h->y[i]*h->y[i]);
+        }
+    }
+    for (hist = 0; hist < IACT_HIST_NUM; hist++) {
+        double *counts = h->counts[hist];
+        if (!h->use[hist]) {
+            continue;
+        }
+        iact_histograms_find_bins(
+            values[hist],
+            n,
+            h->min[hist][0],
+            h->bins_per_unit[hist][0],
+            h->num_bins[hist][0],
+            h->bin);
+        if (hist == IACT_HIST_XY) {
+            const int32_t ny = h->num_bins[hist][1];
+            iact_histograms_find_bins(
+                h->y,
+                n,
+                h->min[hist][1],
+                h->bins_per_unit[hist][1],
+                ny,
+                h->bin_y);
+            for (i = 0; i < n; i++) {
+                h->bin[i] = ((h->bin[i] < 0) | (h->bin_y[i] < 0)) ?
+                    -1 : h->bin[i]*ny + h->bin_y[i];
+            }
+        }
+        for (i = 0; i < n; i++) {
+            if (h->bin[i] >= 0) {
+                counts[h->bin[i]] += h->size[i];
+            }
+        }
+    }
+    h->num_block = 0;
+}
+
+void iact_histograms_add(struct iact_histograms *h, const float b[8]) {
+    const int i = h->num_block;
+    h->x[i] = b[0];
+    h->y[i] = b[1];
+    h->time[i] = b[4];
+    h->size[i] = b[6];
+    h->wavelength[i] = fabsf(b[7]);
+    h->num_block += 1;
+    if (h->num_block == IACT_HIST_BLOCK_SIZE) {
+        iact_histograms_flush(h);
+    }
+}
+
+void iact_histograms_free(struct iact_histograms *h) {
+    int hist;
+    for (hist = 0; hist < IACT_HIST_NUM; hist++) {
+        free(h->counts[hist]);
+    }
+    memset(h, 0, sizeof(struct iact_histograms));
+}
+
+//-------------------- summary -------------------------------------------------
+
+/*
+ *  Running statistics of the event's bunches which pass the
+ *  region-of-interest, in CORSIKA's frame. The moments are weighted with
+ *  the bunch-size and updated in West's single pass. The percentiles of the
+ *  emission-height are interpolated in a histogram of IACT_SUMMARY_NUM_ZEM
+ *  bins up to IACT_SUMMARY_MAX_ZEM. The layout of the written summary is
+ *  IACT_SUMMARY_*.
+ */
+
+enum {
+    IACT_SUMMARY_NUM_BUNCHES = 0,
+    IACT_SUMMARY_NUM_PHOTONS = 1,
+    IACT_SUMMARY_X_MIN = 2,
+    IACT_SUMMARY_X_MAX = 3,
+    IACT_SUMMARY_Y_MIN = 4,
+    IACT_SUMMARY_Y_MAX = 5,
+    IACT_SUMMARY_X_MEAN = 6,
+    IACT_SUMMARY_X_STD = 7,
+    IACT_SUMMARY_Y_MEAN = 8,
+    IACT_SUMMARY_Y_STD = 9,
+    IACT_SUMMARY_XY_COV = 10,
+    IACT_SUMMARY_CX_MEAN = 11,
+    IACT_SUMMARY_CX_STD = 12,
+    IACT_SUMMARY_CY_MEAN = 13,
+    IACT_SUMMARY_CY_STD = 14,
+    IACT_SUMMARY_TIME_MIN = 15,
+    IACT_SUMMARY_TIME_MAX = 16,
+    IACT_SUMMARY_TIME_MEAN = 17,
+    IACT_SUMMARY_TIME_STD = 18,
+    IACT_SUMMARY_ZEM_P05 = 19,
+    IACT_SUMMARY_ZEM_P16 = 20,
+    IACT_SUMMARY_ZEM_P50 = 21,
+    IACT_SUMMARY_ZEM_P84 = 22,
+    IACT_SUMMARY_ZEM_P95 = 23,
+    IACT_SUMMARY_SIZE = 24
+};
+
+#define IACT_SUMMARY_NUM_ZEM 1024
+#define IACT_SUMMARY_MAX_ZEM 1.2e7
+
+const double IACT_SUMMARY_ZEM_QUANTILES[5] = {0.05, 0.16, 0.5, 0.84, 0.95};
+
+/* The columns x, y, cx, cy, time with their mean, and sum of squares. */
+struct iact_summary {
+    double num_bunches;
+    double weight;
+    double min[5];
+    double max[5];
+    double mean[5];
+    double m2[5];
+    double c2_xy;
+    double zem[IACT_SUMMARY_NUM_ZEM];
+    double out[IACT_SUMMARY_SIZE];
+};
+
+void iact_summary_reset(struct iact_summary *s) {
+    int c;
+    memset(s, 0, sizeof(struct iact_summary));
+    for (c = 0; c < 5; c++) {
+        s->min[c] = INFINITY;
+        s->max[c] = -INFINITY;
+    }
+}
+
+void iact_summary_add(struct iact_summary *s, const float b[8]) {
+    const double v[5] = {b[0], b[1], b[2], b[3], b[4]};
+    const double w = b[6];
+    double zbin = (b[5]/IACT_SUMMARY_MAX_ZEM)*IACT_SUMMARY_NUM_ZEM;
+    double dx = 0.0;
+    int c;
+    s->num_bunches += 1.0;
+    for (c = 0; c < 5; c++) {
+        s->min[c] = fmin(s->min[c], v[c]);
+        s->max[c] = fmax(s->max[c], v[c]);
+    }
+    zbin = fmin(fmax(zbin, 0.0), IACT_SUMMARY_NUM_ZEM - 1.0);
+    s->zem[(int)zbin] += w;
+    if (w <= 0.0) {
+        return;
+    }
+    s->weight += w;
+    for (c = 0; c < 5; c++) {
+        const double delta = v[c] - s->mean[c];
+        s->mean[c] += delta*w/s->weight;
+        s->m2[c] += w*delta*(v[c] - s->mean[c]);
+        if (c == 0) {
+            dx = delta;
+        }
+        if (c == 1) {
+            s->c2_xy += w*dx*(v[1] - s->mean[1]);
+        }
+    }
+}
+
+double iact_summary_zem_quantile(const struct iact_summary *s, double q) {
+    const double bin_width = IACT_SUMMARY_MAX_ZEM/IACT_SUMMARY_NUM_ZEM;
+    const double target = q*s->weight;
+    double cumsum = 0.0;
+    int i;
+    for (i = 0; i < IACT_SUMMARY_NUM_ZEM; i++) {
+        if (s->zem[i] > 0.0 && cumsum + s->zem[i] >= target) {
+            return bin_width*(i + (target - cumsum)/s->zem[i]);
+        }
+        cumsum += s->zem[i];
+    }
+    return NAN;
+}
+
+/* Fill s->out. Statistics without bunches are NAN. */
+void iact_summary_finish(struct iact_summary *s) {
+    double *o = s->out;
+    int c, q;
+    const int first_mean[5] = {
+        IACT_SUMMARY_X_MEAN,
+        IACT_SUMMARY_Y_MEAN,
+        IACT_SUMMARY_CX_MEAN,
+        IACT_SUMMARY_CY_MEAN,
+        IACT_SUMMARY_TIME_MEAN};
+    const int empty = s->weight <= 0.0;
+    o[IACT_SUMMARY_NUM_BUNCHES] = s->num_bunches;
+    o[IACT_SUMMARY_NUM_PHOTONS] = s->weight;
+    o[IACT_SUMMARY_X_MIN] = s->num_bunches > 0.0 ? s->min[0] : NAN;
+    o[IACT_SUMMARY_X_MAX] = s->num_bunches > 0.0 ? s->max[0] : NAN;
+    o[IACT_SUMMARY_Y_MIN] = s->num_bunches > 0.0 ? s->min[1] : NAN;
+    o[IACT_SUMMARY_Y_MAX] = s->num_bunches > 0.0 ? s->max[1] : NAN;
+    o[IACT_SUMMARY_TIME_MIN] = s->num_bunches > 0.0 ? s->min[4] : NAN;
+    o[IACT_SUMMARY_TIME_MAX] = s->num_bunches > 0.0 ? s->max[4] : NAN;
+    for (c = 0; c < 5; c++) {
+        o[first_mean[c]] = empty ? NAN : s->mean[c];
+        o[first_mean[c] + 1] = empty ? NAN : sqrt(s->m2[c]/s->weight);
+    }
+    o[IACT_SUMMARY_XY_COV] = empty ? NAN : s->c2_xy/s->weight;
+    for (q = 0; q < 5; q++) {
+        o[IACT_SUMMARY_ZEM_P05 + q] = empty ?
+            NAN : iact_summary_zem_quantile(s, IACT_SUMMARY_ZEM_QUANTILES[q]);
+    }
+}
+
+//-------------------- bunch arena ---------------------------------------------
+
+/*
+ *  The photon-bunches of one event are collected in page-backed memory which
+ *  is reused for all events in the run. Above ram_cap, the bunches spill into
+ *  an anonymous temporary file. The bunches in the spill come first, followed
+ *  by the ones still in memory.
+ */
+
+#define IACT_NUM_FLOATS_IN_BUNCH 8
+#define IACT_NUM_BYTES_IN_BUNCH (IACT_NUM_FLOATS_IN_BUNCH*sizeof(float))
+
+/* Roughly 4e4 bunches per GeV for CERSIZ 1. */
+#define IACT_ARENA_NUM_BYTES_PER_GEV (40*1000*IACT_NUM_BYTES_IN_BUNCH)
+#define IACT_ARENA_MIN_CAPACITY (1024u*1024u)
+
+struct iact_arena {
+    char *data;
+    uint64_t size;
+    uint64_t capacity;
+    uint64_t ram_cap;
+    int spill_fd;
+    uint64_t spill_size;
+};
+
+void iact_arena_init(struct iact_arena *a, const uint64_t ram_cap) {
+    a->data = NULL;
+    a->size = 0u;
+    a->capacity = 0u;
+    a->ram_cap = ram_cap;
+    a->spill_fd = -1;
+    a->spill_size = 0u;
+}
+
+uint64_t iact_arena_num_bytes(const struct iact_arena *a) {
+    return a->spill_size + a->size;
+}
+
+int iact_arena_reserve(struct iact_arena *a, uint64_t capacity) {
+    char *data = NULL;
+    if (capacity > a->ram_cap) {
+        capacity = a->ram_cap;
+    }
+    if (capacity < IACT_ARENA_MIN_CAPACITY) {
+        capacity = IACT_ARENA_MIN_CAPACITY;
+    }
+    if (capacity <= a->capacity) {
+        return 1;
+    }
+    if (a->data == NULL) {
+        data = (char *)mmap(
+            NULL,
+            capacity,
+            PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+            -1,
+            0);
+    } else {
+        data = (char *)mremap(a->data, a->capacity, capacity, MREMAP_MAYMOVE);
+    }
+    iact_check(data != MAP_FAILED, "Can not map memory for bunch-arena.");
+    a->data = data;
+    a->capacity = capacity;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_arena_spill_data(
+    struct iact_arena *a,
+    const void *data,
+    const uint64_t size) {
+    uint64_t num_written = 0u;
+    if (a->spill_fd < 0) {
+        a->spill_fd = open(".", O_TMPFILE | O_RDWR, 0600);
+        if (a->spill_fd < 0) {
+            errno = 0;
+            a->spill_fd = memfd_create("iact_arena_spill", 0);
+        }
+        iact_check(a->spill_fd >= 0, "Can not create spill of bunch-arena.");
+    }
+    while (num_written < size) {
+        const ssize_t rc = pwrite(
+            a->spill_fd,
+            (const char *)data + num_written,
+            size - num_written,
+            a->spill_size + num_written);
+        iact_check(rc > 0, "Can not write to spill of bunch-arena.");
+        num_written += rc;
+    }
+    a->spill_size += size;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_arena_spill(struct iact_arena *a) {
+    iact_check(
+        iact_arena_spill_data(a, a->data, a->size),
+        "Can not spill bunch-arena.");
+    a->size = 0u;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_arena_append(
+    struct iact_arena *a,
+    const void *data,
+    const uint64_t size) {
+    if (a->size + size > a->capacity) {
+        if (a->capacity < a->ram_cap) {
+            iact_check(
+                iact_arena_reserve(a, 2u*a->capacity + size),
+                "Can not grow bunch-arena.");
+        }
+        if (a->size + size > a->capacity) {
+            iact_check(iact_arena_spill(a), "Can not spill bunch-arena.");
+        }
+        if (size > a->capacity) {
+            /* Larger than the memory, e.g. a block of bunchcodec. */
+            return iact_arena_spill_data(a, data, size);
+        }
+    }
+    memcpy(a->data + a->size, data, size);
+    a->size += size;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_arena_reset(struct iact_arena *a) {
+    a->size = 0u;
+    if (a->spill_fd >= 0 && a->spill_size > 0u) {
+        iact_check(
+            ftruncate(a->spill_fd, 0) == 0,
+            "Can not truncate spill of bunch-arena.");
+    }
+    a->spill_size = 0u;
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  A sink consumes a stream of bytes, e.g. the current member of the tar.
+ */
+typedef int (*iact_sink_t)(void *sink, const void *data, uint64_t size);
+
+int iact_sink_tar_data(void *tar, const void *data, uint64_t size) {
+    return mtar_write_data((mtar_t *)tar, data, size) == MTAR_ESUCCESS;
+}
+
+int iact_sink_tar_append(void *tar, const void *data, uint64_t size) {
+    return mtar_append_data((mtar_t *)tar, data, size) == MTAR_ESUCCESS;
+}
+
+int iact_sink_arena(void *arena, const void *data, uint64_t size) {
+    return iact_arena_append((struct iact_arena *)arena, data, size);
+}
+
+/*
+ *  Pass the arena's payload, first the spill then the memory, to the sink.
+ */
+int iact_arena_drain(
+    const struct iact_arena *a,
+    iact_sink_t sink,
+    void *sink_arg) {
+    void *spill = MAP_FAILED;
+    if (a->spill_size > 0u) {
+        spill = mmap(
+            NULL, a->spill_size, PROT_READ, MAP_SHARED, a->spill_fd, 0);
+        iact_check(spill != MAP_FAILED, "Can not map spill of bunch-arena.");
+        madvise(spill, a->spill_size, MADV_SEQUENTIAL);
+        iact_check(
+            sink(sink_arg, spill, a->spill_size),
+            "Can not drain spill of bunch-arena.");
+        munmap(spill, a->spill_size);
+        spill = MAP_FAILED;
+    }
+    if (a->size > 0u) {
+        iact_check(
+            sink(sink_arg, a->data, a->size),
+            "Can not drain bunch-arena.");
+    }
+    return 1;
+error:
+    if (spill != MAP_FAILED) {
+        munmap(spill, a->spill_size);
+    }
+    return 0;
+}
+
+/*
+ *  Write the arena's payload into the current member of the tar. The caller
+ *  has written the member's header with size iact_arena_num_bytes().
+ */
+int iact_arena_write_to_tar(const struct iact_arena *a, mtar_t *tar) {
+    return iact_arena_drain(a, iact_sink_tar_data, tar);
+}
+
+/*
+ *  Append the arena's payload to the tar's open file and empty the arena.
+ *  Used when the bunches are streamed into the tar in a single pass.
+ */
+int iact_arena_flush_to_tar(struct iact_arena *a, mtar_t *tar) {
+    iact_check(a->spill_size == 0u, "Expected bunch-arena without spill.");
+    iact_check(
+        mtar_append_data(tar, a->data, a->size) == MTAR_ESUCCESS,
+        "Can not append bunch-arena to tar.");
+    a->size = 0u;
+    return 1;
+error:
+    return 0;
+}
+
+void iact_arena_free(struct iact_arena *a) {
+    if (a->data != NULL) {
+        munmap(a->data, a->capacity);
+    }
+    if (a->spill_fd >= 0) {
+        close(a->spill_fd);
+    }
+    iact_arena_init(a, a->ram_cap);
+}
+
+/*
+ *  A list of bunches on the heap, for the few bunches which hit a single
+ *  telescope, or which reach the region-of-interest in one reuse of the
+ *  shower.
+ */
+struct iact_bunches {
+    float *bunches;
+    uint64_t num_bunches;
+    uint64_t capacity;
+};
+
+/* Returns the slot of the next bunch, or NULL on error. */
+float *iact_bunches_next(struct iact_bunches *l) {
+    if (l->num_bunches == l->capacity) {
+        const uint64_t capacity = l->capacity ? 2u*l->capacity : 1024u;
+        float *more = (float *)realloc(
+            l->bunches, capacity*IACT_NUM_BYTES_IN_BUNCH);
+        iact_check(more != NULL, "Can not grow list of bunches.");
+        l->bunches = more;
+        l->capacity = capacity;
+    }
+    l->num_bunches += 1u;
+    return &l->bunches[(l->num_bunches - 1u)*IACT_NUM_FLOATS_IN_BUNCH];
+error:
+    return NULL;
+}
+
+void iact_bunches_free(struct iact_bunches *l) {
+    free(l->bunches);
+    memset(l, 0, sizeof(struct iact_bunches));
+}
+
+//-------------------- merge ---------------------------------------------------
+
+/*
+ *  With MERGE_BUNCHES, the bunches of an event, or of a chunk, are binned
+ *  in cells of x, y, cx, cy, and time. The bunches in a cell are merged into
+ *  one bunch with their summed size, and the other columns are the means
+ *  weighted with the size. The merged bunches are in the order in which
+ *  their cells were first hit, so the same input gives the same output. At
+ *  most IACT_MERGE_MAX_NUM_CELLS cells are held at once. When they are
+ *  full, their bunches are emitted and the cells start over.
+ */
+
+#define IACT_MERGE_MAX_NUM_CELLS (1u << 17)
+#define IACT_MERGE_NUM_SLOTS (2u*IACT_MERGE_MAX_NUM_CELLS)
+
+struct iact_merge_cell {
+    int32_t key[5];
+    double weight;
+    double sum[IACT_NUM_FLOATS_IN_BUNCH];
+    float first[IACT_NUM_FLOATS_IN_BUNCH];
+};
+
+struct iact_merge {
+    double cell_size[5];
+    struct iact_merge_cell *cells;
+    uint32_t *slots;
+    uint32_t num_cells;
+    struct iact_arena out;
+    double num_bunches_in;
+    double num_bunches_out;
+};
+
+int iact_merge_init(
+    struct iact_merge *m,
+    const double cell_size[5],
+    const uint64_t ram_cap) {
+    memset(m, 0, sizeof(struct iact_merge));
+    memcpy(m->cell_size, cell_size, sizeof(m->cell_size));
+    iact_arena_init(&m->out, ram_cap);
+    m->cells = (struct iact_merge_cell *)malloc(
+        IACT_MERGE_MAX_NUM_CELLS*sizeof(struct iact_merge_cell));
+    iact_check(m->cells != NULL, "Can not allocate cells to merge bunches.");
+    m->slots = (uint32_t *)calloc(IACT_MERGE_NUM_SLOTS, sizeof(uint32_t));
+    iact_check(m->slots != NULL, "Can not allocate cells to merge bunches.");
+    return 1;
+error:
+    return 0;
+}
+
+/* Append the merged bunch of each cell to out, and empty the cells. */
+int iact_merge_emit(struct iact_merge *m) {
+    uint32_t i;
+    int c;
+    for (i = 0; i < m->num_cells; i++) {
+        const struct iact_merge_cell *cell = &m->cells[i];
+        float b[IACT_NUM_FLOATS_IN_BUNCH];
+        if (cell->weight > 0.0) {
+            for (c = 0; c < IACT_NUM_FLOATS_IN_BUNCH; c++) {
+                b[c] = (float)(cell->sum[c]/cell->weight);
+            }
+            b[6] = (float)cell->weight;
+        } else {
+            memcpy(b, cell->first, IACT_NUM_BYTES_IN_BUNCH);
+        }
+        iact_check(
+            iact_arena_append(&m->out, b, IACT_NUM_BYTES_IN_BUNCH),
+            "Can not append merged bunch.");
+    }
+    m->num_bunches_out += m->num_cells;
+    m->num_cells = 0u;
+    memset(m->slots, 0, IACT_MERGE_NUM_SLOTS*sizeof(uint32_t));
+    return 1;
+error:
+    return 0;
+}
+
+int iact_merge_add(struct iact_merge *m, const float b[8]) {
+    int32_t key[5];
+    uint64_t h = 0u;
+    uint32_t slot;
+    struct iact_merge_cell *cell;
+    int c;
+    for (c = 0; c < 5; c++) {
+        double k = floor(b[c]/m->cell_size[c]);
+        k = fmin(fmax(k, -2147483647.0), 2147483647.0);
+        key[c] = (int32_t)k;
+        h = (h ^ (uint32_t)key[c])*0x9E3779B97F4A7C15u;
+        h ^= h >> 29;
+    }
+    slot = (uint32_t)h & (IACT_MERGE_NUM_SLOTS - 1u);
+    while (1) {
+        if (m->slots[slot] == 0u) {
+            if (m->num_cells == IACT_MERGE_MAX_NUM_CELLS) {
+                iact_check(iact_merge_emit(m), "Can not emit merged bunches.");
+                return iact_merge_add(m, b);
+            }
+            cell = &m->cells[m->num_cells];
+            memset(cell, 0, sizeof(struct iact_merge_cell));
+            memcpy(cell->key, key, sizeof(key));
+            memcpy(cell->first, b, IACT_NUM_BYTES_IN_BUNCH);
+            m->num_cells += 1u;
+            m->slots[slot] = m->num_cells;
+            break;
+        }
+        cell = &m->cells[m->slots[slot] - 1u];
+        if (memcmp(cell->key, key, sizeof(key)) == 0) {
+            break;
+        }
+        slot = (slot + 1u) & (IACT_MERGE_NUM_SLOTS - 1u);
+    }
+    for (c = 0; c < IACT_NUM_FLOATS_IN_BUNCH; c++) {
+        cell->sum[c] += (double)b[6]*b[c];
+    }
+    cell->weight += b[6];
+    m->num_bunches_in += 1.0;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_merge_sink(void *merge, const void *data, uint64_t size) {
+    const float *bunches = (const float *)data;
+    uint64_t i;
+    for (i = 0; i < size/IACT_NUM_BYTES_IN_BUNCH; i++) {
+        iact_check(
+            iact_merge_add(
+                (struct iact_merge *)merge,
+                &bunches[i*IACT_NUM_FLOATS_IN_BUNCH]),
+            "Can not merge bunch.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/* Replace the bunches in the arena with the merged ones. */
+int iact_merge_arena(struct iact_merge *m, struct iact_arena *a) {
+    iact_check(iact_arena_reset(&m->out), "Can not reset merged bunches.");
+    iact_check(
+        iact_arena_drain(a, iact_merge_sink, m),
+        "Can not merge bunches of arena.");
+    iact_check(iact_merge_emit(m), "Can not emit merged bunches.");
+    iact_check(iact_arena_reset(a), "Can not reset bunch-arena.");
+    iact_check(
+        iact_arena_drain(&m->out, iact_sink_arena, a),
+        "Can not move merged bunches into bunch-arena.");
+    return 1;
+error:
+    return 0;
+}
+
+void iact_merge_free(struct iact_merge *m) {
+    free(m->cells);
+    free(m->slots);
+    iact_arena_free(&m->out);
+    memset(m, 0, sizeof(struct iact_merge));
+}
+
+//-------------------- random --------------------------------------------------
+
+/*
+ *  A generator for the choices iact.c makes on its own, e.g. the cores of a
+ *  reused shower. It is splitmix64, seeded from the primary's random seeds,
+ *  and does not draw from CORSIKA's sequences.
+ */
+struct iact_prng {
+    uint64_t state;
+};
+
+uint64_t iact_prng_next(struct iact_prng *prng) {
+    uint64_t z;
+    prng->state += 0x9E3779B97F4A7C15u;
+    z = prng->state;
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBu;
+    return z ^ (z >> 31);
+}
+
+void iact_prng_seed(
+    struct iact_prng *prng,
+    const int32_t *words,
+    const int num_words) {
+    int i;
+    prng->state = 0u;
+    for (i = 0; i < num_words; i++) {
+        prng->state ^= (uint64_t)(uint32_t)words[i];
+        iact_prng_next(prng);
+    }
+}
+
+/* Like iact_prng_seed(), but the salt gives an independent sequence. */
+void iact_prng_seed_salted(
+    struct iact_prng *prng,
+    const int32_t *words,
+    const int num_words,
+    const uint64_t salt) {
+    iact_prng_seed(prng, words, num_words);
+    prng->state ^= salt;
+    iact_prng_next(prng);
+}
+
+/* Uniform in [0, 1). */
+double iact_prng_uniform(struct iact_prng *prng) {
+    return (double)(iact_prng_next(prng) >> 11)/9007199254740992.0;
+}
+
+//-------------------- core reuse ----------------------------------------------
+
+/*
+ *  With CORSIKA's CSCAT card, each shower is reused at up to
+ *  IACT_REUSE_MAX_NUM cores, see telasu_. A core is where the shower's axis
+ *  hits the observation-level in the frame of the telescopes and the
+ *  region-of-interest. So a bunch at x, y in CORSIKA's frame is at
+ *  x + core_x, y + core_y in reuse i. The cores are uniform in the disc of
+ *  radius dx when dy is 0, else in the rectangle |x| <= dx, |y| <= dy. They
+ *  are drawn from the event's random seeds, so rerunning a primary gives
+ *  the same cores.
+ */
+
+#define IACT_REUSE_MAX_NUM 20
+#define IACT_REUSE_NUM_SEEDS 12
+
+struct iact_reuse {
+    int use;
+    int num;
+    double dx;
+    double dy;
+    double x[IACT_REUSE_MAX_NUM];
+    double y[IACT_REUSE_MAX_NUM];
+    struct iact_bunches bunches[IACT_REUSE_MAX_NUM];
+};
+
+void iact_reuse_init(struct iact_reuse *reuse) {
+    memset(reuse, 0, sizeof(struct iact_reuse));
+    reuse->num = 1;
+}
+
+int iact_reuse_set(
+    struct iact_reuse *reuse,
+    const int num,
+    const double dx,
+    const double dy) {
+    iact_check(
+        num >= 1 && num <= IACT_REUSE_MAX_NUM,
+        "Expected CSCAT with 1 to 20 reuses.");
+    iact_check(dx >= 0.0 && dy >= 0.0, "Expected CSCAT with range >= 0.");
+    iact_reuse_init(reuse);
+    reuse->use = num > 1 || dx > 0.0 || dy > 0.0;
+    reuse->num = num;
+    reuse->dx = dx;
+    reuse->dy = dy;
+    return 1;
+error:
+    return 0;
+}
+
+void iact_reuse_draw(
+    struct iact_reuse *reuse,
+    const int32_t seeds[IACT_REUSE_NUM_SEEDS]) {
+    int i;
+    struct iact_prng prng;
+    iact_prng_seed(&prng, seeds, IACT_REUSE_NUM_SEEDS);
+    for (i = 0; i < reuse->num; i++) {
+        const double u = iact_prng_uniform(&prng);
+        const double v = iact_prng_uniform(&prng);
+        if (reuse->dy == 0.0) {
+            const double r = reuse->dx*sqrt(u);
+            reuse->x[i] = r*cos(2.0*M_PI*v);
+            reuse->y[i] = r*sin(2.0*M_PI*v);
+        } else {
+            reuse->x[i] = reuse->dx*(2.0*u - 1.0);
+            reuse->y[i] = reuse->dy*(2.0*v - 1.0);
+        }
+        /* As in the EVTH, so readers can reproduce the frames. */
+        reuse->x[i] = (cors_real_t)reuse->x[i];
+        reuse->y[i] = (cors_real_t)reuse->y[i];
+    }
+}
+
+/* EVTH(98) is the number of reuses, EVTH(99..138) are their cores. */
+void iact_reuse_to_evth(const struct iact_reuse *reuse, cors_real_t evth[273]) {
+    int i;
+    evth[97] = (cors_real_t)reuse->num;
+    for (i = 0; i < IACT_REUSE_MAX_NUM; i++) {
+        evth[98 + i] = (cors_real_t)(i < reuse->num ? reuse->x[i] : 0.0);
+        evth[118 + i] = (cors_real_t)(i < reuse->num ? reuse->y[i] : 0.0);
+    }
+}
+
+void iact_reuse_free(struct iact_reuse *reuse) {
+    int i;
+    for (i = 0; i < IACT_REUSE_MAX_NUM; i++) {
+        iact_bunches_free(&reuse->bunches[i]);
+    }
+}
+
+//-------------------- curves --------------------------------------------------
+
+/*
+ *  A curve y(x) from a text-file with lines 'x y', where x increases and
+ *  0 <= y <= 1. Lines starting with '#' are ignored. It is interpolated
+ *  linearly, and is 0 outside.
+ */
+struct iact_curve {
+    uint64_t num;
+    uint64_t capacity;
+    double *x;
+    double *y;
+};
+
+int iact_curve_read(struct iact_curve *c, const char *path) {
+    char line[1024];
+    FILE *f = NULL;
+    memset(c, 0, sizeof(struct iact_curve));
+    f = fopen(path, "rt");
+    iact_check(f != NULL, "Can not open curve.");
+    while (fgets(line, sizeof(line), f)) {
+        double x, y;
+        char first[2] = "";
+        if (sscanf(line, "%1s", first) != 1 || first[0] == '#') {
+            continue;
+        }
+        iact_check(
+            sscanf(line, "%lf %lf", &x, &y) == 2,
+            "Expected lines 'x y' in curve.");
+        iact_check(y >= 0.0 && y <= 1.0, "Expected 0 <= y <= 1 in curve.");
+        iact_check(
+            c->num == 0 || x > c->x[c->num - 1],
+            "Expected increasing x in curve.");
+        if (c->num == c->capacity) {
+            const uint64_t capacity = c->capacity ? 2u*c->capacity : 64u;
+            double *xs, *ys;
+            xs = (double *)realloc(c->x, capacity*sizeof(double));
+            iact_check(xs != NULL, "Can not grow curve.");
+            c->x = xs;
+            ys = (double *)realloc(c->y, capacity*sizeof(double));
+            iact_check(ys != NULL, "Can not grow curve.");
+            c->y = ys;
+            c->capacity = capacity;
+        }
+        c->x[c->num] = x;
+        c->y[c->num] = y;
+        c->num += 1;
+    }
+    iact_check(c->num >= 2, "Expected at least two points in curve.");
+    fclose(f);
+    return 1;
+error:
+    if (f != NULL) {
+        fclose(f);
+    }
+    return 0;
+}
+
+double iact_curve_at(const struct iact_curve *c, const double x) {
+    uint64_t lo = 0u, hi = c->num - 1u;
+    double w;
+    if (x < c->x[lo] || x > c->x[hi]) {
+        return 0.0;
+    }
+    while (hi - lo > 1u) {
+        const uint64_t mid = (lo + hi)/2u;
+        if (c->x[mid] <= x) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    w = (x - c->x[lo])/(c->x[hi] - c->x[lo]);
+    return (1.0 - w)*c->y[lo] + w*c->y[hi];
+}
+
+void iact_curve_free(struct iact_curve *c) {
+    free(c->x);
+    free(c->y);
+    memset(c, 0, sizeof(struct iact_curve));
+}
+
+//-------------------- atmospheric transmission --------------------------------
+
+/*
+ *  With ATMOSPHERIC_TRANSMISSION, the photons are thinned with the
+ *  probability to reach the observation-level from their emission-height.
+ *  The vertical optical depth is the sum of
+ *
+ *      Rayleigh:  (X(obs) - X(zem))/X_R*(400nm/lambda)^4,
+ *      aerosols:  tau_A*(lambda/400nm)^-alpha*(1 - exp(-(zem - obs)/H_A)),
+ *
+ *  where X is the atmosphere's thickness, found with CORSIKA's heigh_, and
+ *  X_R is the mean free path of Rayleigh-scattering at 400nm. The aerosols'
+ *  vertical optical depth tau_A at 400nm, their scale-height H_A, and the
+ *  angstrom-exponent alpha are the option's values. The optical depth is
+ *  tabulated vs. the emission-height and the wavelength, and is divided by
+ *  the cosine of the bunch's zenith-distance, i.e. the atmosphere is flat.
+ *  The table is built in the first event, when CORSIKA's atmosphere is set.
+ */
+#define IACT_TRANSMISSION_NUM_HEIGHTS 512
+#define IACT_TRANSMISSION_MAX_HEIGHT 120e5
+#define IACT_TRANSMISSION_NUM_WAVELENGTHS 161
+#define IACT_TRANSMISSION_MIN_WAVELENGTH 200.0
+#define IACT_TRANSMISSION_MAX_WAVELENGTH 1000.0
+#define IACT_TRANSMISSION_MIN_COS_ZENITH 0.05
+#define IACT_RAYLEIGH_MEAN_FREE_PATH 2974.0
+
+struct iact_transmission {
+    int use;
+    double aerosol_depth;
+    double aerosol_scale_height;
+    double angstrom_exponent;
+    double observation_level;
+    double height_step;
+    double wavelength_step;
+    double *depth;
+};
+
+void iact_transmission_init(
+    struct iact_transmission *t,
+    const struct iact_options *opt) {
+    memset(t, 0, sizeof(struct iact_transmission));
+    t->use = opt->transmission;
+    t->aerosol_depth = opt->transmission_aerosol[0];
+    t->aerosol_scale_height = opt->transmission_aerosol[1]*1e5;
+    t->angstrom_exponent = opt->transmission_aerosol[2];
+    t->observation_level = NAN;
+}
+
+/* The thickness in g/cm^2 above the height in cm, by bisection of heigh_. */
+double iact_transmission_thickness(double height) {
+    double lo = log(1e-9), hi = log(1e4);
+    int i;
+    for (i = 0; i < 64; i++) {
+        double mid = 0.5*(lo + hi);
+        double thickness = exp(mid);
+        if (heigh_(&thickness) > height) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return exp(0.5*(lo + hi));
+}
+
+int iact_transmission_build(
+    struct iact_transmission *t,
+    const double observation_level) {
+    const uint64_t num =
+        IACT_TRANSMISSION_NUM_HEIGHTS*IACT_TRANSMISSION_NUM_WAVELENGTHS;
+    double thickness_obs;
+    int h, w;
+    iact_check(
+        observation_level < IACT_TRANSMISSION_MAX_HEIGHT,
+        "Expected observation-level below the table of transmission.");
+    if (t->depth == NULL) {
+        t->depth = (double *)malloc(num*sizeof(double));
+        iact_check(t->depth != NULL, "Can not allocate table of depth.");
+    }
+    t->observation_level = observation_level;
+    t->height_step = (IACT_TRANSMISSION_MAX_HEIGHT - observation_level)/
+        (IACT_TRANSMISSION_NUM_HEIGHTS - 1);
+    t->wavelength_step =
+        (IACT_TRANSMISSION_MAX_WAVELENGTH - IACT_TRANSMISSION_MIN_WAVELENGTH)/
+        (IACT_TRANSMISSION_NUM_WAVELENGTHS - 1);
+    thickness_obs = iact_transmission_thickness(observation_level);
+    for (h = 0; h < IACT_TRANSMISSION_NUM_HEIGHTS; h++) {
+        const double above = h*t->height_step;
+        const double rayleigh = (
+            thickness_obs -
+            iact_transmission_thickness(observation_level + above))/
+            IACT_RAYLEIGH_MEAN_FREE_PATH;
+        const double aerosol = t->aerosol_depth*(
+            1.0 - exp(-above/t->aerosol_scale_height));
+        for (w = 0; w < IACT_TRANSMISSION_NUM_WAVELENGTHS; w++) {
+            const double q = (
+                IACT_TRANSMISSION_MIN_WAVELENGTH + w*t->wavelength_step)/
+                400.0;
+            t->depth[h*IACT_TRANSMISSION_NUM_WAVELENGTHS + w] =
+                rayleigh/(q*q*q*q) + aerosol*pow(q, -t->angstrom_exponent);
+        }
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/* The probability of the bunch's photons to reach the observation-level. */
+double iact_transmission_at(
+    const struct iact_transmission *t,
+    const float b[8],
+    const double wavelength) {
+    const double cos_zenith_squared =
+        1.0 - (double)b[2]*b[2] - (double)b[3]*b[3];
+    const double cos_zenith = sqrt(fmax(
+        cos_zenith_squared,
+        IACT_TRANSMISSION_MIN_COS_ZENITH*IACT_TRANSMISSION_MIN_COS_ZENITH));
+    double u = (b[5] - t->observation_level)/t->height_step;
+    double v = (wavelength - IACT_TRANSMISSION_MIN_WAVELENGTH)/
+        t->wavelength_step;
+    const double *d;
+    double depth;
+    int h, w;
+    u = fmin(fmax(u, 0.0), IACT_TRANSMISSION_NUM_HEIGHTS - 1.0);
+    v = fmin(fmax(v, 0.0), IACT_TRANSMISSION_NUM_WAVELENGTHS - 1.0);
+    h = (int)fmin(u, IACT_TRANSMISSION_NUM_HEIGHTS - 2.0);
+    w = (int)fmin(v, IACT_TRANSMISSION_NUM_WAVELENGTHS - 2.0);
+    u -= h;
+    v -= w;
+    d = &t->depth[h*IACT_TRANSMISSION_NUM_WAVELENGTHS + w];
+    depth =
+        (1.0 - u)*((1.0 - v)*d[0] + v*d[1]) +
+        u*((1.0 - v)*d[IACT_TRANSMISSION_NUM_WAVELENGTHS] +
+            v*d[IACT_TRANSMISSION_NUM_WAVELENGTHS + 1]);
+    return exp(-depth/cos_zenith);
+}
+
+void iact_transmission_free(struct iact_transmission *t) {
+    free(t->depth);
+    t->depth = NULL;
+}
+
+//-------------------- detector efficiency -------------------------------------
+
+/*
+ *  With DETECTOR_EFFICIENCY, telout_ thins the photons with the efficiency
+ *  of the detector vs. the wavelength, e.g. the mirror's reflectivity times
+ *  the photo-sensor's quantum-efficiency. A bunch is kept with the
+ *  probability of the efficiency at its wavelength, and dropped else. When
+ *  the wavelength is undetermined, it is drawn from the Cherenkov-spectrum
+ *  1/lambda^2 in the event's band EVTH(96..97). Bunches which are already
+ *  photo-electrons pass. The draws are seeded from the primary's random
+ *  seeds, so an event is thinned the same way in each run. With
+ *  ATMOSPHERIC_TRANSMISSION, the probability is multiplied with the
+ *  transmission, so each bunch needs only one draw.
+ *
+ *  Each curve has lines 'wavelength_nm efficiency'. The product of the
+ *  curves is tabulated in IACT_EFFICIENCY_NUM_SAMPLES.
+ */
+#define IACT_EFFICIENCY_NUM_SAMPLES 4096
+#define IACT_EFFICIENCY_SEED_SALT 0x45464649
+
+struct iact_efficiency {
+    int use;
+    int use_curves;
+    int photo_electrons;
+    double start;
+    double step;
+    double *table;
+    double band[2];
+    struct iact_prng prng;
+    struct iact_transmission transmission;
+};
+
+int iact_efficiency_init(
+    struct iact_efficiency *e,
+    const struct iact_options *opt) {
+    struct iact_curve curves[IACT_EFFICIENCY_MAX_NUM_CURVES];
+    double stop;
+    int i, k;
+    memset(curves, 0, sizeof(curves));
+    memset(e, 0, sizeof(struct iact_efficiency));
+    e->use_curves = opt->num_efficiency_curves > 0;
+    e->photo_electrons = opt->efficiency_photo_electrons;
+    iact_transmission_init(&e->transmission, opt);
+    e->use = e->use_curves || e->transmission.use;
+    if (!e->use_curves) {
+        return 1;
+    }
+    for (k = 0; k < opt->num_efficiency_curves; k++) {
+        iact_check(
+            iact_curve_read(&curves[k], opt->efficiency_paths[k]),
+            "Can not read curve of DETECTOR_EFFICIENCY.");
+    }
+    e->start = curves[0].x[0];
+    stop = curves[0].x[curves[0].num - 1];
+    for (k = 1; k < opt->num_efficiency_curves; k++) {
+        e->start = fmax(e->start, curves[k].x[0]);
+        stop = fmin(stop, curves[k].x[curves[k].num - 1]);
+    }
+    iact_check(e->start < stop, "Expected curves to overlap.");
+    e->step = (stop - e->start)/(IACT_EFFICIENCY_NUM_SAMPLES - 1);
+    e->table = (double *)malloc(IACT_EFFICIENCY_NUM_SAMPLES*sizeof(double));
+    iact_check(e->table != NULL, "Can not allocate table of efficiency.");
+    for (i = 0; i < IACT_EFFICIENCY_NUM_SAMPLES; i++) {
+        const double wavelength = (i == IACT_EFFICIENCY_NUM_SAMPLES - 1) ?
+            stop : e->start + i*e->step;
+        e->table[i] = 1.0;
+        for (k = 0; k < opt->num_efficiency_curves; k++) {
+            e->table[i] *= iact_curve_at(&curves[k], wavelength);
+        }
+    }
+    for (k = 0; k < opt->num_efficiency_curves; k++) {
+        iact_curve_free(&curves[k]);
+    }
+    return 1;
+error:
+    for (k = 0; k < IACT_EFFICIENCY_MAX_NUM_CURVES; k++) {
+        iact_curve_free(&curves[k]);
+    }
+    return 0;
+}
+
+/*
+ *  The band is EVTH(96..97), the lower and upper wavelength in nm, and the
+ *  observation-level is EVTH(48) in cm.
+ */
+int iact_efficiency_begin_event(
+    struct iact_efficiency *e,
+    const cors_real_t evth[273],
+    const int32_t seeds[IACT_REUSE_NUM_SEEDS]) {
+    e->band[0] = evth[95];
+    e->band[1] = evth[96];
+    iact_check(
+        e->band[0] > 0.0 && e->band[0] < e->band[1],
+        "Expected EVTH's band of wavelengths with 0 < lower < upper.");
+    if (e->transmission.use &&
+        e->transmission.observation_level != evth[47]) {
+        iact_check(
+            iact_transmission_build(&e->transmission, evth[47]),
+            "Can not build table of atmospheric transmission.");
+    }
+    iact_prng_seed_salted(
+        &e->prng, seeds, IACT_REUSE_NUM_SEEDS, IACT_EFFICIENCY_SEED_SALT);
+    return 1;
+error:
+    return 0;
+}
+
+double iact_efficiency_at(
+    const struct iact_efficiency *e,
+    const double wavelength) {
+    const double u = (wavelength - e->start)/e->step;
+    int i;
+    if (!(u >= 0.0 && u <= IACT_EFFICIENCY_NUM_SAMPLES - 1)) {
+        return 0.0;
+    }
+    i = (int)u;
+    if (i == IACT_EFFICIENCY_NUM_SAMPLES - 1) {
+        return e->table[i];
+    }
+    return e->table[i] + (u - i)*(e->table[i + 1] - e->table[i]);
+}
+
+/*
+ *  Returns 1 when the bunch is kept. Its wavelength is set, and it is
+ *  negative for photo-electrons.
+ */
+int iact_efficiency_thin(struct iact_efficiency *e, float b[8]) {
+    double wavelength = b[7], probability;
+    if (wavelength < 0.0) {
+        return 1;
+    }
+    if (wavelength == 0.0) {
+        const double u = iact_prng_uniform(&e->prng);
+        wavelength = 1.0/(
+            1.0/e->band[0] - u*(1.0/e->band[0] - 1.0/e->band[1]));
+    }
+    probability = e->use_curves ? iact_efficiency_at(e, wavelength) : 1.0;
+    if (e->transmission.use) {
+        probability *= iact_transmission_at(&e->transmission, b, wavelength);
+    }
+    if (iact_prng_uniform(&e->prng) >= probability) {
+        return 0;
+    }
+    b[7] = (float)(e->photo_electrons ? -wavelength : wavelength);
+    return 1;
+}
+
+void iact_efficiency_free(struct iact_efficiency *e) {
+    free(e->table);
+    e->table = NULL;
+    iact_transmission_free(&e->transmission);
+}
+
+//-------------------- importance sampling -------------------------------------
+
+/*
+ *  With a file of importance-sampling, see telsmp_, telout_ keeps a bunch
+ *  with a probability p(r) of its distance r to the shower's core on the
+ *  observation-level, and divides its size by p. So the expected number of
+ *  photons is kept, but there are fewer bunches where there are many, e.g.
+ *  near the core. The file is a curve with lines 'r_cm probability' and
+ *  0 < probability <= 1. Before the first, and after the last r, p is the
+ *  one of the first, and last r. The draws are seeded from the primary's
+ *  random seeds. For each event, the statistics count the bunches and
+ *  photons tested and kept.
+ */
+#define IACT_IMPORTANCE_SEED_SALT 0x494d504f
+
+enum {
+    IACT_IMPORTANCE_STAT_NUM_BUNCHES = 0,
+    IACT_IMPORTANCE_STAT_NUM_BUNCHES_KEPT = 1,
+    IACT_IMPORTANCE_STAT_NUM_PHOTONS = 2,
+    IACT_IMPORTANCE_STAT_NUM_PHOTONS_KEPT = 3,
+    IACT_IMPORTANCE_NUM_STATS = 4
+};
+
+struct iact_importance {
+    int use;
+    struct iact_curve curve;
+    struct iact_prng prng;
+    double stats[IACT_IMPORTANCE_NUM_STATS];
+};
+
+int iact_importance_read(struct iact_importance *imp, const char *path) {
+    uint64_t i;
+    iact_curve_free(&imp->curve);
+    imp->use = 0;
+    iact_check(
+        iact_curve_read(&imp->curve, path),
+        "Can not read curve of importance-sampling.");
+    for (i = 0; i < imp->curve.num; i++) {
+        iact_check(
+            imp->curve.y[i] > 0.0,
+            "Expected probabilities > 0 in importance-sampling.");
+    }
+    imp->use = 1;
+    return 1;
+error:
+    return 0;
+}
+
+void iact_importance_begin_event(
+    struct iact_importance *imp,
+    const int32_t seeds[IACT_REUSE_NUM_SEEDS]) {
+    iact_prng_seed_salted(
+        &imp->prng, seeds, IACT_REUSE_NUM_SEEDS, IACT_IMPORTANCE_SEED_SALT);
+    memset(imp->stats, 0, sizeof(imp->stats));
+}
+
+/* Returns 1 when the bunch is kept. Its size is divided by p. */
+int iact_importance_sample(struct iact_importance *imp, float b[8]) {
+    const struct iact_curve *c = &imp->curve;
+    const double r = fmin(
+        fmax(sqrt((double)b[0]*b[0] + (double)b[1]*b[1]), c->x[0]),
+        c->x[c->num - 1]);
+    const double p = iact_curve_at(c, r);
+    imp->stats[IACT_IMPORTANCE_STAT_NUM_BUNCHES] += 1.0;
+    imp->stats[IACT_IMPORTANCE_STAT_NUM_PHOTONS] += b[6];
+    if (iact_prng_uniform(&imp->prng) >= p) {
+        return 0;
+    }
+    b[6] = (float)(b[6]/p);
+    imp->stats[IACT_IMPORTANCE_STAT_NUM_BUNCHES_KEPT] += 1.0;
+    imp->stats[IACT_IMPORTANCE_STAT_NUM_PHOTONS_KEPT] += b[6];
+    return 1;
+}
+
+void iact_importance_free(struct iact_importance *imp) {
+    iact_curve_free(&imp->curve);
+    imp->use = 0;
+}
+
+//-------------------- particles -----------------------------------------------
+
+/*
+ *  With PARTICLES, telprt_ keeps the particles which CORSIKA passes in
+ *  blocks of IACT_PARTICLES_NUM_PER_BLOCK, each with the words
+ *
+ *      description, px, py, pz, x, y, time [, weight],
+ *
+ *  where the weight is only there with thinning. The description is
+ *  id*1000 + generation*10 + observation-level. Empty slots have a
+ *  description of 0. With PARTICLE_IDS, only these ids pass, and with
+ *  PARTICLE_MIN_MOMENTUM_GEV, only particles with at least this momentum.
+ */
+#define IACT_PARTICLES_NUM_PER_BLOCK 39
+
+int iact_particle_accept(const struct iact_options *opt, const float p[7]) {
+    const int id = (int)(p[0]/1000.0f);
+    int i;
+    if (p[0] == 0.0f) {
+        return 0;
+    }
+    if (opt->num_particle_ids > 0) {
+        for (i = 0; i < opt->num_particle_ids; i++) {
+            if (opt->particle_ids[i] == id) {
+                break;
+            }
+        }
+        if (i == opt->num_particle_ids) {
+            return 0;
+        }
+    }
+    return (double)p[1]*p[1] + (double)p[2]*p[2] + (double)p[3]*p[3] >=
+        opt->particle_min_momentum*opt->particle_min_momentum;
+}
+
+//-------------------- longitudinal --------------------------------------------
+
+/*
+ *  The longitudinal distributions which CORSIKA passes to tellng_ are
+ *  buffered for the event, one record for each call:
+ *
+ *      type, np, nthick, thickstep, np x nthick values,
+ *
+ *  where only the nthick filled entries of each distribution are kept.
+ */
+struct iact_longitudinal {
+    double *values;
+    uint64_t num;
+    uint64_t capacity;
+};
+
+int iact_longitudinal_append(
+    struct iact_longitudinal *l,
+    const int type,
+    const double *data,
+    const int ndim,
+    const int np,
+    const int nthick,
+    const double thickstep) {
+    const uint64_t num = 4u + (uint64_t)np*(uint64_t)nthick;
+    double *out;
+    int i;
+    iact_check(
+        np >= 0 && nthick >= 0 && nthick <= ndim,
+        "Expected 0 <= nthick <= ndim, and np >= 0.");
+    if (l->num + num > l->capacity) {
+        uint64_t capacity = l->capacity ? l->capacity : 1024u;
+        double *more;
+        while (capacity < l->num + num) {
+            capacity *= 2u;
+        }
+        more = (double *)realloc(l->values, capacity*sizeof(double));
+        iact_check(more != NULL, "Can not grow longitudinal distributions.");
+        l->values = more;
+        l->capacity = capacity;
+    }
+    out = &l->values[l->num];
+    out[0] = type;
+    out[1] = np;
+    out[2] = nthick;
+    out[3] = thickstep;
+    for (i = 0; i < np; i++) {
+        memcpy(
+            &out[4 + i*nthick],
+            &data[i*ndim],
+            nthick*sizeof(double));
+    }
+    l->num += num;
+    return 1;
+error:
+    return 0;
+}
+
+void iact_longitudinal_free(struct iact_longitudinal *l) {
+    free(l->values);
+    memset(l, 0, sizeof(struct iact_longitudinal));
+}
+
+//-------------------- telescopes ----------------------------------------------
+
+/*
+ *  The detector-spheres of CORSIKA's TELESCOPE cards. A bunch is stored for
+ *  each sphere its ray intersects, relative to the sphere: x, y in the
+ *  horizontal plane through the sphere's center, and the time when the
+ *  bunch passes this plane with the speed of light in vacuum.
+ *
+ *  The spheres are placed once for each reuse of the shower, shifted by
+ *  minus the reuse's core. The placed sphere p is telescope p % num in
+ *  reuse p / num.
+ *
+ *  Only the spheres near a bunch are tested. The placed spheres are hashed
+ *  into a uniform grid on the observation-level. A sphere is in all cells
+ *  which a ray through it can reach with an angle of incidence up to
+ *  atan(IACT_TELESCOPE_GRID_MAX_TAN). Steeper rays test all spheres. So a
+ *  single lookup finds the hits of a bunch in all reuses.
+ */
+
+#define IACT_TELESCOPE_GRID_MAX_TAN 1.0
+#define IACT_SPEED_OF_LIGHT_CM_PER_NS 29.9792458
+
+struct iact_telescope {
+    double x;
+    double y;
+    double z;
+    double r;
+    struct iact_bunches bunches;
+};
+
+struct iact_telescopes {
+    struct iact_telescope *telescopes;
+    int num;
+    int capacity;
+    struct iact_telescope *placed;
+    int num_placed;
+    double cell_size;
+    double x_min;
+    double y_min;
+    int nx;
+    int ny;
+    int *cell_first;
+    int *cell_items;
+};
+
+void iact_telescopes_init(struct iact_telescopes *t) {
+    memset(t, 0, sizeof(struct iact_telescopes));
+}
+
+int iact_telescopes_add(
+    struct iact_telescopes *t,
+    const double x,
+    const double y,
+    const double z,
+    const double r) {
+    struct iact_telescope *tel;
+    iact_check(r > 0.0, "Expected telescope's radius > 0.");
+    if (t->num == t->capacity) {
+        const int capacity = t->capacity ? 2*t->capacity : 64;
+        struct iact_telescope *more = (struct iact_telescope *)realloc(
+            t->telescopes, capacity*sizeof(struct iact_telescope));
+        iact_check(more != NULL, "Can not grow telescopes.");
+        t->telescopes = more;
+        t->capacity = capacity;
+    }
+    tel = &t->telescopes[t->num];
+    memset(tel, 0, sizeof(struct iact_telescope));
+    tel->x = x;
+    tel->y = y;
+    tel->z = z;
+    tel->r = r;
+    t->num += 1;
+    return 1;
+error:
+    return 0;
+}
+
+double iact_telescope_reach(const struct iact_telescope *tel) {
+    return tel->r + (fabs(tel->z) + tel->r)*IACT_TELESCOPE_GRID_MAX_TAN;
+}
+
+void iact_telescopes_cell_range(
+    const struct iact_telescopes *t,
+    const struct iact_telescope *tel,
+    int range[4]) {
+    const double reach = iact_telescope_reach(tel);
+    range[0] = (int)floor((tel->x - reach - t->x_min)/t->cell_size);
+    range[1] = (int)floor((tel->x + reach - t->x_min)/t->cell_size);
+    range[2] = (int)floor((tel->y - reach - t->y_min)/t->cell_size);
+    range[3] = (int)floor((tel->y + reach - t->y_min)/t->cell_size);
+    range[0] = range[0] < 0 ? 0 : range[0];
+    range[1] = range[1] >= t->nx ? t->nx - 1 : range[1];
+    range[2] = range[2] < 0 ? 0 : range[2];
+    range[3] = range[3] >= t->ny ? t->ny - 1 : range[3];
+}
+
+/*
+ *  The cells are about twice the mean reach of a sphere, but not more than
+ *  16 cells per sphere.
+ */
+int iact_telescopes_build_grid(struct iact_telescopes *t) {
+    int i, ix, iy, range[4];
+    double x_max, y_max, sum_reach = 0.0;
+    iact_check(t->num_placed > 0, "Expected telescopes.");
+    free(t->cell_first);
+    free(t->cell_items);
+    t->cell_first = NULL;
+    t->cell_items = NULL;
+    t->x_min = t->y_min = INFINITY;
+    x_max = y_max = -INFINITY;
+    for (i = 0; i < t->num_placed; i++) {
+        const struct iact_telescope *tel = &t->placed[i];
+        const double reach = iact_telescope_reach(tel);
+        t->x_min = fmin(t->x_min, tel->x - reach);
+        t->y_min = fmin(t->y_min, tel->y - reach);
+        x_max = fmax(x_max, tel->x + reach);
+        y_max = fmax(y_max, tel->y + reach);
+        sum_reach += reach;
+    }
+    t->cell_size = 2.0*sum_reach/t->num_placed;
+    while (1) {
+        t->nx = 1 + (int)floor((x_max - t->x_min)/t->cell_size);
+        t->ny = 1 + (int)floor((y_max - t->y_min)/t->cell_size);
+        if ((double)t->nx*(double)t->ny <= 16.0*t->num_placed) {
+            break;
+        }
+        t->cell_size *= 2.0;
+    }
+
+    t->cell_first = (int *)calloc(t->nx*t->ny + 1, sizeof(int));
+    iact_check(t->cell_first != NULL, "Can not allocate telescope-grid.");
+    for (i = 0; i < t->num_placed; i++) {
+        iact_telescopes_cell_range(t, &t->placed[i], range);
+        for (ix = range[0]; ix <= range[1]; ix++) {
+            for (iy = range[2]; iy <= range[3]; iy++) {
+                t->cell_first[ix*t->ny + iy + 1] += 1;
+            }
+        }
+    }
+    for (i = 0; i < t->nx*t->ny; i++) {
+        t->cell_first[i + 1] += t->cell_first[i];
+    }
+    t->cell_items = (int *)malloc(
+        (t->cell_first[t->nx*t->ny] + 1)*sizeof(int));
+    iact_check(t->cell_items != NULL, "Can not allocate telescope-grid.");
+    for (i = 0; i < t->num_placed; i++) {
+        iact_telescopes_cell_range(t, &t->placed[i], range);
+        for (ix = range[0]; ix <= range[1]; ix++) {
+            for (iy = range[2]; iy <= range[3]; iy++) {
+                const int c = ix*t->ny + iy;
+                t->cell_items[t->cell_first[c]] = i;
+                t->cell_first[c] += 1;
+            }
+        }
+    }
+    /* Filling moved each cell's first to the next cell's first. */
+    for (i = t->nx*t->ny; i > 0; i--) {
+        t->cell_first[i] = t->cell_first[i - 1];
+    }
+    t->cell_first[0] = 0;
+    return 1;
+error:
+    return 0;
+}
+
+/* Place the telescopes for the cores of the reuses, and hash them. */
+int iact_telescopes_place(
+    struct iact_telescopes *t,
+    const struct iact_reuse *reuse) {
+    int r, k;
+    if (t->placed == NULL) {
+        t->placed = (struct iact_telescope *)calloc(
+            IACT_REUSE_MAX_NUM*t->num, sizeof(struct iact_telescope));
+        iact_check(t->placed != NULL, "Can not allocate placed telescopes.");
+    }
+    for (r = 0; r < reuse->num; r++) {
+        for (k = 0; k < t->num; k++) {
+            struct iact_telescope *p = &t->placed[r*t->num + k];
+            p->x = t->telescopes[k].x - reuse->x[r];
+            p->y = t->telescopes[k].y - reuse->y[r];
+            p->z = t->telescopes[k].z;
+            p->r = t->telescopes[k].r;
+        }
+    }
+    t->num_placed = reuse->num*t->num;
+    return iact_telescopes_build_grid(t);
+error:
+    return 0;
+}
+
+/*
+ *  Append the bunch b to the telescope when its ray intersects the sphere.
+ *  Returns 1 on a hit, 0 on a miss, and -1 on error.
+ */
+int iact_telescope_intersect(struct iact_telescope *tel, const float b[8]) {
+    const double cx = b[2];
+    const double cy = b[3];
+    const double cz = sqrt(fmax(0.0, 1.0 - cx*cx - cy*cy));
+    const double dx = tel->x - b[0];
+    const double dy = tel->y - b[1];
+    const double dz = tel->z;
+    const double s = -dx*cx - dy*cy + dz*cz;
+    float *out;
+    if (cz <= 0.0 || dx*dx + dy*dy + dz*dz - s*s > tel->r*tel->r) {
+        return 0;
+    }
+    out = iact_bunches_next(&tel->bunches);
+    iact_check(out != NULL, "Can not grow bunches of telescope.");
+    memcpy(out, b, IACT_NUM_BYTES_IN_BUNCH);
+    out[0] = (float)(b[0] - cx/cz*tel->z - tel->x);
+    out[1] = (float)(b[1] - cy/cz*tel->z - tel->y);
+    out[4] = (float)(b[4] - tel->z/(cz*IACT_SPEED_OF_LIGHT_CM_PER_NS));
+    return 1;
+error:
+    return -1;
+}
+
+/*
+ *  Returns the number of placed telescopes hit by the bunch, or -1 on
+ *  error. Only the telescopes of the reuse are tested, or all when reuse is
+ *  negative.
+ */
+int iact_telescopes_add_bunch(
+    struct iact_telescopes *t,
+    const float b[8],
+    const int reuse) {
+    const double tan2 = (b[2]*b[2] + b[3]*b[3])/(1.0 - b[2]*b[2] - b[3]*b[3]);
+    int i, num_hits = 0;
+    int first = reuse < 0 ? 0 : reuse*t->num;
+    int last = reuse < 0 ? t->num_placed : (reuse + 1)*t->num;
+    const int *items = NULL;
+    if (tan2 <= IACT_TELESCOPE_GRID_MAX_TAN*IACT_TELESCOPE_GRID_MAX_TAN) {
+        const int ix = (int)floor((b[0] - t->x_min)/t->cell_size);
+        const int iy = (int)floor((b[1] - t->y_min)/t->cell_size);
+        if (ix < 0 || ix >= t->nx || iy < 0 || iy >= t->ny) {
+            return 0;
+        }
+        first = t->cell_first[ix*t->ny + iy];
+        last = t->cell_first[ix*t->ny + iy + 1];
+        items = t->cell_items;
+    }
+    for (i = first; i < last; i++) {
+        const int k = items ? items[i] : i;
+        int hit;
+        if (reuse >= 0 && k/t->num != reuse) {
+            continue;
+        }
+        hit = iact_telescope_intersect(&t->placed[k], b);
+        if (hit < 0) {
+            return -1;
+        }
+        num_hits += hit;
+    }
+    return num_hits;
+}
+
+void iact_telescopes_free(struct iact_telescopes *t) {
+    int i;
+    if (t->placed != NULL) {
+        for (i = 0; i < IACT_REUSE_MAX_NUM*t->num; i++) {
+            iact_bunches_free(&t->placed[i].bunches);
+        }
+    }
+    free(t->telescopes);
+    free(t->placed);
+    free(t->cell_first);
+    free(t->cell_items);
+    iact_telescopes_init(t);
+}
+
+//-------------------- encoder -------------------------------------------------
+
+/*
+ *  Optional encoding of the photon-bunches. First, the bunches can be
+ *  transformed by bunchcodec.h in blocks of IACT_BUNCHCODEC_BLOCK_NUM_BUNCHES.
+ *  Second, the stream can be compressed. zstd is only available when
+ *  iact.c is compiled with IACT_ZSTD and linked with -lzstd. lz4 likewise
+ *  with IACT_LZ4 and -llz4. Large payloads are compressed with
+ *  codec_num_threads worker-threads of zstd.
+ */
+
+#define IACT_ENCODER_CHUNK_SIZE (1024u*1024u)
+#define IACT_BUNCHCODEC_BLOCK_NUM_BUNCHES (128u*1024u)
+
+struct iact_encoder {
+    int bunchcodec;
+    char *block;
+    char suffix[32];
+    int codec;
+    int level;
+    int num_threads;
+    uint64_t num_threads_min_size;
+    char *out;
+    uint64_t out_capacity;
+#ifdef IACT_ZSTD
+    ZSTD_CCtx *zstd;
+#endif
+#ifdef IACT_LZ4
+    LZ4F_cctx *lz4;
+#endif
+};
+
+const char *iact_codec_suffix(const int codec) {
+    switch (codec) {
+        case IACT_CODEC_ZSTD: return ".zst";
+        case IACT_CODEC_LZ4: return ".lz4";
+    }
+    return "";
+}
+
+int iact_encoder_init(
+    struct iact_encoder *e,
+    const int bunchcodec,
+    const int codec,
+    const int level,
+    const int num_threads,
+    const uint64_t num_threads_min_size) {
+    memset(e, 0, sizeof(struct iact_encoder));
+    e->bunchcodec = bunchcodec;
+    snprintf(
+        e->suffix, sizeof(e->suffix), "%s%s",
+        bunchcodec ? ".bunchcodec" : "",
+        iact_codec_suffix(codec));
+    if (bunchcodec) {
+        e->block = (char *)malloc(
+            bunchcodec_encoded_size(IACT_BUNCHCODEC_BLOCK_NUM_BUNCHES));
+        iact_check(e->block != NULL, "Can not allocate bunchcodec's block.");
+    }
+    e->codec = codec;
+    e->level = level;
+    e->num_threads = num_threads;
+    e->num_threads_min_size = num_threads_min_size;
+#ifdef IACT_ZSTD
+    if (codec == IACT_CODEC_ZSTD) {
+        e->zstd = ZSTD_createCCtx();
+        iact_check(e->zstd != NULL, "Can not create zstd-context.");
+        e->out_capacity = ZSTD_CStreamOutSize();
+    }
+#endif
+#ifdef IACT_LZ4
+    if (codec == IACT_CODEC_LZ4) {
+        iact_check(
+            !LZ4F_isError(LZ4F_createCompressionContext(&e->lz4, LZ4F_VERSION)),
+            "Can not create lz4-context.");
+        e->out_capacity = LZ4F_compressBound(IACT_ENCODER_CHUNK_SIZE, NULL);
+    }
+#endif
+    if (codec != IACT_CODEC_NONE) {
+        e->out = (char *)malloc(e->out_capacity);
+        iact_check(e->out != NULL, "Can not allocate encoder's buffer.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  Start a new compressed frame. The expected_size is a hint, or zero if
+ *  unknown.
+ */
+int iact_encoder_begin(
+    struct iact_encoder *e,
+    const uint64_t expected_size,
+    iact_sink_t sink,
+    void *sink_arg) {
+    iact_check(
+        e->bunchcodec || e->codec != IACT_CODEC_NONE, "Expected an encoding.");
+#ifdef IACT_ZSTD
+    if (e->codec == IACT_CODEC_ZSTD) {
+        const int num_threads =
+            expected_size >= e->num_threads_min_size ? e->num_threads : 0;
+        ZSTD_CCtx_reset(e->zstd, ZSTD_reset_session_and_parameters);
+        iact_check(
+            !ZSTD_isError(ZSTD_CCtx_setParameter(
+                e->zstd, ZSTD_c_compressionLevel, e->level)),
+            "Can not set zstd's compression-level.");
+        if (num_threads > 0 && ZSTD_isError(ZSTD_CCtx_setParameter(
+                e->zstd, ZSTD_c_nbWorkers, num_threads))) {
+            fprintf(stderr, "[WARNING] zstd has no worker-threads.\n");
+        }
+    }
+#endif
+#ifdef IACT_LZ4
+    if (e->codec == IACT_CODEC_LZ4) {
+        const size_t rc = LZ4F_compressBegin(
+            e->lz4, e->out, e->out_capacity, NULL);
+        iact_check(!LZ4F_isError(rc), "Can not begin lz4-frame.");
+        iact_check(sink(sink_arg, e->out, rc), "Can not drain lz4-header.");
+    }
+#endif
+    return 1;
+error:
+    return 0;
+}
+
+#ifdef IACT_ZSTD
+int iact_encoder_zstd(
+    struct iact_encoder *e,
+    const void *data,
+    const uint64_t size,
+    const ZSTD_EndDirective directive,
+    iact_sink_t sink,
+    void *sink_arg) {
+    ZSTD_inBuffer in = {data, size, 0};
+    size_t remaining = 0;
+    do {
+        ZSTD_outBuffer out = {e->out, e->out_capacity, 0};
+        remaining = ZSTD_compressStream2(e->zstd, &out, &in, directive);
+        iact_check(!ZSTD_isError(remaining), "Can not compress with zstd.");
+        if (out.pos > 0) {
+            iact_check(
+                sink(sink_arg, e->out, out.pos),
+                "Can not drain zstd's output.");
+        }
+    } while (
+        (directive == ZSTD_e_end && remaining > 0) ||
+        (directive != ZSTD_e_end && in.pos < in.size));
+    return 1;
+error:
+    return 0;
+}
+#endif
+
+int iact_encoder_compress(
+    struct iact_encoder *e,
+    const void *data,
+    const uint64_t size,
+    iact_sink_t sink,
+    void *sink_arg) {
+    const char *chunk = (const char *)data;
+    uint64_t remaining = size;
+    iact_check(e->codec != IACT_CODEC_NONE, "Expected a codec.");
+    while (remaining > 0) {
+        const uint64_t chunk_size = remaining < IACT_ENCODER_CHUNK_SIZE ?
+            remaining : IACT_ENCODER_CHUNK_SIZE;
+#ifdef IACT_ZSTD
+        if (e->codec == IACT_CODEC_ZSTD) {
+            iact_check(
+                iact_encoder_zstd(
+                    e, chunk, chunk_size, ZSTD_e_continue, sink, sink_arg),
+                "Can not update zstd-frame.");
+        }
+#endif
+#ifdef IACT_LZ4
+        if (e->codec == IACT_CODEC_LZ4) {
+            const size_t rc = LZ4F_compressUpdate(
+                e->lz4, e->out, e->out_capacity, chunk, chunk_size, NULL);
+            iact_check(!LZ4F_isError(rc), "Can not update lz4-frame.");
+            iact_check(sink(sink_arg, e->out, rc), "Can not drain lz4.");
+        }
+#endif
+        chunk += chunk_size;
+        remaining -= chunk_size;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  Transform the bunches block by block, and compress the blocks. The size
+ *  must be a multiple of IACT_NUM_BYTES_IN_BUNCH.
+ */
+int iact_encoder_update(
+    struct iact_encoder *e,
+    const void *data,
+    const uint64_t size,
+    iact_sink_t sink,
+    void *sink_arg) {
+    const float *bunches = (const float *)data;
+    uint64_t remaining = size/IACT_NUM_BYTES_IN_BUNCH;
+    iact_check(
+        e->bunchcodec || e->codec != IACT_CODEC_NONE, "Expected an encoding.");
+    if (!e->bunchcodec) {
+        return iact_encoder_compress(e, data, size, sink, sink_arg);
+    }
+    iact_check(
+        size % IACT_NUM_BYTES_IN_BUNCH == 0,
+        "Expected only complete bunches.");
+    while (remaining > 0) {
+        const uint64_t num_bunches =
+            remaining < IACT_BUNCHCODEC_BLOCK_NUM_BUNCHES ?
+            remaining : IACT_BUNCHCODEC_BLOCK_NUM_BUNCHES;
+        const uint64_t block_size = bunchcodec_encode(
+            bunches, num_bunches, BUNCHCODEC_DEFAULT_DELTA_MASK, e->block);
+        if (e->codec != IACT_CODEC_NONE) {
+            iact_check(
+                iact_encoder_compress(e, e->block, block_size, sink, sink_arg),
+                "Can not compress bunchcodec's block.");
+        } else {
+            iact_check(
+                sink(sink_arg, e->block, block_size),
+                "Can not drain bunchcodec's block.");
+        }
+        bunches += num_bunches*IACT_NUM_FLOATS_IN_BUNCH;
+        remaining -= num_bunches;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+int iact_encoder_end(struct iact_encoder *e, iact_sink_t sink, void *sink_arg) {
+    iact_check(
+        e->bunchcodec || e->codec != IACT_CODEC_NONE, "Expected an encoding.");
+#ifdef IACT_ZSTD
+    if (e->codec == IACT_CODEC_ZSTD) {
+        iact_check(
+            iact_encoder_zstd(e, NULL, 0, ZSTD_e_end, sink, sink_arg),
+            "Can not end zstd-frame.");
+    }
+#endif
+#ifdef IACT_LZ4
+    if (e->codec == IACT_CODEC_LZ4) {
+        const size_t rc = LZ4F_compressEnd(
+            e->lz4, e->out, e->out_capacity, NULL);
+        iact_check(!LZ4F_isError(rc), "Can not end lz4-frame.");
+        iact_check(sink(sink_arg, e->out, rc), "Can not drain lz4-end.");
+    }
+#endif
+    return 1;
+error:
+    return 0;
+}
+
+void iact_encoder_free(struct iact_encoder *e) {
+#ifdef IACT_ZSTD
+    if (e->zstd != NULL) {
+        ZSTD_freeCCtx(e->zstd);
+    }
+#endif
+#ifdef IACT_LZ4
+    if (e->lz4 != NULL) {
+        LZ4F_freeCompressionContext(e->lz4);
+    }
+#endif
+    free(e->out);
+    free(e->block);
+    memset(e, 0, sizeof(struct iact_encoder));
+}
+
+struct iact_encoder_sink {
+    struct iact_encoder *encoder;
+    iact_sink_t sink;
+    void *sink_arg;
+};
+
+int iact_sink_encoder(void *arg, const void *data, uint64_t size) {
+    struct iact_encoder_sink *es = (struct iact_encoder_sink *)arg;
+    return iact_encoder_update(es->encoder, data, size, es->sink, es->sink_arg);
+}
+
+//-------------------- compact bunches -----------------------------------------
+
+/*
+ *  A lossy, compact format of an event's bunches, see COMPACT_BUNCHES.
+ *  Each column is stored in the smallest of these modes:
+ *
+ *      CONSTANT    no data, all bunches have the value 'origin'
+ *      INT16       fixed-point, value = origin + q*resolution
+ *      INT32       fixed-point, value = origin + q*resolution
+ *      FLOAT16     value = origin + h, with origin the column's minimum
+ *      FLOAT32     value, lossless
+ *
+ *  For fixed-point, origin is the middle of the column's range. The payload
+ *  is:
+ *
+ *      uint32  magic               IACT_COMPACT_MAGIC
+ *      uint32  num_columns         8
+ *      uint64  num_bunches
+ *      struct iact_compact_column[8]
+ *      column 0, ..., column 7     each padded to 8 bytes
+ *      float64 max_error[8]        largest |decoded - original|
+ */
+
+#define IACT_COMPACT_MAGIC 0x31544350u /* "PCT1" */
+#define IACT_COMPACT_CHUNK_SIZE 4096
+
+enum {
+    IACT_COMPACT_CONSTANT = 0,
+    IACT_COMPACT_INT16 = 1,
+    IACT_COMPACT_INT32 = 2,
+    IACT_COMPACT_FLOAT16 = 3,
+    IACT_COMPACT_FLOAT32 = 4
+};
+
+struct iact_compact_column {
+    uint32_t mode;
+    uint32_t reserved;
+    double origin;
+    double resolution;
+};
+
+uint16_t iact_float_to_half(const float f) {
+    uint32_t x, sign, mant, half, rem, shift;
+    int32_t exp;
+    memcpy(&x, &f, sizeof(float));
+    sign = (x >> 16) & 0x8000u;
+    exp = (int32_t)((x >> 23) & 0xFFu) - 127 + 15;
+    mant = x & 0x7FFFFFu;
+    if (((x >> 23) & 0xFFu) == 0xFFu) {
+        return sign | 0x7C00u | (mant ? 0x200u : 0u);
+    }
+    if (exp >= 31) {
+        return sign | 0x7C00u;
+    }
+    if (exp <= 0) {
+        if (exp < -10) {
+            return sign;
+        }
+        mant |= 0x800000u;
+        shift = 14 - exp;
+        half = mant >> shift;
+        rem = mant & ((1u << shift) - 1u);
+        if (rem > (1u << (shift - 1)) ||
+            (rem == (1u << (shift - 1)) && (half & 1u))) {
+            half += 1u;
+        }
+        return sign | half;
+    }
+    half = sign | ((uint32_t)exp << 10) | (mant >> 13);
+    rem = mant & 0x1FFFu;
+    if (rem > 0x1000u || (rem == 0x1000u && (half & 1u))) {
+        half += 1u;
+    }
+    return half;
+}
+
+float iact_half_to_float(const uint16_t h) {
+    const uint32_t exp = (h >> 10) & 0x1Fu;
+    const uint32_t mant = h & 0x3FFu;
+    float f;
+    if (exp == 0u) {
+        f = ldexpf((float)mant, -24);
+    } else if (exp == 31u) {
+        f = mant ? NAN : INFINITY;
+    } else {
+        const uint32_t x = ((exp - 15u + 127u) << 23) | (mant << 13);
+        memcpy(&f, &x, sizeof(float));
+    }
+    return (h & 0x8000u) ? -f : f;
+}
+
+struct iact_compact_stats {
+    double min[8];
+    double max[8];
+    int has_nan[8];
+    uint64_t num_bunches;
+};
+
+void iact_compact_stats_init(struct iact_compact_stats *st) {
+    int c;
+    for (c = 0; c < 8; c++) {
+        st->min[c] = INFINITY;
+        st->max[c] = -INFINITY;
+        st->has_nan[c] = 0;
+    }
+    st->num_bunches = 0u;
+}
+
+int iact_sink_compact_stats(void *arg, const void *data, uint64_t size) {
+    struct iact_compact_stats *st = (struct iact_compact_stats *)arg;
+    const float *bunches = (const float *)data;
+    const uint64_t num_bunches = size/IACT_NUM_BYTES_IN_BUNCH;
+    uint64_t i;
+    int c;
+    for (i = 0; i < num_bunches; i++) {
+        for (c = 0; c < 8; c++) {
+            const double v = bunches[i*IACT_NUM_FLOATS_IN_BUNCH + c];
+            if (v != v) {
+                st->has_nan[c] = 1;
+            } else {
+                st->min[c] = v < st->min[c] ? v : st->min[c];
+                st->max[c] = v > st->max[c] ? v : st->max[c];
+            }
+        }
+    }
+    st->num_bunches += num_bunches;
+    return 1;
+}
+
+/*
+ *  Choose the smallest mode which keeps the requested resolution.
+ */
+void iact_compact_choose_mode(
+    const struct iact_compact_stats *st,
+    const int c,
+    const double resolution,
+    struct iact_compact_column *col) {
+    const double range = st->max[c] - st->min[c];
+    memset(col, 0, sizeof(struct iact_compact_column));
+    col->mode = IACT_COMPACT_FLOAT32;
+    if (st->has_nan[c] || !isfinite(range)) {
+        if (st->num_bunches == 0u) {
+            col->mode = IACT_COMPACT_CONSTANT;
+        }
+        return;
+    }
+    if (range == 0.0) {
+        col->mode = IACT_COMPACT_CONSTANT;
+        col->origin = st->min[c];
+    } else if (resolution == IACT_COMPACT_HALF) {
+        if (range <= 65504.0) {
+            col->mode = IACT_COMPACT_FLOAT16;
+            col->origin = st->min[c];
+        }
+    } else if (resolution > 0.0) {
+        col->origin = 0.5*(st->min[c] + st->max[c]);
+        col->resolution = resolution;
+        if (0.5*range/resolution < 32767.0) {
+            col->mode = IACT_COMPACT_INT16;
+        } else if (0.5*range/resolution < 2147483647.0) {
+            col->mode = IACT_COMPACT_INT32;
+        }
+    }
+}
+
+uint64_t iact_compact_num_bytes_per_value(const uint32_t mode) {
+    switch (mode) {
+        case IACT_COMPACT_INT16: return 2u;
+        case IACT_COMPACT_INT32: return 4u;
+        case IACT_COMPACT_FLOAT16: return 2u;
+        case IACT_COMPACT_FLOAT32: return 4u;
+    }
+    return 0u;
+}
+
+struct iact_compact_sink {
+    const struct iact_compact_column *col;
+    int column;
+    double max_error;
+    struct iact_arena *out;
+};
+
+/*
+ *  Quantise one column of the bunches and append it to the out-arena.
+ */
+int iact_sink_compact_column(void *arg, const void *data, uint64_t size) {
+    struct iact_compact_sink *cs = (struct iact_compact_sink *)arg;
+    const struct iact_compact_column *col = cs->col;
+    const float *bunches = (const float *)data;
+    const uint64_t width = iact_compact_num_bytes_per_value(col->mode);
+    char chunk[4*IACT_COMPACT_CHUNK_SIZE];
+    uint64_t remaining = size/IACT_NUM_BYTES_IN_BUNCH;
+    while (remaining > 0) {
+        uint64_t i;
+        const uint64_t num = remaining < IACT_COMPACT_CHUNK_SIZE ?
+            remaining : IACT_COMPACT_CHUNK_SIZE;
+        for (i = 0; i < num; i++) {
+            const float v = bunches[i*IACT_NUM_FLOATS_IN_BUNCH + cs->column];
+            float decoded = v;
+            if (col->mode == IACT_COMPACT_INT16 ||
+                col->mode == IACT_COMPACT_INT32) {
+                const double q = round((v - col->origin)/col->resolution);
+                decoded = (float)(col->origin + q*col->resolution);
+                if (col->mode == IACT_COMPACT_INT16) {
+                    const int16_t q16 = (int16_t)q;
+                    memcpy(chunk + 2*i, &q16, 2);
+                } else {
+                    const int32_t q32 = (int32_t)q;
+                    memcpy(chunk + 4*i, &q32, 4);
+                }
+            } else if (col->mode == IACT_COMPACT_FLOAT16) {
+                const uint16_t h = iact_float_to_half((float)(v - col->origin));
+                decoded = (float)(col->origin + iact_half_to_float(h));
+                memcpy(chunk + 2*i, &h, 2);
+            } else if (col->mode == IACT_COMPACT_FLOAT32) {
+                memcpy(chunk + 4*i, &v, 4);
+            }
+            if (fabs((double)decoded - (double)v) > cs->max_error) {
+                cs->max_error = fabs((double)decoded - (double)v);
+            }
+        }
+        if (width > 0u) {
+            iact_check(
+                iact_arena_append(cs->out, chunk, num*width),
+                "Can not append compact column.");
+        }
+        bunches += num*IACT_NUM_FLOATS_IN_BUNCH;
+        remaining -= num;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  Write the compact payload of the bunches in arena into out. This reads
+ *  the arena once for the ranges, and once for each column.
+ */
+int iact_compact(
+    const struct iact_arena *arena,
+    const double resolution[8],
+    struct iact_arena *out) {
+    const char nul[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    const uint32_t magic = IACT_COMPACT_MAGIC;
+    const uint32_t num_columns = 8;
+    struct iact_compact_stats st;
+    struct iact_compact_column cols[8];
+    double max_error[8];
+    int c;
+
+    iact_compact_stats_init(&st);
+    iact_check(
+        iact_arena_drain(arena, iact_sink_compact_stats, &st),
+        "Can not find ranges of bunches.");
+    for (c = 0; c < 8; c++) {
+        iact_compact_choose_mode(&st, c, resolution[c], &cols[c]);
+    }
+    iact_check(
+        iact_arena_append(out, &magic, sizeof(uint32_t)) &&
+        iact_arena_append(out, &num_columns, sizeof(uint32_t)) &&
+        iact_arena_append(out, &st.num_bunches, sizeof(uint64_t)) &&
+        iact_arena_append(out, cols, sizeof(cols)),
+        "Can not append header of compact bunches.");
+    for (c = 0; c < 8; c++) {
+        struct iact_compact_sink cs;
+        const uint64_t column_size =
+            st.num_bunches*iact_compact_num_bytes_per_value(cols[c].mode);
+        cs.col = &cols[c];
+        cs.column = c;
+        cs.max_error = 0.0;
+        cs.out = out;
+        iact_check(
+            iact_arena_drain(arena, iact_sink_compact_column, &cs),
+            "Can not write compact column.");
+        iact_check(
+            iact_arena_append(out, nul, (8u - column_size % 8u) % 8u),
+            "Can not pad compact column.");
+        max_error[c] = cs.max_error;
+    }
+    iact_check(
+        iact_arena_append(out, max_error, sizeof(max_error)),
+        "Can not append max_error of compact bunches.");
+    return 1;
+error:
+    return 0;
+}
+
+//-------------------- arrow ---------------------------------------------------
+
+/*
+ *  Alternative to the tar, see OUTPUT_FORMAT. The bunches of an event become
+ *  one record-batch with a column for each of the bunch's 8 floats. The
+ *  RUNH is the schema's metadata, and the other members of an event, e.g.
+ *  the EVTH, become the batch's metadata. Metadata must be text, so the
+ *  binary blocks are encoded in base64.
+ */
+
+#define IACT_ARROW_MAX_NUM_METADATA 16
+#define IACT_ARROW_COLUMN_CHUNK_SIZE 4096
+
+char *iact_base64(const void *data, const uint64_t size) {
+    const char *table =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const unsigned char *in = (const unsigned char *)data;
+    char *out = (char *)malloc(4*((size + 2)/3) + 1);
+    uint64_t i, o = 0;
+    iact_check(out != NULL, "Can not allocate base64.");
+    for (i = 0; i < size; i += 3) {
+        const uint32_t n =
+            ((uint32_t)in[i] << 16) |
+            ((i + 1 < size ? (uint32_t)in[i + 1] : 0u) << 8) |
+            (i + 2 < size ? (uint32_t)in[i + 2] : 0u);
+        out[o++] = table[(n >> 18) & 63];
+        out[o++] = table[(n >> 12) & 63];
+        out[o++] = i + 1 < size ? table[(n >> 6) & 63] : '=';
+        out[o++] = i + 2 < size ? table[n & 63] : '=';
+    }
+    out[o] = '\0';
+    return out;
+error:
+    return NULL;
+}
+
+struct iact_arrow_column_sink {
+    arrowipc_t *arrow;
+    int column;
+};
+
+/*
+ *  Pick one column out of the interleaved bunches.
+ */
+int iact_sink_arrow_column(void *arg, const void *data, uint64_t size) {
+    struct iact_arrow_column_sink *cs = (struct iact_arrow_column_sink *)arg;
+    const float *bunches = (const float *)data;
+    float column[IACT_ARROW_COLUMN_CHUNK_SIZE];
+    uint64_t remaining = size/IACT_NUM_BYTES_IN_BUNCH;
+    while (remaining > 0) {
+        uint64_t i;
+        const uint64_t num = remaining < IACT_ARROW_COLUMN_CHUNK_SIZE ?
+            remaining : IACT_ARROW_COLUMN_CHUNK_SIZE;
+        for (i = 0; i < num; i++) {
+            column[i] = bunches[i*IACT_NUM_FLOATS_IN_BUNCH + cs->column];
+        }
+        iact_check(
+            arrowipc_write_column(
+                cs->arrow, column, num*sizeof(float)) == ARROWIPC_ESUCCESS,
+            "Can not write column to arrow-stream.");
+        bunches += num*IACT_NUM_FLOATS_IN_BUNCH;
+        remaining -= num;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+//-------------------- event index ---------------------------------------------
+
+/*
+ *  The event-index is the last member of the tar. For each event, it has the
+ *  offsets of the tar-headers and the sizes of the event-header's and the
+ *  bunches' members, and the number of bunches. It is written with
+ *  mtar_write_index(), so readers find it from the tail of the tar and jump
+ *  straight to an event. When the bunches are split into chunks, the header
+ *  is the first chunk's, and the sizes and numbers of bunches of all chunks
+ *  are summed up.
+ */
+
+const char *IACT_INDEX_FILENAME = "event_index.int64";
+
+enum {
+    IACT_INDEX_NONE = 0,
+    IACT_INDEX_EVTH = 1,
+    IACT_INDEX_BUNCHES = 2
+};
+
+struct iact_index_record {
+    int64_t event_number;
+    int64_t evth_header;
+    int64_t evth_size;
+    int64_t bunches_header;
+    int64_t bunches_size;
+    int64_t num_bunches;
+};
+
+struct iact_index {
+    struct iact_index_record *records;
+    uint64_t num_records;
+    uint64_t capacity;
+};
+
+void iact_index_init(struct iact_index *idx) {
+    idx->records = NULL;
+    idx->num_records = 0u;
+    idx->capacity = 0u;
+}
+
+int iact_index_append_evth(
+    struct iact_index *idx,
+    const int64_t event_number,
+    const uint64_t header,
+    const uint64_t size) {
+    struct iact_index_record *r;
+    if (idx->num_records == idx->capacity) {
+        const uint64_t capacity = idx->capacity ? 2u*idx->capacity : 1024u;
+        struct iact_index_record *records = (struct iact_index_record *)
+            realloc(idx->records, capacity*sizeof(struct iact_index_record));
+        iact_check(records != NULL, "Can not grow event-index.");
+        idx->records = records;
+        idx->capacity = capacity;
+    }
+    r = &idx->records[idx->num_records];
+    r->event_number = event_number;
+    r->evth_header = (int64_t)header;
+    r->evth_size = (int64_t)size;
+    r->bunches_header = -1;
+    r->bunches_size = 0;
+    r->num_bunches = 0;
+    idx->num_records += 1;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_index_add_bunches(
+    struct iact_index *idx,
+    const int64_t event_number,
+    const uint64_t header,
+    const uint64_t size,
+    const uint64_t num_bunches) {
+    struct iact_index_record *r;
+    iact_check(idx->num_records > 0, "Expected evth in event-index.");
+    r = &idx->records[idx->num_records - 1];
+    iact_check(
+        r->event_number == event_number,
+        "Expected bunches of same event as last evth in event-index.");
+    if (r->bunches_header < 0) {
+        r->bunches_header = (int64_t)header;
+    }
+    r->bunches_size += (int64_t)size;
+    r->num_bunches += (int64_t)num_bunches;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_index_write_to_tar(const struct iact_index *idx, mtar_t *tar) {
+    return mtar_write_index(
+        tar,
+        IACT_INDEX_FILENAME,
+        idx->records,
+        sizeof(struct iact_index_record),
+        idx->num_records) == MTAR_ESUCCESS;
+}
+
+void iact_index_free(struct iact_index *idx) {
+    free(idx->records);
+    iact_index_init(idx);
+}
+
+//-------------------- writer --------------------------------------------------
+
+/*
+ *  All members are written into the tar by the writer. The writer executes
+ *  jobs in the order they are submitted. Photon-bunches are handed to the
+ *  writer in arenas from a fixed pool. The writer resets an arena and puts it
+ *  back into the pool once its payload is in the tar.
+ *
+ *  Optionally, the writer runs in its own thread. Then CORSIKA only waits for
+ *  the output when the queue is full, or when all arenas are in use.
+ */
+
+enum {
+    IACT_JOB_MEMBER = 0,
+    IACT_JOB_BEGIN = 1,
+    IACT_JOB_APPEND = 2,
+    IACT_JOB_END = 3,
+    IACT_JOB_INDEX = 4,
+    IACT_JOB_QUIT = 5
+};
+
+struct iact_job {
+    int kind;
+    int encode;
+    int index_role;
+    int event_number;
+    char name[100];
+    char *data;
+    uint64_t size;
+    struct iact_arena *arena;
+};
+
+#define IACT_WRITER_MAX_NUM_JOBS 64
+#define IACT_WRITER_MAX_NUM_ARENAS 16
+
+struct iact_writer {
+    mtar_t *tar;
+    arrowipc_t *arrow;
+    char *arrow_keys[IACT_ARROW_MAX_NUM_METADATA];
+    char *arrow_values[IACT_ARROW_MAX_NUM_METADATA];
+    int arrow_num_metadata;
+    int async;
+    struct iact_encoder encoder;
+    struct iact_arena encoded;
+    int compact;
+    double compact_resolution[8];
+    struct iact_arena compacted;
+    struct iact_index index;
+    int index_role;
+    int index_event_number;
+    uint64_t index_num_bunch_bytes;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int error;
+
+    struct iact_job jobs[IACT_WRITER_MAX_NUM_JOBS];
+    uint64_t first_job;
+    uint64_t num_jobs;
+
+    struct iact_arena arenas[IACT_WRITER_MAX_NUM_ARENAS];
+    struct iact_arena *free_arenas[IACT_WRITER_MAX_NUM_ARENAS];
+    int num_arenas;
+    int num_free_arenas;
+
+    double producer_wait_s;
+    uint64_t producer_num_waits;
+    uint64_t queue_high_water_mark;
+};
+
+double iact_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9*(double)ts.tv_nsec;
+}
+
+void iact_writer_release_arena(
+    struct iact_writer *w,
+    struct iact_arena *arena) {
+    if (w->async) {
+        pthread_mutex_lock(&w->mutex);
+    }
+    w->free_arenas[w->num_free_arenas] = arena;
+    w->num_free_arenas += 1;
+    if (w->async) {
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->mutex);
+    }
+}
+
+/*
+ *  Encode the arena into the writer's scratch-arena 'encoded' and write it
+ *  as a member.
+ */
+int iact_writer_encoded_member(
+    struct iact_writer *w,
+    const char *name,
+    const struct iact_arena *arena) {
+    char encoded_name[1024] = "";
+    struct iact_encoder_sink es;
+    es.encoder = &w->encoder;
+    es.sink = iact_sink_arena;
+    es.sink_arg = &w->encoded;
+    snprintf(
+        encoded_name, sizeof(encoded_name),
+        "%s%s", name, w->encoder.suffix);
+
+    iact_check(
+        iact_encoder_begin(
+            &w->encoder,
+            iact_arena_num_bytes(arena),
+            iact_sink_arena,
+            &w->encoded),
+        "Can't begin encoding.");
+    iact_check(
+        iact_arena_drain(arena, iact_sink_encoder, &es),
+        "Can't encode arena.");
+    iact_check(
+        iact_encoder_end(&w->encoder, iact_sink_arena, &w->encoded),
+        "Can't end encoding.");
+    iact_check(
+        mtar_write_file_header(
+            w->tar,
+            encoded_name,
+            iact_arena_num_bytes(&w->encoded)) == MTAR_ESUCCESS,
+        "Can't write tar-header to tar-file.");
+    iact_check(
+        iact_arena_write_to_tar(&w->encoded, w->tar),
+        "Can't write encoded arena to tar-file.");
+    iact_check(iact_arena_reset(&w->encoded), "Can't reset encoded arena.");
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  Write the arena's bunches in the compact format, and compress them when
+ *  a codec is set.
+ */
+int iact_writer_compact_member(
+    struct iact_writer *w,
+    const char *name,
+    const struct iact_arena *arena) {
+    iact_check(
+        iact_compact(arena, w->compact_resolution, &w->compacted),
+        "Can't compact bunches.");
+    if (w->encoder.codec != IACT_CODEC_NONE) {
+        iact_check(
+            iact_writer_encoded_member(w, name, &w->compacted),
+            "Can't write encoded compact bunches to tar-file.");
+    } else {
+        iact_check(
+            mtar_write_file_header(
+                w->tar,
+                name,
+                iact_arena_num_bytes(&w->compacted)) == MTAR_ESUCCESS,
+            "Can't write tar-header to tar-file.");
+        iact_check(
+            iact_arena_write_to_tar(&w->compacted, w->tar),
+            "Can't write compact bunches to tar-file.");
+    }
+    iact_check(
+        iact_arena_reset(&w->compacted),
+        "Can't reset compacted arena.");
+    return 1;
+error:
+    return 0;
+}
+
+void iact_writer_free_arrow_metadata(struct iact_writer *w) {
+    int i;
+    for (i = 0; i < w->arrow_num_metadata; i++) {
+        free(w->arrow_keys[i]);
+        free(w->arrow_values[i]);
+    }
+    w->arrow_num_metadata = 0;
+}
+
+/*
+ *  Members without bunches are held back as metadata of the next batch. The
+ *  event-number is stripped from their names, e.g. 'evth.float32'.
+ */
+int iact_writer_execute_arrow(struct iact_writer *w, struct iact_job *job) {
+    int c;
+    iact_check(
+        job->kind == IACT_JOB_MEMBER,
+        "Expected arrow-stream to be written without SINGLE_PASS.");
+    if (job->arena == NULL) {
+        const char *key = job->name;
+        const int n = w->arrow_num_metadata;
+        if (strlen(key) > 10 && key[9] == '.') {
+            key += 10;
+        }
+        iact_check(
+            n < IACT_ARROW_MAX_NUM_METADATA,
+            "Too many members for metadata of arrow-batch.");
+        w->arrow_keys[n] = strdup(key);
+        w->arrow_values[n] = iact_base64(job->data, job->size);
+        w->arrow_num_metadata += 1;
+        iact_check(
+            w->arrow_keys[n] != NULL && w->arrow_values[n] != NULL,
+            "Can not allocate metadata of arrow-batch.");
+        if (strcmp(job->name, "runh.float32") == 0) {
+            iact_check(
+                arrowipc_write_schema(
+                    w->arrow,
+                    IACT_NUM_FLOATS_IN_BUNCH,
+                    IACT_BUNCH_COLUMN_NAMES,
+                    w->arrow_num_metadata,
+                    (const char **)w->arrow_keys,
+                    (const char **)w->arrow_values) == ARROWIPC_ESUCCESS,
+                "Can't write schema to arrow-stream.");
+            iact_writer_free_arrow_metadata(w);
+        }
+        return 1;
+    }
+    iact_check(
+        arrowipc_write_batch(
+            w->arrow,
+            iact_arena_num_bytes(job->arena)/IACT_NUM_BYTES_IN_BUNCH,
+            IACT_NUM_FLOATS_IN_BUNCH,
+            w->arrow_num_metadata,
+            (const char **)w->arrow_keys,
+            (const char **)w->arrow_values) == ARROWIPC_ESUCCESS,
+        "Can't write batch to arrow-stream.");
+    iact_writer_free_arrow_metadata(w);
+    for (c = 0; c < IACT_NUM_FLOATS_IN_BUNCH; c++) {
+        struct iact_arrow_column_sink cs;
+        cs.arrow = w->arrow;
+        cs.column = c;
+        iact_check(
+            iact_arena_drain(job->arena, iact_sink_arrow_column, &cs),
+            "Can't write bunches to arrow-stream.");
+        iact_check(
+            arrowipc_end_column(w->arrow) == ARROWIPC_ESUCCESS,
+            "Can't end column in arrow-stream.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  Add the member which was just written to the tar to the event-index when
+ *  it was announced by an IACT_JOB_INDEX.
+ */
+int iact_writer_index_last_member(struct iact_writer *w) {
+    switch (w->index_role) {
+        case IACT_INDEX_EVTH:
+            iact_check(
+                iact_index_append_evth(
+                    &w->index,
+                    w->index_event_number,
+                    w->tar->last_header,
+                    w->tar->last_size),
+                "Can't add evth to event-index.");
+            break;
+        case IACT_INDEX_BUNCHES:
+            iact_check(
+                iact_index_add_bunches(
+                    &w->index,
+                    w->index_event_number,
+                    w->tar->last_header,
+                    w->tar->last_size,
+                    w->index_num_bunch_bytes/IACT_NUM_BYTES_IN_BUNCH),
+                "Can't add bunches to event-index.");
+            break;
+    }
+    w->index_role = IACT_INDEX_NONE;
+    return 1;
+error:
+    return 0;
+}
+
+int iact_writer_execute_tar(struct iact_writer *w, struct iact_job *job) {
+    char name[1024] = "";
+    struct iact_encoder_sink es;
+    es.encoder = &w->encoder;
+    es.sink = iact_sink_tar_append;
+    es.sink_arg = w->tar;
+
+    switch (job->kind) {
+        case IACT_JOB_MEMBER:
+            if (job->arena != NULL) {
+                w->index_num_bunch_bytes += iact_arena_num_bytes(job->arena);
+            }
+            if (job->arena != NULL && job->encode && w->compact) {
+                iact_check(
+                    iact_writer_compact_member(w, job->name, job->arena),
+                    "Can't write compact member to tar-file.");
+            } else if (job->arena != NULL && job->encode) {
+                iact_check(
+                    iact_writer_encoded_member(w, job->name, job->arena),
+                    "Can't write encoded member to tar-file.");
+            } else if (job->arena != NULL) {
+                iact_check(
+                    mtar_write_file_header(
+                        w->tar,
+                        job->name,
+                        iact_arena_num_bytes(job->arena)) == MTAR_ESUCCESS,
+                    "Can't write tar-header to tar-file.");
+                iact_check(
+                    iact_arena_write_to_tar(job->arena, w->tar),
+                    "Can't write data of arena to tar-file.");
+            } else {
+                iact_check(
+                    mtar_write_file_header(
+                        w->tar, job->name, job->size) == MTAR_ESUCCESS,
+                    "Can't write tar-header to tar-file.");
+                if (job->size > 0u) {
+                    iact_check(
+                        mtar_write_data(
+                            w->tar, job->data, job->size) == MTAR_ESUCCESS,
+                        "Can't write data to tar-file.");
+                }
+            }
+            iact_check(
+                iact_writer_index_last_member(w),
+                "Can't add member to event-index.");
+            break;
+        case IACT_JOB_BEGIN:
+            snprintf(
+                name, sizeof(name), "%s%s",
+                job->name,
+                job->encode ? w->encoder.suffix : "");
+            iact_check(
+                mtar_begin_file(w->tar, name) == MTAR_ESUCCESS,
+                "Can't write placeholder tar-header to tar-file.");
+            if (job->encode) {
+                iact_check(
+                    iact_encoder_begin(
+                        &w->encoder, job->size, iact_sink_tar_append, w->tar),
+                    "Can't begin encoding.");
+            }
+            break;
+        case IACT_JOB_APPEND:
+            w->index_num_bunch_bytes += iact_arena_num_bytes(job->arena);
+            if (job->encode) {
+                iact_check(
+                    iact_arena_drain(job->arena, iact_sink_encoder, &es),
+                    "Can't encode arena into tar-file.");
+            } else {
+                iact_check(
+                    iact_arena_flush_to_tar(job->arena, w->tar),
+                    "Can't append data of arena to tar-file.");
+            }
+            break;
+        case IACT_JOB_END:
+            if (job->encode) {
+                iact_check(
+                    iact_encoder_end(
+                        &w->encoder, iact_sink_tar_append, w->tar),
+                    "Can't end encoding.");
+            }
+            iact_check(
+                mtar_end_file(w->tar) == MTAR_ESUCCESS,
+                "Can't patch tar-header in tar-file.");
+            iact_check(
+                iact_writer_index_last_member(w),
+                "Can't add member to event-index.");
+            break;
+        case IACT_JOB_INDEX:
+            w->index_role = job->index_role;
+            w->index_event_number = job->event_number;
+            w->index_num_bunch_bytes = 0u;
+            break;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+int iact_writer_execute(struct iact_writer *w, struct iact_job *job) {
+    if (w->arrow != NULL) {
+        iact_check(
+            iact_writer_execute_arrow(w, job),
+            "Can't write to arrow-stream.");
+    } else {
+        iact_check(
+            iact_writer_execute_tar(w, job),
+            "Can't write to tar-file.");
+    }
+    free(job->data);
+    job->data = NULL;
+    if (job->arena != NULL) {
+        iact_check(iact_arena_reset(job->arena), "Can't reset arena.");
+        iact_writer_release_arena(w, job->arena);
+        job->arena = NULL;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+void iact_writer_discard(struct iact_writer *w, struct iact_job *job) {
+    free(job->data);
+    job->data = NULL;
+    if (job->arena != NULL) {
+        iact_writer_release_arena(w, job->arena);
+        job->arena = NULL;
+    }
+}
+
+void *iact_writer_thread(void *arg) {
+    struct iact_writer *w = (struct iact_writer *)arg;
+    struct iact_job job;
+    int failed = 0;
+    while (1) {
+        pthread_mutex_lock(&w->mutex);
+        while (w->num_jobs == 0) {
+            pthread_cond_wait(&w->cond, &w->mutex);
+        }
+        job = w->jobs[w->first_job];
+        pthread_mutex_unlock(&w->mutex);
+
+        if (job.kind == IACT_JOB_QUIT) {
+            break;
+        }
+        if (failed || !iact_writer_execute(w, &job)) {
+            failed = 1;
+            iact_writer_discard(w, &job);
+        }
+
+        pthread_mutex_lock(&w->mutex);
+        w->error = failed;
+        w->first_job = (w->first_job + 1) % IACT_WRITER_MAX_NUM_JOBS;
+        w->num_jobs -= 1;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->mutex);
+    }
+    return NULL;
+}
+
+/*
+ *  The writer writes either into the tar, or into the arrow-stream. The
+ *  other one is NULL.
+ */
+int iact_writer_init(
+    struct iact_writer *w,
+    mtar_t *tar,
+    arrowipc_t *arrow,
+    const struct iact_options *opt) {
+    int i;
+    const int async = opt->async_writer;
+    const int num_arenas = opt->async_writer_num_buffers;
+    const uint64_t ram_cap = opt->arena_ram_cap;
+    memset(w, 0, sizeof(struct iact_writer));
+    w->tar = tar;
+    w->arrow = arrow;
+    w->async = async;
+    iact_arena_init(&w->encoded, ram_cap);
+    iact_arena_init(&w->compacted, ram_cap);
+    iact_index_init(&w->index);
+    w->compact = opt->compact;
+    memcpy(
+        w->compact_resolution,
+        opt->compact_resolution,
+        sizeof(w->compact_resolution));
+    if (opt->bunchcodec || opt->codec != IACT_CODEC_NONE) {
+        iact_check(
+            iact_encoder_init(
+                &w->encoder,
+                opt->bunchcodec,
+                opt->codec,
+                opt->codec_level,
+                opt->codec_num_threads,
+                opt->codec_num_threads_min_size),
+            "Can't init encoder of writer.");
+    }
+    w->num_arenas = async ? num_arenas : 1;
+    iact_check(
+        w->num_arenas >= 1 && w->num_arenas <= IACT_WRITER_MAX_NUM_ARENAS,
+        "Expected 1 <= ASYNC_WRITER_NUM_BUFFERS <= 16.");
+    if (opt->particles) {
+        /* Each event holds one more arena for its particles. */
+        w->num_arenas += 1;
+        iact_check(
+            w->num_arenas <= IACT_WRITER_MAX_NUM_ARENAS,
+            "Expected ASYNC_WRITER_NUM_BUFFERS < 16 with PARTICLES.");
+    }
+    for (i = 0; i < w->num_arenas; i++) {
+        iact_arena_init(&w->arenas[i], ram_cap);
+        w->free_arenas[i] = &w->arenas[i];
+    }
+    w->num_free_arenas = w->num_arenas;
+    if (w->async) {
+        iact_check(
+            pthread_mutex_init(&w->mutex, NULL) == 0,
+            "Can't init mutex of writer.");
+        iact_check(
+            pthread_cond_init(&w->cond, NULL) == 0,
+            "Can't init condition of writer.");
+        iact_check(
+            pthread_create(&w->thread, NULL, iact_writer_thread, w) == 0,
+            "Can't start thread of writer.");
+    }
+    return 1;
+error:
+    return 0;
+}
+
+struct iact_arena *iact_writer_acquire_arena(struct iact_writer *w) {
+    struct iact_arena *arena = NULL;
+    if (w->async) {
+        pthread_mutex_lock(&w->mutex);
+        if (w->num_free_arenas == 0) {
+            const double start = iact_seconds();
+            while (w->num_free_arenas == 0) {
+                pthread_cond_wait(&w->cond, &w->mutex);
+            }
+            w->producer_wait_s += iact_seconds() - start;
+            w->producer_num_waits += 1;
+        }
+    }
+    iact_check(w->num_free_arenas > 0, "Expected a free arena.");
+    w->num_free_arenas -= 1;
+    arena = w->free_arenas[w->num_free_arenas];
+    if (w->async) {
+        pthread_mutex_unlock(&w->mutex);
+    }
+    return arena;
+error:
+    if (w->async) {
+        pthread_mutex_unlock(&w->mutex);
+    }
+    return NULL;
+}
+
+int iact_writer_submit(struct iact_writer *w, const struct iact_job *job) {
+    int failed;
+    if (!w->async) {
+        struct iact_job tmp = *job;
+        return iact_writer_execute(w, &tmp);
+    }
+    pthread_mutex_lock(&w->mutex);
+    if (w->num_jobs == IACT_WRITER_MAX_NUM_JOBS) {
+        const double start = iact_seconds();
+        while (w->num_jobs == IACT_WRITER_MAX_NUM_JOBS) {
+            pthread_cond_wait(&w->cond, &w->mutex);
+        }
+        w->producer_wait_s += iact_seconds() - start;
+        w->producer_num_waits += 1;
+    }
+    w->jobs[(w->first_job + w->num_jobs) % IACT_WRITER_MAX_NUM_JOBS] = *job;
+    w->num_jobs += 1;
+    if (w->num_jobs > w->queue_high_water_mark) {
+        w->queue_high_water_mark = w->num_jobs;
+    }
+    failed = w->error;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+    iact_check(!failed, "Writer failed.");
+    return 1;
+error:
+    return 0;
+}
+
+int iact_writer_member(
+    struct iact_writer *w,
+    const char *name,
+    const void *data,
+    const uint64_t size) {
+    struct iact_job job;
+    memset(&job, 0, sizeof(job));
+    job.kind = IACT_JOB_MEMBER;
+    snprintf(job.name, sizeof(job.name), "%s", name);
+    if (size > 0u) {
+        job.data = (char *)malloc(size);
+        iact_check(job.data != NULL, "Can't allocate job for writer.");
+        memcpy(job.data, data, size);
+    }
+    job.size = size;
+    return iact_writer_submit(w, &job);
+error:
+    return 0;
+}
+
+int iact_writer_arena_member(
+    struct iact_writer *w,
+    const char *name,
+    struct iact_arena *arena,
+    const int encode) {
+    struct iact_job job;
+    memset(&job, 0, sizeof(job));
+    job.kind = IACT_JOB_MEMBER;
+    job.encode = encode;
+    snprintf(job.name, sizeof(job.name), "%s", name);
+    job.arena = arena;
+    return iact_writer_submit(w, &job);
+}
+
+int iact_writer_begin_member(
+    struct iact_writer *w,
+    const char *name,
+    const int encode,
+    const uint64_t expected_size) {
+    struct iact_job job;
+    memset(&job, 0, sizeof(job));
+    job.kind = IACT_JOB_BEGIN;
+    job.encode = encode;
+    job.size = expected_size;
+    snprintf(job.name, sizeof(job.name), "%s", name);
+    return iact_writer_submit(w, &job);
+}
+
+int iact_writer_append(
+    struct iact_writer *w,
+    struct iact_arena *arena,
+    const int encode) {
+    struct iact_job job;
+    memset(&job, 0, sizeof(job));
+    job.kind = IACT_JOB_APPEND;
+    job.encode = encode;
+    job.arena = arena;
+    return iact_writer_submit(w, &job);
+}
+
+int iact_writer_end_member(struct iact_writer *w, const int encode) {
+    struct iact_job job;
+    memset(&job, 0, sizeof(job));
+    job.kind = IACT_JOB_END;
+    job.encode = encode;
+    return iact_writer_submit(w, &job);
+}
+
+/*
+ *  The next member submitted is added to the event-index in the given role.
+ *  The arrow-stream has no event-index.
+ */
+int iact_writer_index_next_member(
+    struct iact_writer *w,
+    const int event_number,
+    const int role) {
+    struct iact_job job;
+    if (w->tar == NULL) {
+        return 1;
+    }
+    memset(&job, 0, sizeof(job));
+    job.kind = IACT_JOB_INDEX;
+    job.index_role = role;
+    job.event_number = event_number;
+    return iact_writer_submit(w, &job);
+}
+
+/*
+ *  Wait until all jobs are done, append the event-index to the tar, and free
+ *  the arenas.
+ */
+int iact_writer_finish(struct iact_writer *w) {
+    int i;
+    if (w->async) {
+        struct iact_job job;
+        memset(&job, 0, sizeof(job));
+        job.kind = IACT_JOB_QUIT;
+        iact_check(iact_writer_submit(w, &job), "Can't stop writer.");
+        iact_check(
+            pthread_join(w->thread, NULL) == 0,
+            "Can't join thread of writer.");
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->mutex);
+        fprintf(
+            stdout,
+            " iact.c: Producer waited for asynchronous writer %.3f s "
+            "in %lu waits. Queue high-water mark %lu of %d jobs.\n",
+            w->producer_wait_s,
+            (unsigned long)w->producer_num_waits,
+            (unsigned long)w->queue_high_water_mark,
+            IACT_WRITER_MAX_NUM_JOBS);
+    }
+    if (w->tar != NULL && !w->error) {
+        iact_check(
+            iact_index_write_to_tar(&w->index, w->tar),
+            "Can't write event-index to tar-file.");
+    }
+    for (i = 0; i < w->num_arenas; i++) {
+        iact_arena_free(&w->arenas[i]);
+    }
+    iact_arena_free(&w->encoded);
+    iact_arena_free(&w->compacted);
+    iact_encoder_free(&w->encoder);
+    iact_writer_free_arrow_metadata(w);
+    iact_index_free(&w->index);
+    iact_check(!w->error, "Writer failed.");
+    return 1;
+error:
+    return 0;
+}
+
+//-------------------- init ----------------------------------------------------
+int event_number;
+
+const char *PRIMARY_PATH = "primary_bytes.5xf8_12xi4";
+FILE *primary_file = NULL;
+
+const char *IACT_OPTIONS_PATH = "iact_options.txt";
+struct iact_options options;
+
+double primary_energy;
+struct iact_arena *cherenkov_arena = NULL;
+
+/*
+ *  When the tar is a regular file, the bunches are streamed into it in a
+ *  single pass and the member's header is patched in telend_. Else, e.g. for
+ *  a FIFO, the bunches of an event are buffered in the arena.
+ */
+#define IACT_SINGLE_PASS_BLOCK_SIZE (4u*1024u*1024u)
+int single_pass = 0;
+
+/*
+ *  The bunches are compacted, transformed, and or compressed by the writer.
+ */
+int encode_bunches = 0;
+
+char output_path[1024] = "";
+mtar_t tar;
+arrowipc_t arrow;
+struct iact_writer writer;
+
+int iact_is_seekable_path(const char *path) {
+    struct stat st;
+    if (stat(path, &st) != 0) {
+        errno = 0;
+        return 1;
+    }
+    return S_ISREG(st.st_mode);
+}
+
+/*
+ *  With TELESCOPE cards, the bunches are only stored for the telescopes
+ *  they hit, see telset_. Then there is no member with all bunches.
+ */
+struct iact_telescopes telescopes;
+
+int iact_write_telescope_bunches(void) {
+    int p;
+    char filename[1024] = "";
+    for (p = 0; p < telescopes.num_placed; p++) {
+        struct iact_bunches *l = &telescopes.placed[p].bunches;
+        if (l->num_bunches == 0u) {
+            continue;
+        }
+        snprintf(
+            filename,
+            sizeof(filename),
+            "%09d.telescope_bunches.%02d.%06d.Nx8_float32",
+            event_number,
+            p/telescopes.num + 1,
+            p%telescopes.num + 1);
+        iact_check(
+            iact_writer_member(
+                &writer,
+                filename,
+                l->bunches,
+                l->num_bunches*IACT_NUM_BYTES_IN_BUNCH),
+            "Can't write bunches of telescope to tar-file.");
+        l->num_bunches = 0u;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+int iact_write_telescopes(void) {
+    int i;
+    int rc;
+    double *positions = (double *)malloc(telescopes.num*4*sizeof(double));
+    iact_check(positions != NULL, "Can not allocate positions of telescopes.");
+    for (i = 0; i < telescopes.num; i++) {
+        positions[4*i + 0] = telescopes.telescopes[i].x;
+        positions[4*i + 1] = telescopes.telescopes[i].y;
+        positions[4*i + 2] = telescopes.telescopes[i].z;
+        positions[4*i + 3] = telescopes.telescopes[i].r;
+    }
+    rc = iact_writer_member(
+        &writer,
+        "telescopes.Nx4_float64",
+        positions,
+        telescopes.num*4*sizeof(double));
+    free(positions);
+    return rc;
+error:
+    return 0;
+}
+
+/*
+ *  The primary's random seeds from extprm_, which seed the cores of the
+ *  reuses, and the thinning with the detector's efficiency and the
+ *  atmosphere's transmission. With CSCAT and a disc or rectangle of
+ *  interest, the bunches are stored for each reuse which they reach, in the
+ *  frame of the region-of-interest. Then there is no member with all
+ *  bunches either.
+ */
+int32_t primary_seeds[IACT_REUSE_NUM_SEEDS];
+struct iact_reuse reuse;
+int reuse_roi = 0;
+
+struct iact_efficiency efficiency;
+
+int iact_write_reuse_bunches(void) {
+    int r;
+    char filename[1024] = "";
+    for (r = 0; r < reuse.num; r++) {
+        struct iact_bunches *l = &reuse.bunches[r];
+        snprintf(
+            filename,
+            sizeof(filename),
+            "%09d.reuse_bunches.%02d.Nx8_float32",
+            event_number,
+            r + 1);
+        iact_check(
+            iact_writer_member(
+                &writer,
+                filename,
+                l->bunches,
+                l->num_bunches*IACT_NUM_BYTES_IN_BUNCH),
+            "Can't write bunches of reuse to tar-file.");
+        l->num_bunches = 0u;
+    }
+    return 1;
+error:
+    return 0;
+}
+
+/*
+ *  With HISTOGRAM_* options, each event has only its histograms, e.g.
+ *  '%09d.histogram_xy.%dx%d_float64', and no bunches.
+ */
+struct iact_histograms histograms;
+
+int iact_write_histograms(void) {
+    int hist;
+    char filename[1024] = "";
+    char shape[64] = "";
+    iact_histograms_flush(&histograms);
+    for (hist = 0; hist < IACT_HIST_NUM; hist++) {
+        if (!histograms.use[hist]) {
+            continue;
+        }
+        if (IACT_HIST_NUM_AXES[hist] == 2) {
+            snprintf(
+                shape,
+                sizeof(shape),
+                "%dx%d",
+                histograms.num_bins[hist][0],
+                histograms.num_bins[hist][1]);
+        } else {
+            snprintf(shape, sizeof(shape), "%d", histograms.num_bins[hist][0]);
+        }
+        snprintf(
+            filename,
+            sizeof(filename),
+            "%09d.histogram_%s.%s_float64",
+            event_number,
+            IACT_HIST_NAMES[hist],
+            shape);
+        iact_check(
+            iact_writer_member(
+                &writer,
+                filename,
+                histograms.counts[hist],
+                iact_histograms_num_counts(&histograms, hist)*sizeof(double)),
+            "Can't write histogram to tar-file.");
     }
+    return 1;
+error:
+    return 0;
+}
 
-#define iact_fwrite(PTR, SIZE_OF_TYPE, NUM, F) { \
-    const size_t num_written = fwrite(PTR, SIZE_OF_TYPE, NUM, F); \
-    iact_check(num_written == NUM, "Can not write to file."); \
+/*
+ *  With SUMMARY, the event's summary follows its bunches just like the
+ *  statistics of the region-of-interest.
+ */
+struct iact_summary summary;
+
+int iact_write_summary(void) {
+    char filename[1024] = "";
+    iact_summary_finish(&summary);
+    snprintf(filename, sizeof(filename), "%09d.summary.float64", event_number);
+    return iact_writer_member(
+        &writer, filename, summary.out, sizeof(summary.out));
 }
 
-#define iact_fread(PTR, SIZE_OF_TYPE, NUM, F) { \
-    const size_t num_read = fread(PTR, SIZE_OF_TYPE, NUM, F); \
-    iact_check(num_read == NUM, "Can not read from file."); \
+/*
+ *  With MERGE_BUNCHES, the bunches are merged before they are written, see
+ *  iact_merge_arena(). The numbers of bunches before and after follow the
+ *  event's bunches.
+ */
+struct iact_merge merge;
+
+int iact_write_merge_statistics(void) {
+    char filename[1024] = "";
+    double stats[2];
+    stats[0] = merge.num_bunches_in;
+    stats[1] = merge.num_bunches_out;
+    snprintf(
+        filename,
+        sizeof(filename),
+        "%09d.merge_statistics.2_float64",
+        event_number);
+    return iact_writer_member(&writer, filename, stats, sizeof(stats));
 }
 
+/*
+ *  With PARTICLES, the particles of an event are buffered in an arena of the
+ *  writer, just like the bunches, and follow the event's bunches in the
+ *  member '%09d.particles.Nx7_float32', or 'Nx8' with thinning.
+ */
+struct iact_arena *particle_arena = NULL;
+int particle_num_words = 7;
 
-typedef float cors_real_t;
-typedef double cors_real_now_t;
-typedef double cors_real_dbl_t;
-typedef double cors_dbl_t;
+int iact_write_particles(void) {
+    char filename[1024] = "";
+    snprintf(
+        filename,
+        sizeof(filename),
+        "%09d.particles.Nx%d_float32",
+        event_number,
+        particle_num_words);
+    iact_check(
+        iact_writer_arena_member(&writer, filename, particle_arena, 0),
+        "Can't write particles.");
+    particle_arena = NULL;
+    return 1;
+error:
+    return 0;
+}
 
-/* =============================================================== */
-/* functions called from CORSIKA in fortran77                      */
-void telfil_(char *name);
-void telrnh_(cors_real_t runh[273]);
-void telrne_(cors_real_t rune[273]);
-void televt_(
-    cors_real_t evth[273],
-    cors_real_dbl_t prmpar[PRMPAR_SIZE]);
-int telout_(
-    cors_real_now_t *bsize,
-    cors_real_now_t *wt,
-    cors_real_now_t *px,
-    cors_real_now_t *py,
-    cors_real_now_t *pu,
-    cors_real_now_t *pv,
-    cors_real_now_t *ctime,
-    cors_real_now_t *zem,
-    cors_real_now_t *lambda);
-void telend_(cors_real_t evte[273]);
-void extprm_(
-    cors_real_dbl_t *type,
-    cors_real_dbl_t *eprim,
-    double *thetap,
-    double *phip,
-    double *thick0,
-    int* seed_seq1, int* calls_seq1, int* billions_seq1,
-    int* seed_seq2, int* calls_seq2, int* billions_seq2,
-    int* seed_seq3, int* calls_seq3, int* billions_seq3,
-    int* seed_seq4, int* calls_seq4, int* billions_seq4);
+/*
+ *  The longitudinal distributions of tellng_ follow the event's bunches in
+ *  the member '%09d.longitudinal.float64'. In the tar, it is written when
+ *  the next event begins, or the run ends, so it does not matter whether
+ *  CORSIKA calls tellng_ before or after telend_. In the arrow-stream, it
+ *  becomes metadata of the event's batch, so tellng_ must come first.
+ */
+struct iact_longitudinal longitudinal;
+int event_is_open = 0;
 
+int iact_write_longitudinal(void) {
+    char filename[1024] = "";
+    snprintf(
+        filename,
+        sizeof(filename),
+        "%09d.longitudinal.float64",
+        event_number);
+    iact_check(
+        iact_writer_member(
+            &writer,
+            filename,
+            longitudinal.values,
+            longitudinal.num*sizeof(double)),
+        "Can't write longitudinal distributions.");
+    longitudinal.num = 0u;
+    return 1;
+error:
+    return 0;
+}
 
-/* =============================================================== */
-/* CORSIKA function called from this module: */
-extern double heigh_(double *thickness);
-extern double refidx_(double *height);
+/*
+ *  The importance-sampling of telsmp_. Its statistics of the event follow
+ *  the event's bunches.
+ */
+struct iact_importance importance;
 
-//-------------------- init ----------------------------------------------------
-int event_number;
+int iact_write_importance_statistics(void) {
+    char filename[1024] = "";
+    snprintf(
+        filename,
+        sizeof(filename),
+        "%09d.importance_statistics.%d_float64",
+        event_number,
+        IACT_IMPORTANCE_NUM_STATS);
+    return iact_writer_member(
+        &writer, filename, importance.stats, sizeof(importance.stats));
+}
 
-const char *PRIMARY_PATH = "primary_bytes.5xf8_12xi4";
-FILE *primary_file = NULL;
+/*
+ *  The statistics of the region-of-interest of the event. In the tar, they
+ *  follow the event's bunches. In the arrow-stream, they precede them, and
+ *  become metadata of the event's batch.
+ */
+struct iact_roi roi;
+
+int iact_write_roi_statistics(void) {
+    char filename[1024] = "";
+    snprintf(
+        filename,
+        sizeof(filename),
+        "%09d.cut_statistics.%dx%d_float64",
+        event_number,
+        IACT_ROI_NUM_CUTS,
+        IACT_ROI_NUM_STATS);
+    return iact_writer_member(&writer, filename, roi.stats, sizeof(roi.stats));
+}
 
-const char* CHERENKOV_BUFFER_PATH = "cherenkov_buffer.float32";
-FILE *cherenkov_buffer = NULL;
+/*
+ *  With BUNCH_CHUNK_MIB, the bunches of an event are split into members of
+ *  bounded size, e.g. '%09d.cherenkov_bunches.%06d.Nx8_float32'. Each full
+ *  arena is handed to the writer as the next chunk. So neither CORSIKA nor
+ *  a reader has to hold all the bunches of a large shower at once.
+ */
+int bunch_chunk_number = 0;
 
-char output_path[1024] = "";
-mtar_t tar;
+int iact_write_bunch_chunk(void) {
+    char bunch_filename[1024] = "";
+    if (options.merge) {
+        iact_check(
+            iact_merge_arena(&merge, cherenkov_arena),
+            "Can not merge chunk of bunches.");
+    }
+    snprintf(
+        bunch_filename,
+        sizeof(bunch_filename),
+        "%09d.cherenkov_bunches.%06d.%s",
+        event_number,
+        bunch_chunk_number,
+        options.compact ? "compact" : "Nx8_float32");
+    iact_check(
+        iact_writer_index_next_member(
+            &writer, event_number, IACT_INDEX_BUNCHES),
+        "Can not add chunk of bunches to event-index.");
+    iact_check(
+        iact_writer_arena_member(
+            &writer,
+            bunch_filename,
+            cherenkov_arena,
+            encode_bunches),
+        "Can't write chunk of bunches to tar-file.");
+    cherenkov_arena = NULL;
+    bunch_chunk_number += 1;
+    return 1;
+error:
+    return 0;
+}
 
 //-------------------- CORSIKA bridge ------------------------------------------
 
@@ -140,15 +4232,125 @@ error:
 */
 void telrnh_(cors_real_t runh[273]) {
     iact_check(
-        mtar_open(&tar, output_path, "w") == MTAR_ESUCCESS,
-        "Can not open tar.");
+        iact_options_read(&options, IACT_OPTIONS_PATH),
+        "Can not read iact-options.");
+    single_pass = options.single_pass && iact_is_seekable_path(output_path);
+    iact_roi_init(&roi, &options);
     iact_check(
-        mtar_write_file_header(
-            &tar, "runh.float32", 273*sizeof(cors_real_t)) == MTAR_ESUCCESS,
-        "Can not write tar-header of 'runh.float32' to tar.");
+        iact_efficiency_init(&efficiency, &options),
+        "Can not init DETECTOR_EFFICIENCY, or ATMOSPHERIC_TRANSMISSION.");
+    encode_bunches =
+        options.compact ||
+        options.bunchcodec ||
+        options.codec != IACT_CODEC_NONE;
+
+    if (options.compact) {
+        single_pass = 0;
+        iact_check(
+            !options.bunchcodec,
+            "Expected COMPACT_BUNCHES without BUNCHCODEC.");
+    }
+
+    if (options.bunch_chunk_size > 0u) {
+        single_pass = 0;
+        options.bunch_chunk_size -=
+            options.bunch_chunk_size % IACT_NUM_BYTES_IN_BUNCH;
+        if (options.bunch_chunk_size == 0u) {
+            options.bunch_chunk_size = IACT_NUM_BYTES_IN_BUNCH;
+        }
+    }
+
+    if (!reuse.use) {
+        iact_reuse_init(&reuse);
+    }
+    reuse_roi = reuse.use &&
+        (roi.use[IACT_ROI_DISC] || roi.use[IACT_ROI_RECTANGLE]);
+
+    iact_check(
+        iact_histograms_init(&histograms, &options),
+        "Can not init histograms.");
+    if (histograms.num_histograms > 0) {
+        single_pass = 0;
+        iact_check(
+            telescopes.num == 0 &&
+            !reuse_roi &&
+            !encode_bunches &&
+            options.bunch_chunk_size == 0u &&
+            options.output_format == IACT_FORMAT_TAR,
+            "Expected HISTOGRAM_* without TELESCOPE, CSCAT with "
+            "ROI_DISC_CM or ROI_RECTANGLE_CM, COMPACT_BUNCHES, BUNCHCODEC, "
+            "COMPRESSION, BUNCH_CHUNK_MIB, and OUTPUT_FORMAT arrow.");
+    }
+
+    if (options.merge) {
+        single_pass = 0;
+        iact_check(
+            telescopes.num == 0 &&
+            !reuse_roi &&
+            histograms.num_histograms == 0,
+            "Expected MERGE_BUNCHES without TELESCOPE, CSCAT with "
+            "ROI_DISC_CM or ROI_RECTANGLE_CM, and HISTOGRAM_*.");
+        iact_check(
+            iact_merge_init(
+                &merge, options.merge_cell_size, options.arena_ram_cap),
+            "Can not init merging of bunches.");
+    }
+
+    if (telescopes.num > 0 || reuse_roi) {
+        single_pass = 0;
+        iact_check(
+            !encode_bunches &&
+            options.bunch_chunk_size == 0u &&
+            options.output_format == IACT_FORMAT_TAR,
+            "Expected TELESCOPE, or CSCAT with ROI_DISC_CM or "
+            "ROI_RECTANGLE_CM, without COMPACT_BUNCHES, BUNCHCODEC, "
+            "COMPRESSION, BUNCH_CHUNK_MIB, and OUTPUT_FORMAT arrow.");
+    }
+    if (telescopes.num > 0) {
+        iact_check(
+            iact_telescopes_place(&telescopes, &reuse),
+            "Can not build grid of telescopes.");
+    }
+
+    if (options.output_format == IACT_FORMAT_ARROW) {
+        single_pass = 0;
+        iact_check(
+            !encode_bunches,
+            "Expected OUTPUT_FORMAT arrow without COMPACT_BUNCHES, "
+            "BUNCHCODEC, COMPRESSION.");
+        iact_check(
+            options.bunch_chunk_size == 0u,
+            "Expected OUTPUT_FORMAT arrow without BUNCH_CHUNK_MIB.");
+        iact_check(
+            !options.particles,
+            "Expected OUTPUT_FORMAT arrow without PARTICLES.");
+        iact_check(
+            arrowipc_open(&arrow, output_path) == ARROWIPC_ESUCCESS,
+            "Can not open arrow-stream.");
+        iact_check(
+            iact_writer_init(&writer, NULL, &arrow, &options),
+            "Can not init writer.");
+    } else {
+        mtar_fd_options_t tar_options;
+        mtar_fd_options_init(&tar_options);
+        tar_options.buffer_size = options.tar_buffer_size;
+        tar_options.direct = options.tar_direct;
+        iact_check(
+            mtar_open_fd(&tar, output_path, &tar_options) == MTAR_ESUCCESS,
+            "Can not open tar.");
+        iact_check(
+            iact_writer_init(&writer, &tar, NULL, &options),
+            "Can not init writer.");
+    }
     iact_check(
-        mtar_write_data(&tar, runh, 273*sizeof(cors_real_t)) == MTAR_ESUCCESS,
-        "Can not write data of 'runh.float32' to tar.");
+        iact_writer_member(
+            &writer, "runh.float32", runh, 273*sizeof(cors_real_t)),
+        "Can not write 'runh.float32' to tar.");
+    if (telescopes.num > 0) {
+        iact_check(
+            iact_write_telescopes(),
+            "Can not write 'telescopes.Nx4_float64' to tar.");
+    }
 
     primary_file = fopen(PRIMARY_PATH, "rb");
     iact_check(primary_file, "Can not open primary_file.");
@@ -229,6 +4431,20 @@ void extprm_(
     (*calls_seq4) = calls_seq4_;
     (*billions_seq4) = billions_seq4_;
 
+    primary_seeds[0] = seed_seq1_;
+    primary_seeds[1] = calls_seq1_;
+    primary_seeds[2] = billions_seq1_;
+    primary_seeds[3] = seed_seq2_;
+    primary_seeds[4] = calls_seq2_;
+    primary_seeds[5] = billions_seq2_;
+    primary_seeds[6] = seed_seq3_;
+    primary_seeds[7] = calls_seq3_;
+    primary_seeds[8] = billions_seq3_;
+    primary_seeds[9] = seed_seq4_;
+    primary_seeds[10] = calls_seq4_;
+    primary_seeds[11] = billions_seq4_;
+
+    primary_energy = eprim_;
     return;
 error:
     exit(1);
@@ -242,25 +4458,97 @@ error:
  *  @return (none)
 */
 void televt_(cors_real_t evth[273], cors_real_dbl_t prmpar[PRMPAR_SIZE]) {
+    if (longitudinal.num > 0u) {
+        iact_check(
+            iact_write_longitudinal(),
+            "Can not write longitudinal distributions of last event.");
+    }
     event_number = (int)(round(evth[1]));
     iact_check(event_number > 0, "Expected event_number > 0.");
+    event_is_open = 1;
+    iact_roi_reset(&roi);
+    iact_summary_reset(&summary);
+    merge.num_bunches_in = 0.0;
+    merge.num_bunches_out = 0.0;
+    if (reuse.use) {
+        iact_reuse_draw(&reuse, primary_seeds);
+        iact_reuse_to_evth(&reuse, evth);
+    }
+    if (efficiency.use) {
+        iact_check(
+            iact_efficiency_begin_event(&efficiency, evth, primary_seeds),
+            "Can not begin thinning of event.");
+    }
+    if (importance.use) {
+        iact_importance_begin_event(&importance, primary_seeds);
+    }
+    if (options.particles) {
+        particle_arena = iact_writer_acquire_arena(&writer);
+        iact_check(particle_arena != NULL, "Can not acquire particle-arena.");
+    }
 
     char evth_filename[1024] = "";
     snprintf(
         evth_filename,
         sizeof(evth_filename),
         "%09d.evth.float32", event_number);
-
     iact_check(
-        mtar_write_file_header(
-            &tar, evth_filename, 273*sizeof(cors_real_t)) == MTAR_ESUCCESS,
-        "Can not write tar-header of EVTH to tar-file.");
+        iact_writer_index_next_member(
+            &writer, event_number, IACT_INDEX_EVTH),
+        "Can not add EVTH to event-index.");
     iact_check(
-        mtar_write_data(&tar, evth, 273*sizeof(cors_real_t)) == MTAR_ESUCCESS,
-        "Can not write data of EVTH to tar-file.");
+        iact_writer_member(
+            &writer, evth_filename, evth, 273*sizeof(cors_real_t)),
+        "Can not write EVTH to tar-file.");
+
+    if (telescopes.num > 0 && reuse.use) {
+        iact_check(
+            iact_telescopes_place(&telescopes, &reuse),
+            "Can not place telescopes at the cores of the reuses.");
+    }
+    if (histograms.num_histograms > 0) {
+        iact_histograms_reset(&histograms);
+        return;
+    }
+    if (telescopes.num > 0 || reuse_roi) {
+        return;
+    }
 
-    cherenkov_buffer = fopen(CHERENKOV_BUFFER_PATH, "w");
-    iact_check(cherenkov_buffer, "Can not open cherenkov_buffer.");
+    cherenkov_arena = iact_writer_acquire_arena(&writer);
+    iact_check(cherenkov_arena != NULL, "Can not acquire bunch-arena.");
+
+    if (single_pass) {
+        char bunch_filename[1024] = "";
+        iact_check(
+            iact_writer_index_next_member(
+                &writer, event_number, IACT_INDEX_BUNCHES),
+            "Can not add bunches to event-index.");
+        snprintf(
+            bunch_filename,
+            sizeof(bunch_filename),
+            "%09d.cherenkov_bunches.Nx8_float32", event_number);
+        iact_check(
+            iact_arena_reserve(cherenkov_arena, IACT_SINGLE_PASS_BLOCK_SIZE),
+            "Can not reserve bunch-arena for single pass.");
+        iact_check(
+            iact_writer_begin_member(
+                &writer,
+                bunch_filename,
+                encode_bunches,
+                (uint64_t)(primary_energy*IACT_ARENA_NUM_BYTES_PER_GEV)),
+            "Can not write placeholder tar-header of bunches to tar-file.");
+    } else {
+        uint64_t expected_size =
+            (uint64_t)(primary_energy*IACT_ARENA_NUM_BYTES_PER_GEV);
+        if (options.bunch_chunk_size > 0u &&
+            expected_size > options.bunch_chunk_size) {
+            expected_size = options.bunch_chunk_size;
+        }
+        bunch_chunk_number = 0;
+        iact_check(
+            iact_arena_reserve(cherenkov_arena, expected_size),
+            "Can not reserve bunch-arena for primary's energy.");
+    }
 
     return;
 error:
@@ -269,7 +4557,7 @@ error:
 
 
 /**
- *  Store photon-bunch.
+ *  Store photon-bunch when it is in the region-of-interest.
  *
  *  @param  bsize   Number of photons (can be fraction of one)
  *  @param  wt     Weight (if thinning option is active)
@@ -306,7 +4594,83 @@ int telout_(
     bunch[5] = (float)(*zem);
     bunch[6] = (float)(*bsize);
     bunch[7] = (float)(*lambda);
-    iact_fwrite(bunch, sizeof(float), 8, cherenkov_buffer);
+    if (efficiency.use && !iact_efficiency_thin(&efficiency, bunch)) {
+        return 0;
+    }
+    if (importance.use && !iact_importance_sample(&importance, bunch)) {
+        return 0;
+    }
+    if (reuse_roi) {
+        int r, num_hits = 0, accepted = 0;
+        for (r = 0; r < reuse.num; r++) {
+            float moved[8];
+            memcpy(moved, bunch, sizeof(moved));
+            moved[0] = (float)(bunch[0] + reuse.x[r]);
+            moved[1] = (float)(bunch[1] + reuse.y[r]);
+            if (!iact_roi_accept(&roi, moved)) {
+                continue;
+            }
+            accepted = 1;
+            if (telescopes.num > 0) {
+                const int hits =
+                    iact_telescopes_add_bunch(&telescopes, bunch, r);
+                iact_check(hits >= 0, "Can not add bunch to telescopes.");
+                num_hits += hits;
+            } else {
+                float *out = iact_bunches_next(&reuse.bunches[r]);
+                iact_check(out != NULL, "Can not add bunch to reuse.");
+                memcpy(out, moved, IACT_NUM_BYTES_IN_BUNCH);
+                num_hits += 1;
+            }
+        }
+        if (options.summary && accepted) {
+            iact_summary_add(&summary, bunch);
+        }
+        return num_hits > 0;
+    }
+    if (roi.num_cuts > 0 && !iact_roi_accept(&roi, bunch)) {
+        return 0;
+    }
+    if (options.summary) {
+        iact_summary_add(&summary, bunch);
+    }
+    if (histograms.num_histograms > 0) {
+        iact_histograms_add(&histograms, bunch);
+        return 1;
+    }
+    if (telescopes.num > 0) {
+        const int num_hits = iact_telescopes_add_bunch(&telescopes, bunch, -1);
+        iact_check(num_hits >= 0, "Can not add bunch to telescopes.");
+        return num_hits > 0;
+    }
+    if (single_pass &&
+        cherenkov_arena->size + IACT_NUM_BYTES_IN_BUNCH >
+        cherenkov_arena->capacity) {
+        iact_check(
+            iact_writer_append(
+                &writer,
+                cherenkov_arena,
+                encode_bunches),
+            "Can not stream bunches into tar-file.");
+        cherenkov_arena = iact_writer_acquire_arena(&writer);
+        iact_check(cherenkov_arena != NULL, "Can not acquire bunch-arena.");
+        iact_check(
+            iact_arena_reserve(cherenkov_arena, IACT_SINGLE_PASS_BLOCK_SIZE),
+            "Can not reserve bunch-arena for single pass.");
+    }
+    if (options.bunch_chunk_size > 0u &&
+        iact_arena_num_bytes(cherenkov_arena) + IACT_NUM_BYTES_IN_BUNCH >
+        options.bunch_chunk_size) {
+        iact_check(iact_write_bunch_chunk(), "Can not write chunk of bunches.");
+        cherenkov_arena = iact_writer_acquire_arena(&writer);
+        iact_check(cherenkov_arena != NULL, "Can not acquire bunch-arena.");
+        iact_check(
+            iact_arena_reserve(cherenkov_arena, options.bunch_chunk_size),
+            "Can not reserve bunch-arena for chunk.");
+    }
+    iact_check(
+        iact_arena_append(cherenkov_arena, bunch, IACT_NUM_BYTES_IN_BUNCH),
+        "Can not append bunch to bunch-arena.");
     return 1;
 error:
     exit(1);
@@ -318,31 +4682,108 @@ error:
  *  End of event. Write photon-bunches into tar-file.
 */
 void telend_(cors_real_t evte[273]) {
-    iact_check(cherenkov_buffer != NULL, "Expected cherenkov_buffer != NULL");
-    int64_t sizeof_cherenkov_buffer = ftell(cherenkov_buffer);
-    iact_check(sizeof_cherenkov_buffer >= 0, "Can't ftell cherenkov_buffer");
-
-    iact_check(fclose(cherenkov_buffer) == 0, "Can't close cherenkov_buffer.");
-
-    cherenkov_buffer = fopen(CHERENKOV_BUFFER_PATH, "r");
-    iact_check(cherenkov_buffer, "Can not re-open cherenkov_buffer for read.");
-
     char bunch_filename[1024] = "";
-    snprintf(
-        bunch_filename,
-        sizeof(bunch_filename),
-        "%09d.cherenkov_bunches.Nx8_float32", event_number);
+    if (options.merge && options.bunch_chunk_size == 0u) {
+        iact_check(
+            iact_merge_arena(&merge, cherenkov_arena),
+            "Can't merge bunches.");
+    }
+    if (roi.num_cuts > 0 && options.output_format == IACT_FORMAT_ARROW) {
+        iact_check(
+            iact_write_roi_statistics(),
+            "Can't write statistics of region-of-interest.");
+    }
+    if (options.summary && options.output_format == IACT_FORMAT_ARROW) {
+        iact_check(iact_write_summary(), "Can't write summary of event.");
+    }
+    if (options.merge && options.output_format == IACT_FORMAT_ARROW) {
+        iact_check(
+            iact_write_merge_statistics(),
+            "Can't write statistics of merging.");
+    }
+    if (importance.use && options.output_format == IACT_FORMAT_ARROW) {
+        iact_check(
+            iact_write_importance_statistics(),
+            "Can't write statistics of importance-sampling.");
+    }
+    if (longitudinal.num > 0u && options.output_format == IACT_FORMAT_ARROW) {
+        iact_check(
+            iact_write_longitudinal(),
+            "Can't write longitudinal distributions.");
+    }
 
-    iact_check(
-        mtar_write_file_header(
-            &tar, bunch_filename, sizeof_cherenkov_buffer) == MTAR_ESUCCESS,
-        "Can't write tar-header of bunches to tar-file.");
-    iact_check(
-        mtar_write_data_from_stream(
-            &tar, cherenkov_buffer, sizeof_cherenkov_buffer) == MTAR_ESUCCESS,
-        "Can't write data of bunches to tar-file.");
+    if (telescopes.num > 0) {
+        iact_check(
+            iact_write_telescope_bunches(),
+            "Can't write bunches of telescopes to tar-file.");
+    } else if (histograms.num_histograms > 0) {
+        iact_check(
+            iact_write_histograms(),
+            "Can't write histograms to tar-file.");
+    } else if (reuse_roi) {
+        iact_check(
+            iact_write_reuse_bunches(),
+            "Can't write bunches of reuses to tar-file.");
+    } else if (single_pass) {
+        iact_check(
+            iact_writer_append(
+                &writer,
+                cherenkov_arena,
+                encode_bunches),
+            "Can't stream bunches into tar-file.");
+        cherenkov_arena = NULL;
+        iact_check(
+            iact_writer_end_member(
+                &writer,
+                encode_bunches),
+            "Can't patch tar-header of bunches in tar-file.");
+    } else if (options.bunch_chunk_size > 0u) {
+        iact_check(
+            iact_write_bunch_chunk(),
+            "Can't write last chunk of bunches to tar-file.");
+    } else {
+        snprintf(
+            bunch_filename,
+            sizeof(bunch_filename),
+            "%09d.cherenkov_bunches.%s",
+            event_number,
+            options.compact ? "compact" : "Nx8_float32");
+        iact_check(
+            iact_writer_index_next_member(
+                &writer, event_number, IACT_INDEX_BUNCHES),
+            "Can not add bunches to event-index.");
+        iact_check(
+            iact_writer_arena_member(
+                &writer,
+                bunch_filename,
+                cherenkov_arena,
+                encode_bunches),
+            "Can't write bunches to tar-file.");
+        cherenkov_arena = NULL;
+    }
 
-    iact_check(fclose(cherenkov_buffer) == 0, "Can't close cherenkov_buffer.");
+    if (roi.num_cuts > 0 && options.output_format == IACT_FORMAT_TAR) {
+        iact_check(
+            iact_write_roi_statistics(),
+            "Can't write statistics of region-of-interest.");
+    }
+    if (options.summary && options.output_format == IACT_FORMAT_TAR) {
+        iact_check(iact_write_summary(), "Can't write summary of event.");
+    }
+    if (options.merge && options.output_format == IACT_FORMAT_TAR) {
+        iact_check(
+            iact_write_merge_statistics(),
+            "Can't write statistics of merging.");
+    }
+    if (importance.use && options.output_format == IACT_FORMAT_TAR) {
+        iact_check(
+            iact_write_importance_statistics(),
+            "Can't write statistics of importance-sampling.");
+    }
+    if (options.particles) {
+        iact_check(iact_write_particles(), "Can't write particles of event.");
+    }
+    event_is_open = 0;
     return;
 error:
     exit(1);
@@ -355,12 +4796,35 @@ error:
  *  @param  rune  CORSIKA run end block
 */
 void telrne_(cors_real_t rune[273]) {
+    if (longitudinal.num > 0u) {
+        iact_check(
+            iact_write_longitudinal(),
+            "Can't write longitudinal distributions of last event.");
+    }
     iact_check(
-        mtar_finalize(&tar) == MTAR_ESUCCESS,
-        "Can't finalize tar-file.");
-    iact_check(
-        mtar_close(&tar) == MTAR_ESUCCESS,
-        "Can't close tar-file.");
+        iact_writer_finish(&writer),
+        "Can't finish writer.");
+    iact_telescopes_free(&telescopes);
+    iact_reuse_free(&reuse);
+    iact_histograms_free(&histograms);
+    iact_efficiency_free(&efficiency);
+    iact_importance_free(&importance);
+    iact_longitudinal_free(&longitudinal);
+    if (options.merge) {
+        iact_merge_free(&merge);
+    }
+    if (options.output_format == IACT_FORMAT_ARROW) {
+        iact_check(
+            arrowipc_close(&arrow) == ARROWIPC_ESUCCESS,
+            "Can't close arrow-stream.");
+    } else {
+        iact_check(
+            mtar_finalize(&tar) == MTAR_ESUCCESS,
+            "Can't finalize tar-file.");
+        iact_check(
+            mtar_close(&tar) == MTAR_ESUCCESS,
+            "Can't close tar-file.");
+    }
     iact_check(
         primary_file != NULL,
         "Expected primary_file != NULL");
@@ -373,35 +4837,6 @@ error:
 }
 
 
-//-------------------- UNUSED --------------------------------------------------
-void telset_(
-    cors_real_now_t *x,
-    cors_real_now_t *y,
-    cors_real_now_t *z,
-    cors_real_now_t *r);
-void telsmp_(char *name);
-void telshw_(void);
-void telinf_(
-    int *itel,
-    double *x,
-    double *y,
-    double *z,
-    double *r,
-    int *exists);
-void tellni_(char *line, int *llength);
-void telasu_(
-    int *n,
-    cors_real_dbl_t *dx,
-    cors_real_dbl_t *dy);
-void telprt_(cors_real_t* datab, int *maxbuf);
-void tellng_(
-    int *type,
-    double *data,
-    int *ndim,
-    int *np,
-    int *nthick,
-    double *thickstep);
-
 /**
  *  Add another telescope to the system (array) of telescopes.
  *
@@ -420,15 +4855,12 @@ void telset_(
     cors_real_now_t *z,
     cors_real_now_t *r
 ) {
+    iact_check(
+        iact_telescopes_add(&telescopes, *x, *y, *z, *r),
+        "Can not add telescope.");
     return;
-}
-
-
-/**
- *  Set the file name with parameters for importance sampling.
- */
-void telsmp_(char *name) {
-    return;
+error:
+    exit(1);
 }
 
 
@@ -437,6 +4869,18 @@ void telsmp_(char *name) {
  *  This function is called by CORSIKA after the input file is read.
 */
 void telshw_() {
+    int i;
+    fprintf(stdout, " iact.c: Number of telescopes: %d\n", telescopes.num);
+    for (i = 0; i < telescopes.num && i < 10; i++) {
+        const struct iact_telescope *tel = &telescopes.telescopes[i];
+        fprintf(
+            stdout,
+            " iact.c: Telescope %d at x=%.1f, y=%.1f, z=%.1f, r=%.1f cm\n",
+            i + 1, tel->x, tel->y, tel->z, tel->r);
+    }
+    if (telescopes.num > 10) {
+        fprintf(stdout, " iact.c: ...\n");
+    }
     return;
 }
 
@@ -444,7 +4888,7 @@ void telshw_() {
 /**
  * Return information about configured telescopes back to CORSIKA
  *
- * @param  itel     number of telescope in question
+ * @param  itel     number of telescope in question, starting at 1
  * @param  x, y, z  telescope position [cm]
  * @param  r       radius of fiducial volume [cm]
  * @param  exists   telescope exists
@@ -457,32 +4901,51 @@ void telinf_(
     double *r,
     int *exists
 ) {
-    fprintf(stderr, "ABORT: The telinf_ was called.\n");
-    exit(1);
+    const struct iact_telescope *tel;
+    if (*itel < 1 || *itel > telescopes.num) {
+        (*exists) = 0;
+        return;
+    }
+    tel = &telescopes.telescopes[*itel - 1];
+    (*x) = tel->x;
+    (*y) = tel->y;
+    (*z) = tel->z;
+    (*r) = tel->r;
+    (*exists) = 1;
 }
 
 
 /**
- *  Keep a record of CORSIKA input lines.
+ *  Setup how many times each shower is used, see CORSIKA's CSCAT card.
  *
- *  @param  line     input line (not terminated)
- *  @param  llength  maximum length of input lines (132 usually)
+ *  @param n   The number of telescope systems
+ *  @param dx  Core range radius (if dy==0) or core x range
+ *  @param dy  Core y range (non-zero for ractangular, 0 for circular)
+ *  @return (none)
 */
-void tellni_(char *line, int *llength) {
+void telasu_(int *n, cors_real_dbl_t *dx, cors_real_dbl_t *dy) {
+    iact_check(
+        iact_reuse_set(&reuse, *n, *dx, *dy),
+        "Can not set reuse of showers.");
     return;
+error:
+    exit(1);
 }
 
 
 /**
- *  Setup how many times each shower is used.
+ *  Set the file name with parameters for importance sampling. Its lines are
+ *  'r_cm probability', see iact_importance_sample().
  *
- *  @param n   The number of telescope systems
- *  @param dx  Core range radius (if dy==0) or core x range
- *  @param dy  Core y range (non-zero for ractangular, 0 for circular)
- *  @return (none)
-*/
-void telasu_(int *n, cors_real_dbl_t *dx, cors_real_dbl_t *dy) {
+ *  @param  name    Path of the file.
+ */
+void telsmp_(char *name) {
+    iact_check(
+        iact_importance_read(&importance, name),
+        "Can not read file of importance-sampling.");
     return;
+error:
+    exit(1);
 }
 
 
@@ -494,14 +4957,40 @@ void telasu_(int *n, cors_real_dbl_t *dx, cors_real_dbl_t *dy) {
  *                option and 39*8 with thinning.
  */
 void telprt_(cors_real_t *datab, int *maxbuf) {
+    const int num_words = (*maxbuf)/IACT_PARTICLES_NUM_PER_BLOCK;
+    int i;
+    if (!options.particles) {
+        return;
+    }
+    iact_check(
+        num_words == 7 || num_words == 8,
+        "Expected 7, or 8 words per particle.");
+    if (iact_arena_num_bytes(particle_arena) == 0u) {
+        particle_num_words = num_words;
+    }
+    iact_check(
+        num_words == particle_num_words,
+        "Expected the same number of words per particle in an event.");
+    for (i = 0; i < IACT_PARTICLES_NUM_PER_BLOCK; i++) {
+        const float *particle = &datab[i*num_words];
+        if (!iact_particle_accept(&options, particle)) {
+            continue;
+        }
+        iact_check(
+            iact_arena_append(
+                particle_arena, particle, num_words*sizeof(float)),
+            "Can not append particle to particle-arena.");
+    }
     return;
+error:
+    exit(1);
 }
 
 
 /**
  *  Write CORSIKA 'longitudinal' (vertical) distributions.
  *
- *  @param  type    see above
+ *  @param  type    the kind of distributions, as passed by CORSIKA
  *  @param  data    set of (usually 9) distributions
  *  @param  ndim    maximum number of entries per distribution
  *  @param  np      number of distributions (usually 9)
@@ -518,5 +5007,31 @@ void tellng_(
     int *nthick,
     double *thickstep
 ) {
+    if (*nthick <= 1) {
+        return;
+    }
+    iact_check(
+        event_is_open || options.output_format == IACT_FORMAT_TAR,
+        "Expected tellng_ before telend_ with OUTPUT_FORMAT arrow.");
+    iact_check(
+        iact_longitudinal_append(
+            &longitudinal, *type, data, *ndim, *np, *nthick, *thickstep),
+        "Can not buffer longitudinal distributions.");
+    return;
+error:
+    exit(1);
+}
+
+
+//-------------------- UNUSED --------------------------------------------------
+void tellni_(char *line, int *llength);
+
+/**
+ *  Keep a record of CORSIKA input lines.
+ *
+ *  @param  line     input line (not terminated)
+ *  @param  llength  maximum length of input lines (132 usually)
+*/
+void tellni_(char *line, int *llength) {
     return;
 }
@@ -37,6 +37,9 @@
 
 #define MTAR_VERSION "1000.0.0"
 
+/* Largest size in the octal size-field, 8 GiB - 1. */
+#define MTAR_MAX_OCTAL_SIZE ((uint64_t)077777777777)
+
 #define mtar_clean_errno() (errno == 0 ? "None" : strerror(errno))
 
 #define mtar_log_err(M) fprintf(stderr, "[ERROR] (%s:%d: errno: %s) " M "\n", \
@@ -79,15 +82,35 @@ typedef struct {
 
 typedef struct mtar_t mtar_t;
 
+/* An index is a member of fixed-size records. Its payload is padded to a
+ * multiple of 512 bytes and ends with a footer, so that it can be found from
+ * the tail of the tar without walking all headers. */
+#define MTAR_INDEX_MAGIC "MTARIDX1"
+#define MTAR_INDEX_FOOTER_SIZE 32
+#define MTAR_INDEX_MAX_NUM_TRAILING_NULL_RECORDS 20
+
+typedef struct {
+  uint64_t header;
+  uint64_t record_size;
+  uint64_t num_records;
+} mtar_index_t;
+
 struct mtar_t {
   int64_t (*read)(mtar_t *tar, void *data, uint64_t size);
   int64_t (*write)(mtar_t *tar, const void *data, uint64_t size);
   int64_t (*seek)(mtar_t *tar, uint64_t pos);
   int64_t (*close)(mtar_t *tar);
+  int64_t (*size)(mtar_t *tar, uint64_t *size);
+  /* Optional, called with the bytes of a member of known size before its
+   * header is written. */
+  int64_t (*reserve)(mtar_t *tar, uint64_t size);
   void *stream;
   uint64_t pos;
   uint64_t remaining_data;
   uint64_t last_header;
+  uint64_t last_size;
+  uint64_t open_file_header;
+  mtar_header_t open_file;
 };
 
 
@@ -109,6 +132,20 @@ int64_t mtar_write_dir_header(mtar_t *tar, const char *name);
 int64_t mtar_write_data(mtar_t *tar, const void *data, uint64_t size);
 int64_t mtar_finalize(mtar_t *tar);
 
+int64_t mtar_begin_file(mtar_t *tar, const char *name);
+int64_t mtar_append_data(mtar_t *tar, const void *data, uint64_t size);
+int64_t mtar_end_file(mtar_t *tar);
+
+int64_t mtar_write_index(
+  mtar_t *tar,
+  const char *name,
+  const void *records,
+  uint64_t record_size,
+  uint64_t num_records);
+int64_t mtar_find_index(mtar_t *tar, mtar_index_t *index);
+int64_t mtar_read_index(mtar_t *tar, const mtar_index_t *index, void *records);
+int64_t mtar_seek_member(mtar_t *tar, uint64_t header, mtar_header_t *h);
+
 typedef struct {
   char name[100];
   char mode[8];
@@ -156,19 +193,63 @@ static int64_t _mtar_twrite(mtar_t *tar, const void *data, uint64_t size) {
 }
 
 
+/* Padding and the two NULL records at the end fit into one write. */
 static int64_t _mtar_write_null_bytes(mtar_t *tar, int64_t n) {
-  int64_t i, err;
-  char nul = '\0';
-  for (i = 0; i < n; i++) {
-    err = _mtar_twrite(tar, &nul, 1);
+  static const char nul[2*512] = {0};
+  int64_t err;
+  while (n > 0) {
+    const int64_t chunk = n < (int64_t)sizeof(nul) ? n : (int64_t)sizeof(nul);
+    err = _mtar_twrite(tar, nul, chunk);
     if (err) {
       return err;
     }
+    n -= chunk;
   }
   return MTAR_ESUCCESS;
 }
 
 
+/* The size-field holds up to MTAR_MAX_OCTAL_SIZE in octal. Larger sizes are
+ * written in GNU's base-256 encoding: the first byte is 0x80, the remaining
+ * 11 bytes hold the size in big-endian. GNU-tar, bsdtar, and Python's tarfile
+ * read both. */
+static void _mtar_size_to_raw(char *field, uint64_t size) {
+  int64_t i;
+  if (size <= MTAR_MAX_OCTAL_SIZE) {
+    snprintf(field, 12, "%lo", size);
+    return;
+  }
+  field[0] = (char)0x80;
+  for (i = 11; i > 0; i--) {
+    field[i] = (char)(size & 0xFFu);
+    size >>= 8;
+  }
+}
+
+
+static int64_t _mtar_raw_to_size(const char *field, uint64_t *size) {
+  const unsigned char *f = (const unsigned char *)field;
+  int64_t i;
+  if (f[0] == 0x80) {
+    *size = 0;
+    for (i = 1; i < 12; i++) {
+      if (*size >> 56) {
+        return MTAR_EFAILURE;
+      }
+      *size = (*size << 8) | f[i];
+    }
+    return MTAR_ESUCCESS;
+  }
+  if (f[0] & 0x80) {
+    /* Negative base-256 numbers are no sizes. */
+    return MTAR_EFAILURE;
+  }
+  *size = 0;
+  sscanf(field, "%lo", size);
+  return MTAR_ESUCCESS;
+}
+
+
 static int64_t _mtar_raw_to_header(
   mtar_header_t *h,
   const _mtar_raw_header_t *rh) {
@@ -189,7 +270,9 @@ static int64_t _mtar_raw_to_header(
   /* Load raw header into header */
   sscanf(rh->mode, "%lo", &h->mode);
   sscanf(rh->owner, "%lo", &h->owner);
-  sscanf(rh->size, "%lo", &h->size);
+  if (_mtar_raw_to_size(rh->size, &h->size)) {
+    return MTAR_EFAILURE;
+  }
   sscanf(rh->mtime, "%lo", &h->mtime);
   h->type = rh->type;
   snprintf(h->name, sizeof(h->name), "%s", rh->name);
@@ -208,7 +291,7 @@ static int64_t _mtar_header_to_raw(
   memset(rh, 0, sizeof(*rh));
   snprintf(rh->mode, sizeof(rh->mode), "%lo", h->mode);
   snprintf(rh->owner, sizeof(rh->owner), "%lo", h->owner);
-  snprintf(rh->size, sizeof(rh->size), "%lo", h->size);
+  _mtar_size_to_raw(rh->size, h->size);
   snprintf(rh->mtime, sizeof(rh->mtime), "%lo", h->mtime);
   rh->type = h->type ? h->type : MTAR_TREG;
   snprintf(rh->name, sizeof(rh->name), "%s", h->name);
@@ -259,6 +342,19 @@ static int64_t _mtar_file_close(mtar_t *tar) {
   return MTAR_ESUCCESS;
 }
 
+static int64_t _mtar_file_size(mtar_t *tar, uint64_t *size) {
+  int64_t res;
+  if (fseek((FILE*)tar->stream, 0L, SEEK_END) != 0) {
+    return MTAR_ESEEKFAIL;
+  }
+  res = ftell((FILE*)tar->stream);
+  if (res < 0) {
+    return MTAR_ESEEKFAIL;
+  }
+  *size = (uint64_t)res;
+  return _mtar_file_seek(tar, tar->pos);
+}
+
 
 int64_t mtar_open(mtar_t *tar, const char *filename, const char *mode) {
   int64_t err;
@@ -270,6 +366,7 @@ int64_t mtar_open(mtar_t *tar, const char *filename, const char *mode) {
   tar->read = _mtar_file_read;
   tar->seek = _mtar_file_seek;
   tar->close = _mtar_file_close;
+  tar->size = _mtar_file_size;
 
   /* Assure mode is always binary */
   if ( strchr(mode, 'r') ) mode = "rb";
@@ -411,6 +508,8 @@ int64_t mtar_write_header(mtar_t *tar, const mtar_header_t *h) {
   /* Build raw header and write */
   _mtar_header_to_raw(&rh, h);
   tar->remaining_data = h->size;
+  tar->last_header = tar->pos;
+  tar->last_size = h->size;
   return _mtar_twrite(tar, &rh, sizeof(rh));
 }
 
@@ -423,6 +522,14 @@ int64_t mtar_write_file_header(mtar_t *tar, const char *name, uint64_t size) {
   h.size = size;
   h.type = MTAR_TREG;
   h.mode = 0664;
+  /* Announce the whole member, header and padding included */
+  if (tar->reserve != NULL) {
+    const int64_t err = tar->reserve(
+      tar, sizeof(_mtar_raw_header_t) + _mtar_round_up(size, 512));
+    if (err) {
+      return err;
+    }
+  }
   /* Write header */
   return mtar_write_header(tar, &h);
 }
@@ -487,4 +594,172 @@ int64_t mtar_finalize(mtar_t *tar) {
   return _mtar_write_null_bytes(tar, sizeof(_mtar_raw_header_t) * 2);
 }
 
+
+/* Files of unknown size. The header is written with size zero first, and is
+ * overwritten in mtar_end_file() once the size is known. This needs a
+ * seekable stream. */
+int64_t mtar_begin_file(mtar_t *tar, const char *name) {
+  /* Build header */
+  memset(&tar->open_file, 0, sizeof(tar->open_file));
+  snprintf(tar->open_file.name, sizeof(tar->open_file.name), "%s", name);
+  tar->open_file.size = 0;
+  tar->open_file.type = MTAR_TREG;
+  tar->open_file.mode = 0664;
+  /* Write placeholder header */
+  tar->open_file_header = tar->pos;
+  return mtar_write_header(tar, &tar->open_file);
+}
+
+
+int64_t mtar_append_data(mtar_t *tar, const void *data, uint64_t size) {
+  return _mtar_twrite(tar, data, size);
+}
+
+
+int64_t mtar_end_file(mtar_t *tar) {
+  int64_t err;
+  const uint64_t end = tar->pos;
+  tar->open_file.size = end - tar->open_file_header
+    - sizeof(_mtar_raw_header_t);
+  /* Overwrite placeholder header */
+  err = mtar_seek(tar, tar->open_file_header);
+  if (err) {
+    return err;
+  }
+  err = mtar_write_header(tar, &tar->open_file);
+  if (err) {
+    return err;
+  }
+  err = mtar_seek(tar, end);
+  if (err) {
+    return err;
+  }
+  tar->remaining_data = 0;
+  /* Write padding */
+  return _mtar_write_null_bytes(tar, _mtar_round_up(tar->pos, 512) - tar->pos);
+}
+
+
+/* The index's payload is [records][null bytes][footer], and the footer is
+ * [magic, uint64 record_size, uint64 num_records, uint64 header]. The header
+ * is the offset of the index's own tar-header. */
+int64_t mtar_write_index(
+  mtar_t *tar,
+  const char *name,
+  const void *records,
+  uint64_t record_size,
+  uint64_t num_records) {
+  int64_t err;
+  char footer[MTAR_INDEX_FOOTER_SIZE];
+  const uint64_t header = tar->pos;
+  const uint64_t records_size = record_size*num_records;
+  const uint64_t size = _mtar_round_up(
+    records_size + MTAR_INDEX_FOOTER_SIZE, 512);
+  memcpy(footer, MTAR_INDEX_MAGIC, 8);
+  memcpy(footer + 8, &record_size, 8);
+  memcpy(footer + 16, &num_records, 8);
+  memcpy(footer + 24, &header, 8);
+  err = mtar_write_file_header(tar, name, size);
+  if (err) {
+    return err;
+  }
+  if (records_size > 0) {
+    err = mtar_write_data(tar, records, records_size);
+    if (err) {
+      return err;
+    }
+  }
+  err = _mtar_write_null_bytes(
+    tar,
+    size - records_size - MTAR_INDEX_FOOTER_SIZE);
+  if (err) {
+    return err;
+  }
+  return mtar_write_data(tar, footer, MTAR_INDEX_FOOTER_SIZE);
+}
+
+
+/* Find the index from the tail. The tar may end with up to
+ * MTAR_INDEX_MAX_NUM_TRAILING_NULL_RECORDS null records. The record before
+ * them ends with the index's footer. */
+int64_t mtar_find_index(mtar_t *tar, mtar_index_t *index) {
+  int64_t err;
+  uint64_t size, pos, i;
+  char record[512];
+  mtar_header_t h;
+  err = tar->size(tar, &size);
+  if (err) {
+    return err;
+  }
+  pos = size - size % 512;
+  for (i = 0; i <= MTAR_INDEX_MAX_NUM_TRAILING_NULL_RECORDS; i++) {
+    uint64_t k;
+    int is_null = 1;
+    if (pos < 2*512) {
+      return MTAR_ENOTFOUND;
+    }
+    pos -= 512;
+    err = mtar_seek(tar, pos);
+    if (err) {
+      return err;
+    }
+    err = _mtar_tread(tar, record, 512);
+    if (err) {
+      return err;
+    }
+    for (k = 0; k < 512; k++) {
+      if (record[k] != '\0') {
+        is_null = 0;
+        break;
+      }
+    }
+    if (!is_null) {
+      break;
+    }
+  }
+  if (memcmp(record + 512 - MTAR_INDEX_FOOTER_SIZE, MTAR_INDEX_MAGIC, 8)) {
+    return MTAR_ENOTFOUND;
+  }
+  memcpy(&index->record_size, record + 512 - MTAR_INDEX_FOOTER_SIZE + 8, 8);
+  memcpy(&index->num_records, record + 512 - MTAR_INDEX_FOOTER_SIZE + 16, 8);
+  memcpy(&index->header, record + 512 - MTAR_INDEX_FOOTER_SIZE + 24, 8);
+  /* The footer must be at the end of the index's payload. */
+  err = mtar_seek_member(tar, index->header, &h);
+  if (err) {
+    return err;
+  }
+  if (index->header + sizeof(_mtar_raw_header_t) + h.size != pos + 512 ||
+      index->record_size*index->num_records + MTAR_INDEX_FOOTER_SIZE >
+      h.size) {
+    return MTAR_ENOTFOUND;
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+/* Read the index's records, records must hold
+ * index->record_size*index->num_records bytes. */
+int64_t mtar_read_index(mtar_t *tar, const mtar_index_t *index, void *records) {
+  int64_t err;
+  err = mtar_seek(tar, index->header + sizeof(_mtar_raw_header_t));
+  if (err) {
+    return err;
+  }
+  tar->remaining_data = 0;
+  return _mtar_tread(tar, records, index->record_size*index->num_records);
+}
+
+
+/* Jump to the member with its tar-header at offset header, e.g. taken from
+ * an index, and read its header. Use mtar_read_data() to read its data. */
+int64_t mtar_seek_member(mtar_t *tar, uint64_t header, mtar_header_t *h) {
+  int64_t err;
+  tar->remaining_data = 0;
+  err = mtar_seek(tar, header);
+  if (err) {
+    return err;
+  }
+  return mtar_read_header(tar, h);
+}
+
 #endif
@@ -0,0 +1,396 @@
+/**
+ * Copyright (c) 2019 Sebastian A. Mueller
+ *                    Max-Planck-Institute for nuclear-physics, Heidelberg
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See microtar.h.
+ */
+
+/**
+ * microtar_fd
+ * ===========
+ *
+ * A write backend for microtar on a plain file-descriptor instead of stdio.
+ * Writes are collected in one large buffer which is aligned to
+ * MTAR_FD_ALIGNMENT, and are written in whole buffers. Optionally, the file
+ * is opened with O_DIRECT to bypass the page-cache. The backend can not
+ * read, open the finished tar with mtar_open() to read it.
+ *
+ * On Linux, a regular file is preallocated with fallocate(2) ahead of the
+ * members of known size, in steps of at least the buffer, so its blocks are
+ * not allocated with each write. mtar_close() truncates the file to the
+ * bytes written. Where fallocate(2) is not supported, it is not tried again.
+ *
+ * Writes which do not fit into the buffer, e.g. the payload of a large
+ * member, are not copied. The buffered bytes, e.g. the member's header, and
+ * the payload are written together with one writev(2). Without O_DIRECT, a
+ * large member costs one system-call, and a small one is only copied. A
+ * small member of known size, see mtar_write_file_header(), is not split
+ * around the end of the buffer. When it does not fit behind the buffered
+ * bytes, these are written first and the member is copied whole.
+ *
+ * Only the seeks of mtar_end_file() are supported, i.e. rewriting a header
+ * behind the current position. A header which was already flushed is
+ * rewritten with pwrite(2) on a second descriptor without O_DIRECT. When the
+ * target is not seekable, e.g. a FIFO, the buffers are written in sequence
+ * and no seek is possible.
+ *
+ * Needs POSIX, e.g. compile with -D_GNU_SOURCE.
+ */
+
+#ifndef MICROTAR_FD_H
+#define MICROTAR_FD_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "microtar.h"
+
+#define MTAR_FD_ALIGNMENT 4096u
+#define MTAR_FD_DEFAULT_BUFFER_SIZE (8u*1024u*1024u)
+
+typedef struct {
+  uint64_t buffer_size;
+  int direct;
+  int preallocate;
+} mtar_fd_options_t;
+
+typedef struct {
+  int fd;
+  int fd_plain;
+  int seekable;
+  char *buffer;
+  uint64_t buffer_size;
+  uint64_t window;
+  uint64_t fill;
+  uint64_t pos;
+  uint64_t end;
+  int preallocate;
+  uint64_t allocated;
+  /* The system-calls which wrote, for the tests. */
+  uint64_t num_writes;
+} _mtar_fd_stream_t;
+
+void mtar_fd_options_init(mtar_fd_options_t *opt);
+int64_t mtar_open_fd(
+  mtar_t *tar,
+  const char *filename,
+  const mtar_fd_options_t *opt);
+
+
+void mtar_fd_options_init(mtar_fd_options_t *opt) {
+  opt->buffer_size = MTAR_FD_DEFAULT_BUFFER_SIZE;
+  opt->direct = 0;
+  opt->preallocate = 1;
+}
+
+
+static int64_t _mtar_fd_write_all(
+  _mtar_fd_stream_t *s,
+  int fd,
+  const char *data,
+  uint64_t size,
+  uint64_t offset) {
+  while (size > 0) {
+    ssize_t res;
+    if (s->seekable) {
+      res = pwrite(fd, data, size, (off_t)offset);
+    } else {
+      res = write(fd, data, size);
+    }
+    s->num_writes += 1;
+    if (res <= 0) {
+      return MTAR_EWRITEFAIL;
+    }
+    data += res;
+    size -= (uint64_t)res;
+    offset += (uint64_t)res;
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+/*
+ * Write the buffered bytes followed by data, and move the window behind.
+ * The window stays aligned to MTAR_FD_ALIGNMENT, so the page-cache gets
+ * whole pages. The bytes behind the last aligned offset are not written but
+ * kept in the buffer.
+ */
+static int64_t _mtar_fd_writev(
+  _mtar_fd_stream_t *s,
+  const char *data,
+  uint64_t size) {
+  struct iovec iov[2];
+  int i = 0;
+  uint64_t offset = s->window;
+  const uint64_t tail = (s->fill + size) % MTAR_FD_ALIGNMENT;
+  const uint64_t num = s->fill + size - tail;
+  iov[0].iov_base = s->buffer;
+  iov[0].iov_len = s->fill < num ? s->fill : num;
+  iov[1].iov_base = (void *)data;
+  iov[1].iov_len = num - iov[0].iov_len;
+  while (i < 2) {
+    ssize_t res;
+    if (iov[i].iov_len == 0) {
+      i += 1;
+      continue;
+    }
+    if (s->seekable) {
+      res = pwritev(s->fd_plain, iov + i, 2 - i, (off_t)offset);
+    } else {
+      res = writev(s->fd_plain, iov + i, 2 - i);
+    }
+    s->num_writes += 1;
+    if (res <= 0) {
+      return MTAR_EWRITEFAIL;
+    }
+    offset += (uint64_t)res;
+    while (res > 0) {
+      const uint64_t n = (uint64_t)res < iov[i].iov_len ?
+        (uint64_t)res : iov[i].iov_len;
+      iov[i].iov_base = (char *)iov[i].iov_base + n;
+      iov[i].iov_len -= n;
+      res -= (ssize_t)n;
+      if (iov[i].iov_len == 0) {
+        i += 1;
+      }
+    }
+  }
+  if (tail > size) {
+    memmove(s->buffer, s->buffer + s->fill - (tail - size), tail - size);
+    if (size > 0) {
+      memcpy(s->buffer + tail - size, data, size);
+    }
+  } else {
+    memcpy(s->buffer, data + size - tail, tail);
+  }
+  s->window = offset;
+  s->fill = tail;
+  return MTAR_ESUCCESS;
+}
+
+
+/* Write the full buffer and move the window behind it. */
+static int64_t _mtar_fd_flush_full(_mtar_fd_stream_t *s) {
+  int64_t err = _mtar_fd_write_all(
+    s, s->fd, s->buffer, s->buffer_size, s->window);
+  if (err) {
+    return err;
+  }
+  s->window += s->buffer_size;
+  s->fill = 0;
+  return MTAR_ESUCCESS;
+}
+
+
+static int64_t _mtar_fd_write(mtar_t *tar, const void *data, uint64_t size) {
+  _mtar_fd_stream_t *s = (_mtar_fd_stream_t *)tar->stream;
+  const char *p = (const char *)data;
+  int64_t err;
+  while (size > 0) {
+    uint64_t n;
+    if (s->pos < s->window) {
+      /* Rewrite of a region which was already flushed. */
+      if (!s->seekable) {
+        return MTAR_ESEEKFAIL;
+      }
+      n = s->window - s->pos < size ? s->window - s->pos : size;
+      err = _mtar_fd_write_all(s, s->fd_plain, p, n, s->pos);
+      if (err) {
+        return err;
+      }
+    } else if (
+        s->fd == s->fd_plain &&
+        s->pos == s->window + s->fill &&
+        size >= s->buffer_size - s->fill) {
+      n = size;
+      err = _mtar_fd_writev(s, p, n);
+      if (err) {
+        return err;
+      }
+    } else if (s->pos <= s->window + s->fill) {
+      const uint64_t at = s->pos - s->window;
+      n = s->buffer_size - at < size ? s->buffer_size - at : size;
+      memcpy(s->buffer + at, p, n);
+      if (at + n > s->fill) {
+        s->fill = at + n;
+      }
+      if (s->fill == s->buffer_size && at + n == s->buffer_size) {
+        err = _mtar_fd_flush_full(s);
+        if (err) {
+          return err;
+        }
+      }
+    } else {
+      /* Writing behind a gap is not supported. */
+      return MTAR_ESEEKFAIL;
+    }
+    p += n;
+    size -= n;
+    s->pos += n;
+    if (s->pos > s->end) {
+      s->end = s->pos;
+    }
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+/* Allocate the file up to at least end, a hint only. */
+static void _mtar_fd_preallocate(_mtar_fd_stream_t *s, uint64_t end) {
+#ifdef __linux__
+  if (s->preallocate && end > s->allocated) {
+    const uint64_t step = s->allocated + s->buffer_size;
+    const uint64_t to = _mtar_round_up(
+      end > step ? end : step, s->buffer_size);
+    if (fallocate(
+        s->fd_plain,
+        0,
+        (off_t)s->allocated,
+        (off_t)(to - s->allocated)) == 0) {
+      s->allocated = to;
+    } else {
+      /* Not supported by the filesystem, not an error. */
+      s->preallocate = 0;
+      errno = 0;
+    }
+  }
+#else
+  (void)s;
+  (void)end;
+#endif
+}
+
+
+/* Before a member of known size, see the top of this file. */
+static int64_t _mtar_fd_reserve(mtar_t *tar, uint64_t size) {
+  _mtar_fd_stream_t *s = (_mtar_fd_stream_t *)tar->stream;
+  _mtar_fd_preallocate(s, s->pos + size);
+  if (s->fd == s->fd_plain &&
+      s->pos == s->window + s->fill &&
+      size + MTAR_FD_ALIGNMENT <= s->buffer_size &&
+      s->fill + size > s->buffer_size) {
+    return _mtar_fd_writev(s, NULL, 0);
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+/* Write-only, see mtar_open_fd(). */
+static int64_t _mtar_fd_read(mtar_t *tar, void *data, uint64_t size) {
+  (void)tar;
+  (void)data;
+  (void)size;
+  return MTAR_EREADFAIL;
+}
+
+
+static int64_t _mtar_fd_seek(mtar_t *tar, uint64_t pos) {
+  _mtar_fd_stream_t *s = (_mtar_fd_stream_t *)tar->stream;
+  if (!s->seekable && pos != s->pos) {
+    return MTAR_ESEEKFAIL;
+  }
+  s->pos = pos;
+  return MTAR_ESUCCESS;
+}
+
+
+static int64_t _mtar_fd_size(mtar_t *tar, uint64_t *size) {
+  _mtar_fd_stream_t *s = (_mtar_fd_stream_t *)tar->stream;
+  *size = s->end;
+  return MTAR_ESUCCESS;
+}
+
+
+static int64_t _mtar_fd_close(mtar_t *tar) {
+  _mtar_fd_stream_t *s = (_mtar_fd_stream_t *)tar->stream;
+  int64_t err = MTAR_ESUCCESS;
+  /* The tail is not a multiple of the alignment, so it bypasses O_DIRECT. */
+  if (s->fill > 0) {
+    err = _mtar_fd_write_all(s, s->fd_plain, s->buffer, s->fill, s->window);
+  }
+  if (err == MTAR_ESUCCESS && s->seekable) {
+    if (ftruncate(s->fd_plain, (off_t)s->end) != 0) {
+      err = MTAR_EWRITEFAIL;
+    }
+  }
+  if (s->fd_plain != s->fd && close(s->fd_plain) != 0) {
+    err = MTAR_EWRITEFAIL;
+  }
+  if (close(s->fd) != 0) {
+    err = MTAR_EWRITEFAIL;
+  }
+  free(s->buffer);
+  free(s);
+  tar->stream = NULL;
+  return err;
+}
+
+
+/*
+ * Open filename for writing. Use opt = NULL for the defaults. The tar is
+ * write-only, i.e. mtar_read_header(), mtar_read_data(), mtar_find() and
+ * mtar_find_index() fail.
+ */
+int64_t mtar_open_fd(
+  mtar_t *tar,
+  const char *filename,
+  const mtar_fd_options_t *opt) {
+  mtar_fd_options_t defaults;
+  _mtar_fd_stream_t *s;
+  struct stat st;
+  void *buffer = NULL;
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC;
+
+  if (opt == NULL) {
+    mtar_fd_options_init(&defaults);
+    opt = &defaults;
+  }
+  memset(tar, 0, sizeof(*tar));
+  tar->write = _mtar_fd_write;
+  tar->read = _mtar_fd_read;
+  tar->seek = _mtar_fd_seek;
+  tar->close = _mtar_fd_close;
+  tar->size = _mtar_fd_size;
+  tar->reserve = _mtar_fd_reserve;
+
+  s = (_mtar_fd_stream_t *)calloc(1, sizeof(_mtar_fd_stream_t));
+  if (s == NULL) {
+    return MTAR_EOPENFAIL;
+  }
+  s->buffer_size = _mtar_round_up(
+    opt->buffer_size > 0 ? opt->buffer_size : MTAR_FD_DEFAULT_BUFFER_SIZE,
+    MTAR_FD_ALIGNMENT);
+  if (posix_memalign(&buffer, MTAR_FD_ALIGNMENT, s->buffer_size) != 0) {
+    free(s);
+    return MTAR_EOPENFAIL;
+  }
+  s->buffer = (char *)buffer;
+
+  s->fd_plain = open(filename, flags, 0664);
+  if (s->fd_plain < 0) {
+    free(s->buffer);
+    free(s);
+    return MTAR_EOPENFAIL;
+  }
+  s->fd = s->fd_plain;
+  s->seekable = fstat(s->fd, &st) == 0 && S_ISREG(st.st_mode);
+  /* Not for FIFOs, and devices. */
+  s->preallocate = opt->preallocate && s->seekable;
+#ifdef O_DIRECT
+  if (opt->direct && s->seekable) {
+    /* Not all filesystems support O_DIRECT, then the page-cache is used. */
+    const int fd = open(filename, O_WRONLY | O_DIRECT);
+    if (fd >= 0) {
+      s->fd = fd;
+    }
+  }
+#endif
+  tar->stream = s;
+  return MTAR_ESUCCESS;
+}
+
+#endif
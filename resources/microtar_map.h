@@ -0,0 +1,360 @@
+/**
+ * Copyright (c) 2019 Sebastian A. Mueller
+ *                    Max-Planck-Institute for nuclear-physics, Heidelberg
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See microtar.h.
+ */
+
+/**
+ * microtar_map
+ * ============
+ *
+ * A read-only backend for tars written with microtar. The tar is memory-mapped
+ * and members are handed out as pointers into the map, i.e. without copies.
+ * When the tar can not be mapped, e.g. for a huge file on a 32bit system,
+ * the members are read with pread(2) instead.
+ *
+ * There is no cursor shared between calls. A member is addressed by the
+ * offset of its tar-header, and mtar_map_member() returns the offset of the
+ * next one. So many threads can read different members of the same tar at
+ * the same time. mtar_map_for_each() does this for a list of members.
+ *
+ * Needs POSIX and pthreads, e.g. compile with -D_GNU_SOURCE -lpthread.
+ */
+
+#ifndef MICROTAR_MAP_H
+#define MICROTAR_MAP_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "microtar.h"
+
+typedef struct {
+  int fd;
+  uint64_t size;
+  const char *data;
+} mtar_map_t;
+
+typedef struct {
+  mtar_header_t header;
+  uint64_t header_offset;
+  uint64_t data_offset;
+  /* Points into the map, NULL when the tar is read with pread(2). */
+  const char *data;
+} mtar_member_t;
+
+typedef int64_t (*mtar_map_callback_t)(
+  const mtar_map_t *map,
+  const mtar_member_t *member,
+  void *arg);
+
+int64_t mtar_map_open(mtar_map_t *map, const char *filename, int use_mmap);
+int64_t mtar_map_close(mtar_map_t *map);
+int64_t mtar_map_read(
+  const mtar_map_t *map,
+  uint64_t offset,
+  void *buf,
+  uint64_t size);
+int64_t mtar_map_member(
+  const mtar_map_t *map,
+  uint64_t header,
+  mtar_member_t *member,
+  uint64_t *next);
+int64_t mtar_map_list(mtar_map_t *map, uint64_t **headers, uint64_t *num);
+int64_t mtar_map_find_index(
+  const mtar_map_t *map,
+  mtar_index_t *index,
+  mtar_member_t *member);
+int64_t mtar_map_for_each(
+  const mtar_map_t *map,
+  const uint64_t *headers,
+  uint64_t num_headers,
+  uint64_t num_threads,
+  mtar_map_callback_t callback,
+  void *arg);
+
+
+int64_t mtar_map_open(mtar_map_t *map, const char *filename, int use_mmap) {
+  struct stat st;
+  void *data;
+  map->fd = -1;
+  map->size = 0;
+  map->data = NULL;
+  map->fd = open(filename, O_RDONLY);
+  if (map->fd < 0) {
+    return MTAR_EOPENFAIL;
+  }
+  if (fstat(map->fd, &st) != 0) {
+    mtar_map_close(map);
+    return MTAR_EOPENFAIL;
+  }
+  map->size = (uint64_t)st.st_size;
+  if (use_mmap && map->size > 0 && map->size == (uint64_t)(size_t)map->size) {
+    data = mmap(NULL, (size_t)map->size, PROT_READ, MAP_SHARED, map->fd, 0);
+    if (data != MAP_FAILED) {
+      map->data = (const char *)data;
+      madvise(data, (size_t)map->size, MADV_WILLNEED);
+    }
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+int64_t mtar_map_close(mtar_map_t *map) {
+  int64_t err = MTAR_ESUCCESS;
+  if (map->data != NULL) {
+    if (munmap((void *)map->data, (size_t)map->size) != 0) {
+      err = MTAR_EFAILURE;
+    }
+    map->data = NULL;
+  }
+  if (map->fd >= 0) {
+    if (close(map->fd) != 0) {
+      err = MTAR_EFAILURE;
+    }
+    map->fd = -1;
+  }
+  return err;
+}
+
+
+/* Copy size bytes at offset into buf. Safe to call from many threads. */
+int64_t mtar_map_read(
+  const mtar_map_t *map,
+  uint64_t offset,
+  void *buf,
+  uint64_t size) {
+  uint64_t done = 0;
+  if (offset > map->size || size > map->size - offset) {
+    return MTAR_EREADFAIL;
+  }
+  if (map->data != NULL) {
+    memcpy(buf, map->data + offset, size);
+    return MTAR_ESUCCESS;
+  }
+  while (done < size) {
+    ssize_t res = pread(
+      map->fd, (char *)buf + done, size - done, (off_t)(offset + done));
+    if (res <= 0) {
+      return MTAR_EREADFAIL;
+    }
+    done += (uint64_t)res;
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+/* Read the member with its tar-header at offset header. On success, next is
+ * the offset of the following tar-header. */
+int64_t mtar_map_member(
+  const mtar_map_t *map,
+  uint64_t header,
+  mtar_member_t *member,
+  uint64_t *next) {
+  int64_t err;
+  _mtar_raw_header_t rh;
+  err = mtar_map_read(map, header, &rh, sizeof(rh));
+  if (err) {
+    return err;
+  }
+  err = _mtar_raw_to_header(&member->header, &rh);
+  if (err) {
+    return err;
+  }
+  member->header_offset = header;
+  member->data_offset = header + sizeof(_mtar_raw_header_t);
+  if (member->header.size > map->size - member->data_offset) {
+    return MTAR_EREADFAIL;
+  }
+  member->data = map->data ? map->data + member->data_offset : NULL;
+  if (next) {
+    *next = member->data_offset + _mtar_round_up(member->header.size, 512);
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+/* Walk all tar-headers. The caller frees headers. */
+int64_t mtar_map_list(mtar_map_t *map, uint64_t **headers, uint64_t *num) {
+  int64_t err;
+  uint64_t pos = 0;
+  uint64_t capacity = 1024;
+  mtar_member_t member;
+  *num = 0;
+  *headers = (uint64_t *)malloc(capacity*sizeof(uint64_t));
+  if (*headers == NULL) {
+    return MTAR_EFAILURE;
+  }
+  while ((err = mtar_map_member(map, pos, &member, &pos)) == MTAR_ESUCCESS) {
+    if (*num == capacity) {
+      uint64_t *more;
+      capacity *= 2;
+      more = (uint64_t *)realloc(*headers, capacity*sizeof(uint64_t));
+      if (more == NULL) {
+        free(*headers);
+        *headers = NULL;
+        return MTAR_EFAILURE;
+      }
+      *headers = more;
+    }
+    (*headers)[*num] = member.header_offset;
+    *num += 1;
+  }
+  if (err == MTAR_ENULLRECORD || pos == map->size) {
+    return MTAR_ESUCCESS;
+  }
+  free(*headers);
+  *headers = NULL;
+  return err;
+}
+
+
+/* Find the index written by mtar_write_index() from the tail. The records
+ * are the first bytes of the member's data. */
+int64_t mtar_map_find_index(
+  const mtar_map_t *map,
+  mtar_index_t *index,
+  mtar_member_t *member) {
+  int64_t err;
+  uint64_t pos, i, k;
+  char record[512];
+  const char *footer = record + 512 - MTAR_INDEX_FOOTER_SIZE;
+  pos = map->size - map->size % 512;
+  for (i = 0; i <= MTAR_INDEX_MAX_NUM_TRAILING_NULL_RECORDS; i++) {
+    int is_null = 1;
+    if (pos < 2*512) {
+      return MTAR_ENOTFOUND;
+    }
+    pos -= 512;
+    err = mtar_map_read(map, pos, record, 512);
+    if (err) {
+      return err;
+    }
+    for (k = 0; k < 512; k++) {
+      if (record[k] != '\0') {
+        is_null = 0;
+        break;
+      }
+    }
+    if (!is_null) {
+      break;
+    }
+  }
+  if (memcmp(footer, MTAR_INDEX_MAGIC, 8)) {
+    return MTAR_ENOTFOUND;
+  }
+  memcpy(&index->record_size, footer + 8, 8);
+  memcpy(&index->num_records, footer + 16, 8);
+  memcpy(&index->header, footer + 24, 8);
+  err = mtar_map_member(map, index->header, member, NULL);
+  if (err) {
+    return err;
+  }
+  if (member->data_offset + member->header.size != pos + 512 ||
+      index->record_size*index->num_records + MTAR_INDEX_FOOTER_SIZE >
+      member->header.size) {
+    return MTAR_ENOTFOUND;
+  }
+  return MTAR_ESUCCESS;
+}
+
+
+typedef struct {
+  const mtar_map_t *map;
+  const uint64_t *headers;
+  uint64_t num_headers;
+  uint64_t next;
+  int64_t err;
+  mtar_map_callback_t callback;
+  void *arg;
+  pthread_mutex_t mutex;
+} _mtar_map_work_t;
+
+
+static void *_mtar_map_worker(void *arg) {
+  _mtar_map_work_t *work = (_mtar_map_work_t *)arg;
+  mtar_member_t member;
+  int64_t err;
+  uint64_t i;
+  while (1) {
+    pthread_mutex_lock(&work->mutex);
+    i = work->next;
+    work->next += 1;
+    if (work->err) {
+      i = work->num_headers;
+    }
+    pthread_mutex_unlock(&work->mutex);
+    if (i >= work->num_headers) {
+      break;
+    }
+    err = mtar_map_member(work->map, work->headers[i], &member, NULL);
+    if (err == MTAR_ESUCCESS) {
+      err = work->callback(work->map, &member, work->arg);
+    }
+    if (err) {
+      pthread_mutex_lock(&work->mutex);
+      if (work->err == MTAR_ESUCCESS) {
+        work->err = err;
+      }
+      pthread_mutex_unlock(&work->mutex);
+    }
+  }
+  return NULL;
+}
+
+
+/* Call callback for each member in headers using num_threads threads. The
+ * members are handed out in the order of headers, but the calls run
+ * concurrently. Stops at, and returns, the first error of the callback. */
+int64_t mtar_map_for_each(
+  const mtar_map_t *map,
+  const uint64_t *headers,
+  uint64_t num_headers,
+  uint64_t num_threads,
+  mtar_map_callback_t callback,
+  void *arg) {
+  _mtar_map_work_t work;
+  pthread_t *threads;
+  uint64_t t, num_started = 0;
+  if (num_threads < 1) {
+    num_threads = 1;
+  }
+  work.map = map;
+  work.headers = headers;
+  work.num_headers = num_headers;
+  work.next = 0;
+  work.err = MTAR_ESUCCESS;
+  work.callback = callback;
+  work.arg = arg;
+  if (pthread_mutex_init(&work.mutex, NULL) != 0) {
+    return MTAR_EFAILURE;
+  }
+  threads = (pthread_t *)malloc(num_threads*sizeof(pthread_t));
+  if (threads == NULL) {
+    pthread_mutex_destroy(&work.mutex);
+    return MTAR_EFAILURE;
+  }
+  for (t = 0; t < num_threads; t++) {
+    if (pthread_create(&threads[t], NULL, _mtar_map_worker, &work) != 0) {
+      break;
+    }
+    num_started += 1;
+  }
+  if (num_started == 0) {
+    _mtar_map_worker(&work);
+  }
+  for (t = 0; t < num_started; t++) {
+    pthread_join(threads[t], NULL);
+  }
+  free(threads);
+  pthread_mutex_destroy(&work.mutex);
+  return work.err;
+}
+
+#endif
@@ -0,0 +1,68 @@
+/* gcc test_arrowipc.c -o TestArrowIpc -std=c89 -Wall -pedantic              */
+
+/*
+ * Writes '_test_arrowipc.arrow'. It can be read with
+ * pyarrow.ipc.open_stream().
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "arrowipc.h"
+
+#define CHECK(test) \
+    do { \
+        if ( !(test) ) { \
+            printf("In %s, line %d\n", __FILE__, __LINE__); \
+            printf("Expected true\n"); \
+            return EXIT_FAILURE; \
+        } \
+    } while (0)
+
+
+int main() {
+
+  /* Write two batches of two columns */
+  {
+    arrowipc_t s;
+    const char *names[2] = {"x", "y"};
+    const char *keys[1] = {"comment"};
+    const char *run_values[1] = {"I might be a run-header."};
+    const char *evt_values[1] = {"And might be an event-header."};
+    const float x[3] = {1.0f, 2.0f, 3.0f};
+    const float y[3] = {4.0f, 5.0f, 6.0f};
+    FILE *f;
+    uint32_t word[2];
+    long size;
+
+    CHECK(arrowipc_open(&s, "_test_arrowipc.arrow") == ARROWIPC_ESUCCESS);
+    CHECK(arrowipc_write_schema(&s, 2, names, 1, keys, run_values) == 0);
+
+    CHECK(arrowipc_write_batch(&s, 3, 2, 1, keys, evt_values) == 0);
+    CHECK(arrowipc_write_column(&s, x, sizeof(x)) == 0);
+    CHECK(arrowipc_end_column(&s) == 0);
+    CHECK(arrowipc_write_column(&s, y, 2*sizeof(float)) == 0);
+    CHECK(arrowipc_end_column(&s) == ARROWIPC_EBADSIZE);
+    CHECK(arrowipc_write_column(&s, y + 2, sizeof(float)) == 0);
+    CHECK(arrowipc_end_column(&s) == 0);
+
+    CHECK(arrowipc_write_batch(&s, 0, 2, 0, NULL, NULL) == 0);
+    CHECK(arrowipc_end_column(&s) == 0);
+    CHECK(arrowipc_end_column(&s) == 0);
+    CHECK(arrowipc_close(&s) == 0);
+
+    f = fopen("_test_arrowipc.arrow", "rb");
+    CHECK(f != NULL);
+    CHECK(fread(word, sizeof(uint32_t), 2, f) == 2);
+    CHECK(word[0] == ARROWIPC_CONTINUATION);
+    CHECK(word[1] % 8 == 0);
+    CHECK(fseek(f, -8, SEEK_END) == 0);
+    size = ftell(f) + 8;
+    CHECK(size % 8 == 0);
+    CHECK(fread(word, sizeof(uint32_t), 2, f) == 2);
+    CHECK(word[0] == ARROWIPC_CONTINUATION);
+    CHECK(word[1] == 0);
+    CHECK(fclose(f) == 0);
+  }
+  return 0;
+}
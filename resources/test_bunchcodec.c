@@ -0,0 +1,174 @@
+/* gcc test_bunchcodec.c -o TestBunchCodec -lm -std=c89 -Wall -pedantic -O2    */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "bunchcodec.h"
+
+#define CHECK(test) \
+    do { \
+        if ( !(test) ) { \
+            printf("In %s, line %d\n", __FILE__, __LINE__); \
+            printf("Expected true\n"); \
+            return EXIT_FAILURE; \
+        } \
+    } while (0)
+
+
+uint32_t xorshift32(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+float uniform(uint32_t *state) {
+  return (float)xorshift32(state)/4294967296.0f;
+}
+
+/* Bunches similar to CORSIKA's, i.e. slowly varying zem, constant bsize. */
+void make_bunches(float *bunches, uint64_t num_bunches, uint32_t seed) {
+  uint64_t i;
+  float zem = 2e6f;
+  for (i = 0; i < num_bunches; i++) {
+    float *b = bunches + 8*i;
+    zem -= 100.0f*uniform(&seed);
+    b[0] = 1e4f*(uniform(&seed) - 0.5f);
+    b[1] = 1e4f*(uniform(&seed) - 0.5f);
+    b[2] = 0.01f*(uniform(&seed) - 0.5f);
+    b[3] = 0.01f*(uniform(&seed) - 0.5f);
+    b[4] = 100.0f*uniform(&seed);
+    b[5] = zem;
+    b[6] = 1.0f;
+    b[7] = 250.0f + 450.0f*uniform(&seed);
+  }
+}
+
+int equal_bits(const float *a, const float *b, uint64_t num_floats) {
+  return memcmp(a, b, num_floats*sizeof(float)) == 0;
+}
+
+int main() {
+
+  /* empty block */
+  {
+    char block[BUNCHCODEC_HEADER_SIZE];
+    uint64_t num_bunches = 1337;
+    CHECK(bunchcodec_encoded_size(0) == BUNCHCODEC_HEADER_SIZE);
+    CHECK(bunchcodec_encode(NULL, 0, BUNCHCODEC_DEFAULT_DELTA_MASK, block) ==
+      BUNCHCODEC_HEADER_SIZE);
+    CHECK(bunchcodec_decode(block, sizeof(block), NULL, &num_bunches) ==
+      BUNCHCODEC_ESUCCESS);
+    CHECK(num_bunches == 0);
+  }
+
+  /* round trip is bit exact for all sizes, also the ones not multiple of 16 */
+  {
+    uint64_t n;
+    uint32_t mask;
+    for (n = 1; n < 100; n++) {
+      for (mask = 0; mask < 256; mask += 15) {
+        float *in = (float *)malloc(n*8*sizeof(float));
+        float *back = (float *)malloc(n*8*sizeof(float));
+        char *block = (char *)malloc(bunchcodec_encoded_size(n));
+        uint64_t num_bunches = 0;
+        CHECK(in != NULL && back != NULL && block != NULL);
+        make_bunches(in, n, 1 + (uint32_t)n);
+        CHECK(bunchcodec_encode(in, n, mask, block) ==
+          bunchcodec_encoded_size(n));
+        CHECK(bunchcodec_decode(
+          block, bunchcodec_encoded_size(n), back, &num_bunches) ==
+          BUNCHCODEC_ESUCCESS);
+        CHECK(num_bunches == n);
+        CHECK(equal_bits(in, back, n*8));
+        free(in);
+        free(back);
+        free(block);
+      }
+    }
+  }
+
+  /* special floats survive, i.e. nan, inf, negative zero, denormals */
+  {
+    float in[8*16], back[8*16];
+    char block[BUNCHCODEC_HEADER_SIZE + 16*32];
+    uint64_t num_bunches = 0;
+    uint64_t i;
+    for (i = 0; i < 8*16; i++) {
+      switch (i % 4) {
+        case 0: in[i] = (float)(HUGE_VAL); break;
+        case 1: in[i] = -0.0f; break;
+        case 2: in[i] = 1e-45f; break;
+        case 3: in[i] = (float)sqrt(-1.0); break;
+      }
+    }
+    bunchcodec_encode(in, 16, BUNCHCODEC_DEFAULT_DELTA_MASK, block);
+    CHECK(bunchcodec_decode(block, sizeof(block), back, &num_bunches) ==
+      BUNCHCODEC_ESUCCESS);
+    CHECK(equal_bits(in, back, 8*16));
+  }
+
+  /* constant columns become planes of zeros */
+  {
+    float in[8*32];
+    char block[BUNCHCODEC_HEADER_SIZE + 32*32];
+    const unsigned char *planes;
+    uint64_t i;
+    make_bunches(in, 32, 42);
+    bunchcodec_encode(in, 32, BUNCHCODEC_DEFAULT_DELTA_MASK, block);
+    planes = (const unsigned char *)block + BUNCHCODEC_HEADER_SIZE;
+    /* bsize is column 6, its first delta is the value itself */
+    for (i = 1; i < 32; i++) {
+      CHECK(planes[(6*4 + 0)*32 + i] == 0);
+      CHECK(planes[(6*4 + 1)*32 + i] == 0);
+      CHECK(planes[(6*4 + 2)*32 + i] == 0);
+      CHECK(planes[(6*4 + 3)*32 + i] == 0);
+    }
+  }
+
+  /* broken blocks */
+  {
+    float in[8*4], back[8*4];
+    char block[BUNCHCODEC_HEADER_SIZE + 4*32];
+    uint64_t num_bunches = 0;
+    make_bunches(in, 4, 7);
+    bunchcodec_encode(in, 4, BUNCHCODEC_DEFAULT_DELTA_MASK, block);
+    CHECK(bunchcodec_decode(block, 8, back, &num_bunches) ==
+      BUNCHCODEC_ETRUNCATED);
+    CHECK(bunchcodec_decode(block, sizeof(block) - 1, back, &num_bunches) ==
+      BUNCHCODEC_ETRUNCATED);
+    block[0] = 'X';
+    CHECK(bunchcodec_decode(block, sizeof(block), back, &num_bunches) ==
+      BUNCHCODEC_EBADMAGIC);
+  }
+
+  /* throughput of encoding */
+  {
+    const uint64_t n = 1024*1024;
+    const int num_repetitions = 16;
+    float *in = (float *)malloc(n*8*sizeof(float));
+    char *block = (char *)malloc(bunchcodec_encoded_size(n));
+    clock_t start;
+    double seconds;
+    int r;
+    CHECK(in != NULL && block != NULL);
+    make_bunches(in, n, 3);
+    start = clock();
+    for (r = 0; r < num_repetitions; r++) {
+      bunchcodec_encode(in, n, BUNCHCODEC_DEFAULT_DELTA_MASK, block);
+    }
+    seconds = (double)(clock() - start)/CLOCKS_PER_SEC;
+    fprintf(
+      stdout,
+      "bunchcodec_encode: %.2f GB/s\n",
+      1e-9*(double)(num_repetitions*n*32)/seconds);
+    free(in);
+    free(block);
+  }
+  return 0;
+}
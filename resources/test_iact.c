@@ -0,0 +1,252 @@
+/* gcc test_iact.c -o TestIact -lm -pthread -Wall -O2                        */
+
+/*
+ * Drives iact.c like CORSIKA does, with fixed photon-bunches and particles,
+ * so the output can be checked without CORSIKA. Run it in a directory with
+ * an optional iact_options.txt:
+ *
+ *   ./TestIact run.tar [TELESCOPE] [CSCAT] [IMPSAMP path] [LONGI]
+ *
+ * The run has NUM_EVENTS events, the e-th with NUM_BUNCHES[e] bunches and a
+ * primary gamma, or an electron when e is odd, of 10*10^e GeV. The bunches
+ * passed to telout_ are written to expected_bunches.Nx8_float32, and the
+ * 39 - 2*e particles passed to telprt_ to expected_particles.Nx7_float32,
+ * both for all events in sequence. The wrapper's tests/conftest.py reads
+ * the run back.
+ *
+ * The arguments after the path call telset_, telasu_, telsmp_, and tellng_
+ * just like the cards of the steering-card do. TELESCOPE sets a grid of
+ * 3x3 detector-spheres, CSCAT reuses each shower 3 times within +-50m,
+ * IMPSAMP passes the file of importance-sampling, and LONGI fills the
+ * longitudinal distributions once in each event before telend_, with the
+ * value 1000*e + i in bin i.
+ */
+
+#include "iact.c"
+
+#define NUM_EVENTS 3
+static const long NUM_BUNCHES[NUM_EVENTS] = {1000, 0, 2500};
+
+#define NUM_PARTICLE_WORDS 7
+#define NUM_LONGI 9
+#define NUM_LONGI_THICK 5
+
+/* CORSIKA's atmosphere, roughly isothermal with 8 km scale-height. */
+double heigh_(double *thick) {
+  const double t = *thick > 1e-9 ? *thick : 1e-9;
+  return 8e5*log(1033.0/t);
+}
+
+double refidx_(double *height) {
+  return 1.0 + 2.9e-4*exp(-(*height)/8e5);
+}
+
+uint32_t xorshift32(uint32_t *state) {
+  uint32_t x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *state = x;
+  return x;
+}
+
+double uniform(uint32_t *state) {
+  return (double)xorshift32(state)/4294967296.0;
+}
+
+void write_primaries(void) {
+  FILE *f = fopen(PRIMARY_PATH, "wb");
+  int e;
+  for (e = 0; e < NUM_EVENTS; e++) {
+    /* particle_id, energy_GeV, theta_rad, phi_rad, depth_g_per_cm2 */
+    double primary[5] = {1.0, 10.0, 0.1, 0.2, 0.0};
+    int32_t seeds[12];
+    int s;
+    for (s = 0; s < 4; s++) {
+      seeds[3*s + 0] = 1 + e + s;
+      seeds[3*s + 1] = 0;
+      seeds[3*s + 2] = 0;
+    }
+    primary[0] = e % 2 ? 3.0 : 1.0;
+    primary[1] = 10.0*pow(10.0, e);
+    fwrite(primary, sizeof(double), 5, f);
+    fwrite(seeds, sizeof(int32_t), 12, f);
+  }
+  fclose(f);
+}
+
+void set_telescopes(void) {
+  int i;
+  for (i = 0; i < 9; i++) {
+    double x = (i % 3 - 1)*1e4;
+    double y = (i / 3 - 1)*1e4;
+    double z = (i % 2)*500.0;
+    double r = 2e3;
+    telset_(&x, &y, &z, &r);
+  }
+  telshw_();
+}
+
+void emit_bunches(long num, uint32_t *prng, FILE *expected) {
+  long b;
+  for (b = 0; b < num; b++) {
+    double bsize = 1.0;
+    double wt = 1.0;
+    double x = (uniform(prng) - 0.5)*4e4;
+    double y = (uniform(prng) - 0.5)*4e4;
+    double cx = (uniform(prng) - 0.5)*0.05;
+    double cy = (uniform(prng) - 0.5)*0.05;
+    double time = 100.0 + 50.0*uniform(prng);
+    double zem = 1e6 + 1e6*uniform(prng);
+    double lambda = 0.0;
+    float bunch[8];
+    bunch[0] = (float)x;
+    bunch[1] = (float)y;
+    bunch[2] = (float)cx;
+    bunch[3] = (float)cy;
+    bunch[4] = (float)time;
+    bunch[5] = (float)zem;
+    bunch[6] = (float)bsize;
+    bunch[7] = (float)lambda;
+    fwrite(bunch, sizeof(float), 8, expected);
+    telout_(&bsize, &wt, &x, &y, &cx, &cy, &time, &zem, &lambda);
+  }
+}
+
+/* One block of 39 particles, the last ones are empty like in CORSIKA. */
+void emit_particles(int num, uint32_t *prng, FILE *expected) {
+  float block[IACT_PARTICLES_NUM_PER_BLOCK*NUM_PARTICLE_WORDS];
+  int maxbuf = IACT_PARTICLES_NUM_PER_BLOCK*NUM_PARTICLE_WORDS;
+  int i;
+  memset(block, 0, sizeof(block));
+  for (i = 0; i < num; i++) {
+    float *p = &block[i*NUM_PARTICLE_WORDS];
+    p[0] = (float)(1000*(1 + (int)(uniform(prng)*14)) + 11);
+    p[1] = (float)(uniform(prng) - 0.5);
+    p[2] = (float)(uniform(prng) - 0.5);
+    p[3] = (float)(10.0*uniform(prng));
+    p[4] = (float)((uniform(prng) - 0.5)*1e5);
+    p[5] = (float)((uniform(prng) - 0.5)*1e5);
+    p[6] = (float)(1e3*uniform(prng));
+  }
+  fwrite(block, sizeof(float), num*NUM_PARTICLE_WORDS, expected);
+  telprt_(block, &maxbuf);
+}
+
+void emit_longitudinal(int event) {
+  double data[NUM_LONGI*NUM_LONGI_THICK];
+  int type = 1;
+  int ndim = NUM_LONGI_THICK;
+  int np = NUM_LONGI;
+  int nthick = NUM_LONGI_THICK;
+  double thickstep = 10.0;
+  int i;
+  for (i = 0; i < NUM_LONGI*NUM_LONGI_THICK; i++) {
+    data[i] = 1000.0*event + i;
+  }
+  tellng_(&type, data, &ndim, &np, &nthick, &thickstep);
+}
+
+int main(int argc, char *argv[]) {
+  cors_real_t runh[273], evth[273], evte[273], rune[273];
+  cors_real_dbl_t prmpar[PRMPAR_SIZE];
+  FILE *expected_bunches, *expected_particles;
+  uint32_t prng = 1337u;
+  int telescope = 0, cscat = 0, longi = 0;
+  char *impsamp = NULL;
+  int a, e;
+
+  if (argc < 2) {
+    fprintf(
+      stderr,
+      "Usage: %s run.tar [TELESCOPE] [CSCAT] [IMPSAMP path] [LONGI]\n",
+      argv[0]);
+    return EXIT_FAILURE;
+  }
+  for (a = 2; a < argc; a++) {
+    if (strcmp(argv[a], "TELESCOPE") == 0) {
+      telescope = 1;
+    } else if (strcmp(argv[a], "CSCAT") == 0) {
+      cscat = 1;
+    } else if (strcmp(argv[a], "IMPSAMP") == 0 && a + 1 < argc) {
+      impsamp = argv[++a];
+    } else if (strcmp(argv[a], "LONGI") == 0) {
+      longi = 1;
+    } else {
+      fprintf(stderr, "Unknown argument '%s'.\n", argv[a]);
+      return EXIT_FAILURE;
+    }
+  }
+  write_primaries();
+  expected_bunches = fopen("expected_bunches.Nx8_float32", "wb");
+  expected_particles = fopen("expected_particles.Nx7_float32", "wb");
+  if (expected_bunches == NULL || expected_particles == NULL) {
+    return EXIT_FAILURE;
+  }
+
+  memset(runh, 0, sizeof(runh));
+  memset(rune, 0, sizeof(rune));
+  memset(prmpar, 0, sizeof(prmpar));
+  memcpy(&runh[0], "RUNH", 4);
+  memcpy(&rune[0], "RUNE", 4);
+  runh[1] = 1.0f;
+  runh[4] = 1.0f;
+  runh[5] = 2300e2f;
+
+  /* The cards of the steering-card come before the run. */
+  if (telescope) {
+    set_telescopes();
+  }
+  if (cscat) {
+    int num_reuse = 3;
+    double dx = 5e3;
+    double dy = 5e3;
+    telasu_(&num_reuse, &dx, &dy);
+  }
+  if (impsamp != NULL) {
+    telsmp_(impsamp);
+  }
+  telfil_(argv[1]);
+  telrnh_(runh);
+
+  for (e = 0; e < NUM_EVENTS; e++) {
+    double type, energy, theta, phi, depth;
+    int s[12];
+    int k;
+    extprm_(
+      &type, &energy, &theta, &phi, &depth,
+      &s[0], &s[1], &s[2], &s[3], &s[4], &s[5],
+      &s[6], &s[7], &s[8], &s[9], &s[10], &s[11]);
+    memset(evth, 0, sizeof(evth));
+    memset(evte, 0, sizeof(evte));
+    memcpy(&evth[0], "EVTH", 4);
+    memcpy(&evte[0], "EVTE", 4);
+    evth[1] = (float)(e + 1);
+    evth[2] = (float)type;
+    evth[3] = (float)energy;
+    evth[10] = (float)theta;
+    evth[11] = (float)phi;
+    evth[12] = 4.0f;
+    for (k = 0; k < 12; k++) {
+      evth[13 + k] = (float)s[k];
+    }
+    evth[46] = 1.0f;
+    evth[47] = 2300e2f;
+    evth[95] = 250.0f;
+    evth[96] = 700.0f;
+    televt_(evth, prmpar);
+    emit_bunches(NUM_BUNCHES[e], &prng, expected_bunches);
+    emit_particles(IACT_PARTICLES_NUM_PER_BLOCK - 2*e, &prng,
+      expected_particles);
+    if (longi) {
+      emit_longitudinal(e);
+    }
+    evte[1] = (float)(e + 1);
+    telend_(evte);
+  }
+  telrne_(rune);
+
+  fclose(expected_bunches);
+  fclose(expected_particles);
+  return EXIT_SUCCESS;
+}
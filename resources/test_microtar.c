@@ -1,14 +1,17 @@
 /* Copyright (c) 2019 Sebastian A. Mueller                                    */
 /*                    Max-Planck-Institute for nuclear-physics, Heidelberg    */
 
-/* gcc test_microtar.c -o TestMicroTar -lm -std=c89 -Wall -pedantic           */
-/* g++ test_microtar.c -o TestMicroTar -lm -Wall -pedantic                    */
+/* gcc test_microtar.c -o TestMicroTar -lm -std=c89 -Wall -pedantic -D_GNU_SOURCE -lpthread */
+/* g++ test_microtar.c -o TestMicroTar -lm -Wall -pedantic -D_GNU_SOURCE -lpthread */
 
 #include <stdio.h>
 #include <string.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 
 #include "microtar.h"
+#include "microtar_fd.h"
 
 #define CHECK(test) \
     do { \
@@ -20,6 +23,91 @@
     } while (0)
 
 
+double seconds_since(const struct timespec *start) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) +
+    1e-9*(double)(now.tv_nsec - start->tv_nsec);
+}
+
+/* Write num_members of size member_size, and return the tar's bytes/s. */
+double write_throughput(
+  int use_fd,
+  const mtar_fd_options_t *opt,
+  uint64_t num_members,
+  uint64_t member_size) {
+  mtar_t tar;
+  struct timespec start;
+  uint64_t i;
+  double seconds;
+  char *payload = (char *)calloc(member_size, 1);
+  if (payload == NULL) {
+    return 0.0;
+  }
+  /* Truncating the previous run's tar would be timed too. */
+  remove("_test_throughput.tar");
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  if (use_fd) {
+    if (mtar_open_fd(&tar, "_test_throughput.tar", opt) != 0) {
+      return 0.0;
+    }
+  } else {
+    if (mtar_open(&tar, "_test_throughput.tar", "w") != 0) {
+      return 0.0;
+    }
+  }
+  for (i = 0; i < num_members; i++) {
+    if (mtar_write_file_header(&tar, "member.u8", member_size) != 0 ||
+        mtar_write_data(&tar, payload, member_size) != 0) {
+      return 0.0;
+    }
+  }
+  if (mtar_finalize(&tar) != 0) {
+    return 0.0;
+  }
+  seconds = seconds_since(&start);
+  mtar_close(&tar);
+  free(payload);
+  return (double)tar.pos/seconds;
+}
+
+
+/* Copies the FIFO at path to the file copy_path until it is closed. */
+typedef struct {
+  const char *path;
+  const char *copy_path;
+  int ok;
+} fifo_reader_t;
+
+void *read_fifo(void *arg) {
+  fifo_reader_t *r = (fifo_reader_t *)arg;
+  static char buf[64*1024];
+  FILE *copy;
+  ssize_t n;
+  const int fd = open(r->path, O_RDONLY);
+  r->ok = 0;
+  if (fd < 0) {
+    return NULL;
+  }
+  copy = fopen(r->copy_path, "wb");
+  if (copy == NULL) {
+    close(fd);
+    return NULL;
+  }
+  while ((n = read(fd, buf, sizeof(buf))) > 0) {
+    if (fwrite(buf, 1, (size_t)n, copy) != (size_t)n) {
+      break;
+    }
+  }
+  r->ok = n == 0;
+  if (fclose(copy) != 0) {
+    r->ok = 0;
+  }
+  close(fd);
+  return NULL;
+}
+
+
 int main() {
 
   /* open non existing file */
@@ -82,6 +170,311 @@ int main() {
     CHECK(mtar_close(&tar) == 0);
   }
 
+  /* Write file of unknown size */
+  {
+    mtar_t tar;
+    mtar_header_t header;
+    const char *str1 = "Hello ";
+    const char *str2 = "world";
+    const char *str3 = "Goodbye world";
+    char str_back[1024];
+
+    CHECK(mtar_open(&tar, "_test_unknown_size.tar", "w") == 0);
+    CHECK(mtar_begin_file(&tar, "test1.txt") == 0);
+    CHECK(mtar_append_data(&tar, str1, strlen(str1)) == 0);
+    CHECK(mtar_append_data(&tar, str2, strlen(str2)) == 0);
+    CHECK(mtar_end_file(&tar) == 0);
+    CHECK(mtar_write_file_header(&tar, "test2.txt", strlen(str3)) == 0);
+    CHECK(mtar_write_data(&tar, str3, strlen(str3)) == 0);
+    CHECK(mtar_finalize(&tar) == 0);
+    CHECK(mtar_close(&tar) == 0);
+
+    CHECK(mtar_open(&tar, "_test_unknown_size.tar", "r") == 0);
+    CHECK(mtar_read_header(&tar, &header) == 0);
+    CHECK(strncmp(header.name, "test1.txt", strlen("test1.txt")) == 0);
+    CHECK(header.size == strlen(str1) + strlen(str2));
+    CHECK(mtar_read_data(&tar, str_back, header.size) == 0);
+    str_back[header.size] = '\0';
+    CHECK(strncmp(str_back, "Hello world", 1024) == 0);
+
+    CHECK(mtar_next(&tar) == 0);
+    CHECK(mtar_read_header(&tar, &header) == 0);
+    CHECK(strncmp(header.name, "test2.txt", strlen("test2.txt")) == 0);
+    CHECK(header.size == strlen(str3));
+    CHECK(mtar_close(&tar) == 0);
+  }
+
+  /* Find index from the tail and jump to a member */
+  {
+    mtar_t tar;
+    mtar_header_t header;
+    mtar_index_t index;
+    uint64_t records[3][2];
+    uint64_t records_back[3][2];
+    char name[100];
+    char str_back[1024];
+    uint64_t i;
+
+    CHECK(mtar_open(&tar, "_test_index.tar", "w") == 0);
+    for (i = 0; i < 3; i++) {
+      sprintf(name, "%09d.txt", (int)i);
+      records[i][0] = tar.pos;
+      records[i][1] = 100 + 300*i;
+      CHECK(mtar_write_file_header(&tar, name, records[i][1]) == 0);
+      memset(str_back, 'a' + (int)i, records[i][1]);
+      CHECK(mtar_write_data(&tar, str_back, records[i][1]) == 0);
+      CHECK(tar.last_header == records[i][0]);
+      CHECK(tar.last_size == records[i][1]);
+    }
+    CHECK(mtar_write_index(&tar, "index.u8", records, 16, 3) == 0);
+    CHECK(tar.pos % 512 == 0);
+    CHECK(mtar_finalize(&tar) == 0);
+    CHECK(mtar_close(&tar) == 0);
+
+    CHECK(mtar_open(&tar, "_test_index.tar", "r") == 0);
+    CHECK(mtar_find_index(&tar, &index) == 0);
+    CHECK(index.record_size == 16);
+    CHECK(index.num_records == 3);
+    CHECK(mtar_read_index(&tar, &index, records_back) == 0);
+    CHECK(memcmp(records, records_back, sizeof(records)) == 0);
+
+    CHECK(mtar_seek_member(&tar, records_back[2][0], &header) == 0);
+    CHECK(strncmp(header.name, "000000002.txt", 100) == 0);
+    CHECK(header.size == records[2][1]);
+    CHECK(mtar_read_data(&tar, str_back, header.size) == 0);
+    CHECK(str_back[0] == 'c' && str_back[header.size - 1] == 'c');
+
+    CHECK(mtar_seek_member(&tar, records_back[0][0], &header) == 0);
+    CHECK(strncmp(header.name, "000000000.txt", 100) == 0);
+    CHECK(mtar_close(&tar) == 0);
+
+    /* a tar without index */
+    CHECK(mtar_open(&tar, "_test_two_files.tar", "r") == 0);
+    CHECK(mtar_find_index(&tar, &index) == MTAR_ENOTFOUND);
+    CHECK(mtar_close(&tar) == 0);
+  }
+
+  /* Sizes beyond the octal size-field, i.e. larger 8 Giga Byte */
+  {
+    mtar_header_t header, header_back;
+    _mtar_raw_header_t rh;
+    uint64_t sizes[4];
+    uint64_t i;
+    sizes[0] = MTAR_MAX_OCTAL_SIZE;
+    sizes[1] = MTAR_MAX_OCTAL_SIZE + 1;
+    sizes[2] = (uint64_t)3 << 40;
+    sizes[3] = ~(uint64_t)0;
+
+    for (i = 0; i < 4; i++) {
+      memset(&header, 0, sizeof(header));
+      strcpy(header.name, "000000001.cherenkov_bunches.Nx8_float32");
+      header.size = sizes[i];
+      CHECK(_mtar_header_to_raw(&rh, &header) == 0);
+      CHECK(((unsigned char)rh.size[0] == 0x80) == (i > 0));
+      CHECK(_mtar_raw_to_header(&header_back, &rh) == 0);
+      CHECK(header_back.size == sizes[i]);
+      CHECK(strcmp(header_back.name, header.name) == 0);
+    }
+    CHECK(rh.size[4] == (char)0xFF && rh.size[11] == (char)0xFF);
+
+    /* base-256 is big-endian */
+    header.size = sizes[2];
+    CHECK(_mtar_header_to_raw(&rh, &header) == 0);
+    CHECK(rh.size[6] == 3);
+    CHECK(rh.size[7] == 0 && rh.size[11] == 0);
+
+    /* negative base-256 */
+    rh.size[0] = (char)0xFF;
+    CHECK(_mtar_raw_to_header(&header_back, &rh) == MTAR_EBADCHKSUM);
+    snprintf(rh.checksum, sizeof(rh.checksum), "%06lo", _mtar_checksum(&rh));
+    CHECK(_mtar_raw_to_header(&header_back, &rh) == MTAR_EFAILURE);
+  }
+
+  /* fd-backend, small buffer to rewrite a header which was already flushed */
+  {
+    mtar_t tar;
+    mtar_header_t header;
+    mtar_fd_options_t opt;
+    mtar_index_t index;
+    uint64_t i, header_offset;
+    char buf[20000];
+    char back[20000];
+    int direct;
+
+    for (i = 0; i < sizeof(buf); i++) {
+      buf[i] = (char)(i % 251);
+    }
+    for (direct = 0; direct < 2; direct++) {
+      mtar_fd_options_init(&opt);
+      opt.buffer_size = 4096;
+      opt.direct = direct;
+      CHECK(mtar_open_fd(&tar, "_test_fd.tar", &opt) == 0);
+      CHECK(mtar_write_file_header(&tar, "a.txt", 11) == 0);
+      CHECK(mtar_write_data(&tar, "Hello world", 11) == 0);
+      header_offset = tar.pos;
+      CHECK(mtar_begin_file(&tar, "b.u8") == 0);
+      for (i = 0; i < 10; i++) {
+        CHECK(mtar_append_data(&tar, buf + 2000*i, 2000) == 0);
+      }
+      CHECK(mtar_end_file(&tar) == 0);
+      CHECK(mtar_write_file_header(&tar, "c.u8", sizeof(buf)) == 0);
+      CHECK(mtar_write_data(&tar, buf, sizeof(buf)) == 0);
+      CHECK(mtar_write_index(&tar, "index.u8", &header_offset, 8, 1) == 0);
+      CHECK(mtar_finalize(&tar) == 0);
+      CHECK(mtar_find(&tar, "a.txt", &header) != MTAR_ESUCCESS);
+      CHECK(mtar_close(&tar) == 0);
+
+      CHECK(mtar_open(&tar, "_test_fd.tar", "r") == 0);
+      CHECK(mtar_read_header(&tar, &header) == 0);
+      CHECK(strcmp(header.name, "a.txt") == 0);
+      CHECK(header.size == 11);
+      CHECK(mtar_find_index(&tar, &index) == 0);
+      CHECK(index.num_records == 1);
+      CHECK(mtar_seek_member(&tar, header_offset, &header) == 0);
+      CHECK(strcmp(header.name, "b.u8") == 0);
+      CHECK(header.size == sizeof(buf));
+      CHECK(mtar_read_data(&tar, back, sizeof(back)) == 0);
+      CHECK(memcmp(buf, back, sizeof(buf)) == 0);
+      CHECK(mtar_next(&tar) == 0);
+      CHECK(mtar_read_header(&tar, &header) == 0);
+      CHECK(strcmp(header.name, "c.u8") == 0);
+      CHECK(mtar_read_data(&tar, back, sizeof(back)) == 0);
+      CHECK(memcmp(buf, back, sizeof(buf)) == 0);
+      CHECK(mtar_close(&tar) == 0);
+    }
+  }
+
+  /* fd-backend on a FIFO, i.e. not seekable, read by a thread */
+  {
+    mtar_t tar;
+    mtar_header_t header;
+    mtar_fd_options_t opt;
+    _mtar_fd_stream_t *s;
+    fifo_reader_t reader;
+    pthread_t thread;
+    uint64_t i, num_writes;
+    char name[32];
+    char small[100];
+    static char large[1024*1024];
+    static char back[1024*1024];
+
+    for (i = 0; i < sizeof(large); i++) {
+      large[i] = (char)(i % 251);
+    }
+    remove("_test_fd.fifo");
+    CHECK(mkfifo("_test_fd.fifo", 0600) == 0);
+    reader.path = "_test_fd.fifo";
+    reader.copy_path = "_test_fd_fifo.tar";
+    CHECK(pthread_create(&thread, NULL, read_fifo, &reader) == 0);
+
+    mtar_fd_options_init(&opt);
+    opt.buffer_size = 64*1024;
+    CHECK(mtar_open_fd(&tar, "_test_fd.fifo", &opt) == 0);
+    s = (_mtar_fd_stream_t *)tar.stream;
+    CHECK(!s->seekable);
+    CHECK(!s->preallocate);
+
+    /* many small members are copied, and written in whole buffers */
+    for (i = 0; i < 1000; i++) {
+      sprintf(name, "%09d.u8", (int)i);
+      memset(small, (int)(i % 251), sizeof(small));
+      CHECK(mtar_write_file_header(&tar, name, sizeof(small)) == 0);
+      CHECK(mtar_write_data(&tar, small, sizeof(small)) == 0);
+    }
+    CHECK(s->num_writes <= 1000*1024/(64*1024 - 4096) + 1);
+
+    /* a large member's header and payload go out in one system-call */
+    num_writes = s->num_writes;
+    CHECK(mtar_write_file_header(&tar, "large.u8", sizeof(large)) == 0);
+    CHECK(s->num_writes == num_writes);
+    CHECK(mtar_write_data(&tar, large, sizeof(large)) == 0);
+    CHECK(s->num_writes == num_writes + 1);
+
+    CHECK(mtar_finalize(&tar) == 0);
+    CHECK(mtar_close(&tar) == 0);
+    CHECK(pthread_join(thread, NULL) == 0);
+    CHECK(reader.ok);
+    remove("_test_fd.fifo");
+
+    CHECK(mtar_open(&tar, "_test_fd_fifo.tar", "r") == 0);
+    for (i = 0; i < 1000; i++) {
+      sprintf(name, "%09d.u8", (int)i);
+      CHECK(mtar_read_header(&tar, &header) == 0);
+      CHECK(strcmp(header.name, name) == 0);
+      CHECK(header.size == sizeof(small));
+      CHECK(mtar_read_data(&tar, back, sizeof(small)) == 0);
+      memset(small, (int)(i % 251), sizeof(small));
+      CHECK(memcmp(back, small, sizeof(small)) == 0);
+      CHECK(mtar_next(&tar) == 0);
+    }
+    CHECK(mtar_read_header(&tar, &header) == 0);
+    CHECK(strcmp(header.name, "large.u8") == 0);
+    CHECK(header.size == sizeof(large));
+    CHECK(mtar_read_data(&tar, back, sizeof(large)) == 0);
+    CHECK(memcmp(back, large, sizeof(large)) == 0);
+    CHECK(mtar_next(&tar) == 0);
+    CHECK(mtar_read_header(&tar, &header) != 0);
+    CHECK(mtar_close(&tar) == 0);
+  }
+
+  /* fd-backend preallocates ahead of members of known size */
+  {
+    mtar_t tar;
+    mtar_fd_options_t opt;
+    _mtar_fd_stream_t *s;
+    struct stat st;
+    char buf[5000];
+
+    memset(buf, 'x', sizeof(buf));
+    mtar_fd_options_init(&opt);
+    opt.buffer_size = 4096;
+    CHECK(mtar_open_fd(&tar, "_test_fd_preallocate.tar", &opt) == 0);
+    s = (_mtar_fd_stream_t *)tar.stream;
+    CHECK(mtar_write_file_header(&tar, "a.u8", sizeof(buf)) == 0);
+#ifdef __linux__
+    /* Unless the filesystem does not support fallocate(2). */
+    if (s->preallocate) {
+      CHECK(s->allocated == 2*4096);
+      CHECK(stat("_test_fd_preallocate.tar", &st) == 0);
+      CHECK(st.st_size == 2*4096);
+    }
+#endif
+    CHECK(mtar_write_data(&tar, buf, sizeof(buf)) == 0);
+    CHECK(mtar_finalize(&tar) == 0);
+    CHECK(mtar_close(&tar) == 0);
+    CHECK(stat("_test_fd_preallocate.tar", &st) == 0);
+    CHECK((uint64_t)st.st_size == tar.pos);
+  }
+
+  /* throughput of many small members, i.e. padding, and of large members */
+  {
+    mtar_fd_options_t opt;
+    double stdio_small = 0.0, fd_small = 0.0;
+    double stdio_large = 0.0, fd_large = 0.0;
+    int i;
+    mtar_fd_options_init(&opt);
+    for (i = 0; i < 5; i++) {
+      double s = write_throughput(0, NULL, 100*1000, 100);
+      double f = write_throughput(1, &opt, 100*1000, 100);
+      stdio_small = s > stdio_small ? s : stdio_small;
+      fd_small = f > fd_small ? f : fd_small;
+      s = write_throughput(0, NULL, 16, 16*1024*1024);
+      f = write_throughput(1, &opt, 16, 16*1024*1024);
+      stdio_large = s > stdio_large ? s : stdio_large;
+      fd_large = f > fd_large ? f : fd_large;
+    }
+    fprintf(
+      stdout,
+      "write throughput: stdio small %.0f MB/s, fd small %.0f MB/s, "
+      "stdio large %.0f MB/s, fd large %.0f MB/s\n",
+      1e-6*stdio_small, 1e-6*fd_small, 1e-6*stdio_large, 1e-6*fd_large);
+    /* stdio writes every 4096 bytes, fd only every buffer_size. */
+    CHECK(fd_small >= stdio_small);
+    /* Both copy a large payload once into the page-cache, with one
+     * system-call for fd and two for stdio. Only noise is between them. */
+    CHECK(fd_large >= 0.75*stdio_large);
+  }
+
   /* Write from file larger 4 Giga Byte  a.k.a. 32bit limit */
   {
     uint64_t hans = 1337;
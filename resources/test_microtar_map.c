@@ -0,0 +1,194 @@
+/* gcc test_microtar_map.c -o TestMicroTarMap -D_GNU_SOURCE -lpthread -O2    */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "microtar_map.h"
+
+#define CHECK(test) \
+    do { \
+        if ( !(test) ) { \
+            printf("In %s, line %d\n", __FILE__, __LINE__); \
+            printf("Expected true\n"); \
+            return EXIT_FAILURE; \
+        } \
+    } while (0)
+
+#define NUM_MEMBERS 64
+
+/* Member i has size 1000*i + 7 and is filled with the byte i. */
+int write_example_tar(const char *path, uint64_t *headers) {
+  mtar_t tar;
+  char name[100];
+  char *payload;
+  uint64_t i, size;
+  payload = (char *)malloc(1000*NUM_MEMBERS + 7);
+  if (payload == NULL) {
+    return 0;
+  }
+  if (mtar_open(&tar, path, "w") != MTAR_ESUCCESS) {
+    return 0;
+  }
+  for (i = 0; i < NUM_MEMBERS; i++) {
+    size = 1000*i + 7;
+    sprintf(name, "%09d.u8", (int)i);
+    memset(payload, (int)i, size);
+    headers[i] = tar.pos;
+    if (mtar_write_file_header(&tar, name, size) != MTAR_ESUCCESS ||
+        mtar_write_data(&tar, payload, size) != MTAR_ESUCCESS) {
+      return 0;
+    }
+  }
+  if (mtar_write_index(&tar, "index.u8", headers, 8, NUM_MEMBERS) ||
+      mtar_finalize(&tar) || mtar_close(&tar)) {
+    return 0;
+  }
+  free(payload);
+  return 1;
+}
+
+struct checksums {
+  uint64_t sums[NUM_MEMBERS];
+};
+
+/* Each member is visited by one thread only, so the slots do not race. */
+int64_t sum_member(
+  const mtar_map_t *map,
+  const mtar_member_t *member,
+  void *arg) {
+  struct checksums *c = (struct checksums *)arg;
+  uint64_t i, sum = 0;
+  const unsigned char *data = (const unsigned char *)member->data;
+  unsigned char *buf = NULL;
+  int slot;
+  if (data == NULL) {
+    buf = (unsigned char *)malloc(member->header.size);
+    if (buf == NULL) {
+      return MTAR_EFAILURE;
+    }
+    if (mtar_map_read(map, member->data_offset, buf, member->header.size)) {
+      free(buf);
+      return MTAR_EREADFAIL;
+    }
+    data = buf;
+  }
+  for (i = 0; i < member->header.size; i++) {
+    sum += data[i];
+  }
+  free(buf);
+  slot = atoi(member->header.name);
+  c->sums[slot] = sum;
+  return MTAR_ESUCCESS;
+}
+
+int64_t fail_on_member_3(
+  const mtar_map_t *map,
+  const mtar_member_t *member,
+  void *arg) {
+  return atoi(member->header.name) == 3 ? MTAR_EFAILURE : MTAR_ESUCCESS;
+}
+
+
+int main() {
+  uint64_t headers[NUM_MEMBERS];
+  int use_mmap;
+
+  CHECK(write_example_tar("_test_map.tar", headers));
+
+  /* open non existing file */
+  {
+    mtar_map_t map;
+    CHECK(mtar_map_open(&map, "_does_not_exist.tar", 1) == MTAR_EOPENFAIL);
+  }
+
+  for (use_mmap = 0; use_mmap < 2; use_mmap++) {
+    mtar_map_t map;
+    mtar_member_t member;
+    mtar_index_t index;
+    uint64_t *listed = NULL;
+    uint64_t num_listed = 0;
+    uint64_t i, next;
+    struct checksums c;
+
+    CHECK(mtar_map_open(&map, "_test_map.tar", use_mmap) == 0);
+    CHECK((map.data != NULL) == use_mmap);
+
+    /* walk headers */
+    CHECK(mtar_map_list(&map, &listed, &num_listed) == 0);
+    CHECK(num_listed == NUM_MEMBERS + 1);
+    for (i = 0; i < NUM_MEMBERS; i++) {
+      CHECK(listed[i] == headers[i]);
+    }
+
+    /* jump to a member, payload is not copied when mapped */
+    CHECK(mtar_map_member(&map, headers[5], &member, &next) == 0);
+    CHECK(strcmp(member.header.name, "000000005.u8") == 0);
+    CHECK(member.header.size == 5007);
+    CHECK(next == headers[6]);
+    if (use_mmap) {
+      CHECK(member.data == map.data + headers[5] + 512);
+      CHECK(member.data[0] == 5 && member.data[5006] == 5);
+    } else {
+      CHECK(member.data == NULL);
+    }
+
+    /* index from the tail */
+    CHECK(mtar_map_find_index(&map, &index, &member) == 0);
+    CHECK(index.num_records == NUM_MEMBERS);
+    CHECK(index.record_size == 8);
+    CHECK(index.header == listed[NUM_MEMBERS]);
+
+    /* concurrent readers */
+    memset(&c, 0, sizeof(c));
+    CHECK(mtar_map_for_each(&map, listed, NUM_MEMBERS, 8, sum_member, &c) ==
+      0);
+    for (i = 0; i < NUM_MEMBERS; i++) {
+      CHECK(c.sums[i] == i*(1000*i + 7));
+    }
+    CHECK(
+      mtar_map_for_each(&map, listed, NUM_MEMBERS, 4, fail_on_member_3, NULL)
+      == MTAR_EFAILURE);
+
+    free(listed);
+    CHECK(mtar_map_close(&map) == 0);
+  }
+
+  /* throughput of concurrent readers */
+  {
+    mtar_map_t map;
+    mtar_t tar;
+    struct timespec start, stop;
+    uint64_t i, size = 16*1024*1024;
+    uint64_t big_headers[32];
+    struct checksums c;
+    char name[100];
+    char *payload = (char *)calloc(size, 1);
+    double seconds;
+    CHECK(payload != NULL);
+    CHECK(mtar_open(&tar, "_test_map_big.tar", "w") == 0);
+    for (i = 0; i < 32; i++) {
+      sprintf(name, "%09d.u8", (int)i);
+      big_headers[i] = tar.pos;
+      CHECK(mtar_write_file_header(&tar, name, size) == 0);
+      CHECK(mtar_write_data(&tar, payload, size) == 0);
+    }
+    CHECK(mtar_finalize(&tar) == 0);
+    CHECK(mtar_close(&tar) == 0);
+    free(payload);
+
+    CHECK(mtar_map_open(&map, "_test_map_big.tar", 1) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    CHECK(mtar_map_for_each(&map, big_headers, 32, 8, sum_member, &c) == 0);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    seconds = (double)(stop.tv_sec - start.tv_sec) +
+      1e-9*(double)(stop.tv_nsec - start.tv_nsec);
+    fprintf(
+      stdout,
+      "mtar_map_for_each: %.2f GB/s\n",
+      1e-9*(double)(32*size)/seconds);
+    CHECK(mtar_map_close(&map) == 0);
+  }
+  return 0;
+}